@@ -775,6 +775,13 @@ namespace dfx
 
 	bool AsioMgr::Start()
 	{
+		AsioHandle* handle = (AsioHandle*)stream.apiHandle;
+
+		if (handle)
+		{
+			ResetEvent(handle->stopRequest); // Forget any stale requests
+		}
+
 		lastResult = ASIOStart();
 
 		if (lastResult == ASE_OK)
@@ -826,6 +833,10 @@ namespace dfx
 			return;
 		}
 
+		// Let any stop in progress finish first
+
+		EndStopper();
+
 		if (stream.state == StreamState::RUNNING) 
 		{
 			stream.state = StreamState::STOPPED;
@@ -841,6 +852,7 @@ namespace dfx
 		if (handle) 
 		{
 			CloseHandle(handle->condition);
+			CloseHandle(handle->stopRequest);
 
 			// @@ NO! handle->bufferInfos has already been
 			// deallocated. Do NOT do that here!
@@ -888,6 +900,7 @@ namespace dfx
 		handle->drainCounter = 0;
 		handle->internalDrain = false;
 		ResetEvent(handle->condition);
+		ResetEvent(handle->stopRequest);
 
 		stream.state = StreamState::RUNNING;
 		asioXRun = false;
@@ -937,6 +950,8 @@ namespace dfx
 		//if (result == ASE_OK) return;
 		//error(RtAudioError::SYSTEM_ERROR);
 
+		NotifyStateChange(); // Wake up anyone waiting for the stop
+
 		return;
 	}
 
@@ -959,30 +974,56 @@ namespace dfx
 		stopStream();
 	}
 
-	// This function will be called by a spawned thread when the user
+	// This is the body of the stopper thread. It sleeps until the user
 	// callback function signals that the stream should be stopped or
-	// aborted.  It is necessary to handle it this way because the
-	// callbackEvent() function must return before the ASIOStop()
-	// function will return. And that of course causes other issues
-	// as outline below where we must detach the thread after stopping
-	// the stream.
+	// aborted, then stops it. It is necessary to handle it this way
+	// because the callbackEvent() function must return before the
+	// ASIOStop() function will return. The thread is made once, when
+	// the stream is opened, rather than spawned from the callback.
 
-	static unsigned __stdcall asioStopStream(void* ptr)
+	static void asioStopper(CallbackInfo* info)
 	{
-		CallbackInfo* info = (CallbackInfo*)ptr;
 		auto object = (AsioMgr*)info->object;
+		auto handle = (AsioHandle*)object->stream.apiHandle;
+
+		while (true)
+		{
+			WaitForSingleObject(handle->stopRequest, INFINITE);
 
-		object->stopStream();
+			if (handle->quitStopper) break;
 
-		// Let the thread run die on its own. We have to 
-		// do this, because it must live longer than this
-		// function (asioStopStream) since in fact the thread
-		// is the one that called this function. So if we 
-		// don't detach, amusement ensues.
+			object->stopStream();
+		}
+	}
 
-		info->thread.detach();
+	void AsioMgr::StartStopper()
+	{
+		AsioHandle* handle = (AsioHandle*)stream.apiHandle;
 
-		return 0;
+		handle->quitStopper = false;
+		stream.callbackInfo.thread = std::thread(asioStopper, &stream.callbackInfo);
+	}
+
+	void AsioMgr::EndStopper()
+	{
+		AsioHandle* handle = (AsioHandle*)stream.apiHandle;
+
+		if (handle && stream.callbackInfo.thread.joinable())
+		{
+			handle->quitStopper = true;
+			SetEvent(handle->stopRequest);
+			stream.callbackInfo.thread.join();
+		}
+	}
+
+	void AsioMgr::RequestStop()
+	{
+		AsioHandle* handle = (AsioHandle*)stream.apiHandle;
+
+		if (handle)
+		{
+			SetEvent(handle->stopRequest);
+		}
 	}
 
 
@@ -1058,7 +1099,13 @@ namespace dfx
 				// Reset the driver is done by completely destruct is. I.e. ASIOStop(), ASIODisposeBuffers(), Destruction
 				// Afterwards you initialize the driver again.
 
-				driverData.stopped;  // In this sample the processing will just stop
+				// Here, we just stop, and whoever's waiting on the stream finds out.
+
+				if (asioCallbackInfo)
+				{
+					((AsioMgr*)asioCallbackInfo->object)->RequestStop();
+				}
+
 				ret = 1L;
 				break;
 			}
@@ -1276,6 +1323,7 @@ namespace dfx
 		{
 			auto handle = reinterpret_cast<AsioHandle*>(stream.apiHandle);
 
+			EndStopper();
 			delete handle;
 			handle = new AsioHandle;
 
@@ -1283,6 +1331,20 @@ namespace dfx
 			{
 				handle->bufferInfos = driverData.bufferInfos;
 
+				// Gather up the output channel buffers, so the callback can
+				// fan the user channels straight out to them.
+
+				for (long i = 0; i < driverData.nInputBuffers + driverData.nOutputBuffers; i++)
+				{
+					auto& bi = driverData.bufferInfos[i];
+
+					if (bi.isInput != ASIOTrue)
+					{
+						handle->playBuffers[0].push_back(static_cast<char*>(bi.buffers[0]));
+						handle->playBuffers[1].push_back(static_cast<char*>(bi.buffers[1]));
+					}
+				}
+
 				handle->condition = CreateEvent(
 					nullptr, // no security
 					TRUE,    // manual reset
@@ -1290,7 +1352,16 @@ namespace dfx
 					nullptr  // unnamed
 				);
 
+				handle->stopRequest = CreateEvent(
+					nullptr, // no security
+					FALSE,   // auto reset
+					FALSE,   // non-signaled initially
+					nullptr  // unnamed
+				);
+
 				stream.apiHandle = handle;
+
+				StartStopper();
 			}
 			else b = false;
 		}
@@ -1325,16 +1396,10 @@ namespace dfx
 			}
 			else 
 			{ 
-				// This function will be called by a spawned thread when the user
-				// callback function signals that the stream should be stopped or
-				// aborted.  It is necessary to handle it this way because the
-				// callbackEvent() function must return before the ASIOStop()
-				// function will return.
-
-				// We spawn a thread and move it into the CallbackInfo structure.
-				// That way it hangs around long enough to do its thing.
+				// The callback must return before ASIOStop() will, so have
+				// the stopper thread do it.
 
-				info->thread = std::thread([&]{ this->stopStream(); }); // @@ Note: move assigned.
+				RequestStop();
 			}
 			return true;
 		}
@@ -1424,10 +1489,15 @@ namespace dfx
 		// Invoke user callback to get fresh output data UNLESS we are draining stream.
 		// //////////////////////////////////////////////////////////////////////////////
 
+		// With a sink callback, the output goes straight into the device buffers
+
+		bool wroteDevice = false;
+
 		if (handle->drainCounter == 0) 
 		{
 			//RtAudioCallback callback = (RtAudioCallback)info->callback;
 			auto callback = reinterpret_cast<CallbackPtr>(info->callback);
+			auto sinkCallback = reinterpret_cast<SinkCallbackPtr>(info->sinkCallback);
 
 			double streamTime = getStreamTime();
 			auto status = StreamIO_Good;
@@ -1444,23 +1514,31 @@ namespace dfx
 				asioXRun = false;
 			}
 
-			int cbReturnValue = callback(stream.userPlayBuffer, stream.userRecBuffer, stream.bufferSize, streamTime, status, info->userData);
+			int cbReturnValue;
+
+			if (sinkCallback)
+			{
+				PlaySink sink;
+				sink.channels = handle->playBuffers[bufferIndex].data();
+				sink.nChannels = static_cast<unsigned>(handle->playBuffers[bufferIndex].size());
+				sink.nFrames = stream.bufferSize;
+				sink.format = stream.devPlayFormat;
+				sink.swapBytes = stream.swapPlayBytes;
+
+				cbReturnValue = sinkCallback(sink, stream.userRecBuffer, stream.bufferSize, streamTime, status, info->userData);
+				wroteDevice = true;
+			}
+			else cbReturnValue = callback(stream.userPlayBuffer, stream.userRecBuffer, stream.bufferSize, streamTime, status, info->userData);
 
 			if (cbReturnValue == 2) 
 			{
 				stream.state = StreamState::STOPPING;
 				handle->drainCounter = 2;
 
-				// This function will be called by a spawned thread when the user
-				// callback function signals that the stream should be stopped or
-				// aborted.  It is necessary to handle it this way because the
-				// callbackEvent() function must return before the ASIOStop()
-				// function will return.
-
-				// We spawn a thread and move it into the CallbackInfo structure.
-				// That way it hangs around long enough to do its thing.
+				// The callback must return before ASIOStop() will, so have
+				// the stopper thread do it.
 
-				info->thread = std::thread([&] { asioStopStream(&stream.callbackInfo); }); // @@ Note: move assigned.
+				RequestStop();
 
 			}
 			else if (cbReturnValue == 1) 
@@ -1494,41 +1572,16 @@ namespace dfx
 				}
 
 			}
+			else if (wroteDevice)
+			{
+				// The sink callback already put it there
+			}
 			else if (stream.doConvertPlayBuffer) 
 			{
-#if 0
-				// This currently assumes interleaving in the internal user buffer channels, and de-interleaves them
-				convertBufferX(stream, stream.devPlayBuffer, stream.userPlayBuffer, stream.convertPlayInfo);
-#else
-				// Converts without changing the interleaving
-				convertBuffer(stream, stream.devPlayBuffer, stream.userPlayBuffer, stream.convertPlayInfo);
-#endif
+				// Fans the interleaved user channels straight out to the asio
+				// channel buffers, converting and swapping bytes on the way.
 
-#if 0
-				if (stream.swapPlayBytes)
-				{
-					byteSwapBuffer(stream.devPlayFormat, stream.devPlayBuffer, stream.bufferSize * stream.nDevPlayChannels);
-				}
-#endif
-
-				// Assumes interleaved here, so de-interleave. Also swap bytes if needed.
-
-				for (unsigned c = 0, rel_c = 0; c < nChannels; c++) 
-				{
-					auto &cbi = handle->bufferInfos[c];
-
-					if (cbi.isInput != ASIOTrue)
-					{
-						auto pChannelBytes = cbi.buffers[bufferIndex];
-#if 0
-						// This assumes already de-interleaved, and just moves to the asio buffer
-						memcpy(pChannelBytes, &stream.devPlayBuffer[nBytesPerChannel * rel_c++], nBytesPerChannel);
-#else
-						// Swaps bytes too if necessary
-						DeInterleaveChannel(stream.devPlayFormat, stream.devPlayBuffer, pChannelBytes, rel_c++, stream.nDevPlayChannels, stream.bufferSize, stream.swapPlayBytes);
-#endif
-					}
-				}
+				convertBufferX(stream, handle->playBuffers[bufferIndex].data(), stream.userPlayBuffer, stream.convertPlayInfo, stream.swapPlayBytes);
 			}
 			else 
 			{
@@ -1592,6 +1645,13 @@ namespace dfx
 	void AsioMgr::ConfigureUserCallback(CallbackPtr userCallback)
 	{
 		stream.callbackInfo.callback = userCallback;
+		stream.callbackInfo.sinkCallback = nullptr;
+	}
+
+	void AsioMgr::ConfigureSinkCallback(SinkCallbackPtr sinkCallback)
+	{
+		stream.callbackInfo.sinkCallback = sinkCallback;
+		stream.callbackInfo.callback = nullptr;
 	}
 
 	unsigned long AsioMgr::SysRefTime()
@@ -69,9 +69,12 @@ namespace dfx
 		int drainCounter;            // Tracks callback counts when draining
 		bool internalDrain;          // Indicates if stop is initiated from callback or not.
 		ASIOBufferInfo* bufferInfos; // This struct does *not* own these
+		std::vector<char*> playBuffers[2]; // The output channel buffers, for each half
 		HANDLE condition;
+		HANDLE stopRequest;          // Auto reset. Set to wake up the stopper thread
+		bool quitStopper;            // Tells the stopper thread to finish up
 
-		AsioHandle() : drainCounter{}, internalDrain{}, bufferInfos{}, condition{}
+		AsioHandle() : drainCounter{}, internalDrain{}, bufferInfos{}, playBuffers{}, condition{}, stopRequest{}, quitStopper{}
 		{
 		}
 	};
@@ -194,6 +197,7 @@ namespace dfx
 		virtual bool Stopped();
 
 		virtual void ConfigureUserCallback(CallbackPtr userCallback);
+		virtual void ConfigureSinkCallback(SinkCallbackPtr sinkCallback);
 
 		virtual bool Open(long nInputChannels_, long nOutputChannels_, long bufferSize_, unsigned sampleRate_, void *userData_, bool verbose);
 		virtual bool Close();
@@ -207,6 +211,15 @@ namespace dfx
 
 		bool PopupControlPanel();
 
+		// The callback can't stop the stream itself, (ASIOStop() won't return
+		// until the callback does), so a stopper thread, started when the
+		// stream is opened, waits to do it. RequestStop() just sets an event,
+		// so it's safe to call from the audio thread.
+
+		void StartStopper();
+		void EndStopper();
+		void RequestStop();
+
 		// ///
 		// Our low level call backs
 		static void bufferSwitch(long index, long processNow);
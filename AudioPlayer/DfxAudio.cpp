@@ -154,9 +154,32 @@ namespace dfx
     {
         // should be overidden
         stream.state = StreamState::STOPPED;
+        NotifyStateChange();
         return true;
     }
 
+    bool DfxAudio::WaitForStop(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(stream.mutex);
+
+        return stream.stateChanged.wait_for(lock, timeout, [this]
+        {
+            return Stopped() || stream.state == StreamState::CLOSED;
+        });
+    }
+
+    void DfxAudio::NotifyStateChange()
+    {
+        // Taking the lock, even briefly, keeps a waiter from missing
+        // the state change between its check and its wait.
+
+        {
+            std::lock_guard<std::mutex> lock(stream.mutex);
+        }
+
+        stream.stateChanged.notify_all();
+    }
+
     void DfxAudio::verifyStream()
     {
         if (stream.state == StreamState::CLOSED)
@@ -184,6 +207,7 @@ namespace dfx
 
         //stream_.mode = UNINITIALIZED;
         stream.state = StreamState::CLOSED;
+        NotifyStateChange();
     }
 
     void DfxAudio::abortStream()
@@ -623,479 +647,31 @@ namespace dfx
         convertBuffer(info.outFormat, outBuffer, outStride, info.inFormat, inBuffer, inStride, nSamples, nChannels);
     }
 
-#if 0
-    void convertBufferX(DfxStream& stream, char* outBuffer, char* inBuffer, ConvertInfo& info)
+    void convertBufferX(DfxStream& stream, char** outChannels, char* inBuffer, ConvertInfo& info, bool swapBytes)
     {
-        // This function does format conversion, input/output channel compensation, and
-        // data interleaving/deinterleaving.
+        // This function fans interleaved user channels out to separate (non-interleaved)
+        // device channel buffers, doing format conversion and byte swapping on the way.
+        // It's a single pass over the samples, with no intermediate device buffer. So
+        // however many output buses the user renders, there are no extra copies.
+        // Set up info with cfgPlayConvertInfo(), which gives the offset of each channel
+        // in the user buffer (inOffset), and the user frame size (inJump).
 
         const unsigned nSamples = stream.bufferSize;
-        const int nChannels = info.nChannels;
         const int inStride = info.inJump;
-        const int outStride = info.outJump;
-
-        // The code below is very similar to that in the SampleUtil / convertBuffer() routine.
-        // All that's different is that you can start from some channel other than the first.
-        // That's what the offset stuff is all about.
+        const unsigned inBytes = nBytes(info.inFormat);
 
-        switch (info.outFormat)
+        for (int c = 0; c < info.nChannels; c++)
         {
-            case SampleFormat::SINT16:
-            {
-                auto* out = (int16_t*)outBuffer;
-
-                switch (info.inFormat)
-                {
-                    case SampleFormat::SINT16:
-                    {
-                        // Channel compensation and/or (de)interleaving only.
-                        auto in = (int16_t*)inBuffer;
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                out[info.outOffset[j]] = in[info.inOffset[j]];
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::SINT24:
-                    {
-                        auto in = (int24_t*)inBuffer;
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                //out[info.outOffset[j]] = (int16_t)(in[info.inOffset[j]].asInt() >> 8); // If 24-bit data is in lower three bytes of int32_t
-                                out[info.outOffset[j]] = (int16_t)(in[info.inOffset[j]].asInt() >> 16); // If 24-bit data is in upper three bytes of int32_t
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::SINT32:
-                    {
-                        auto in = (int32_t*)inBuffer;
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                out[info.outOffset[j]] = (int16_t)((in[info.inOffset[j]] >> 16) & 0x0000ffff);
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::FLOAT32:
-                    {
-                        auto in = (float*)inBuffer;
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                out[info.outOffset[j]] = (int16_t)(in[info.inOffset[j]] * 32767.5 - 0.5);
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::FLOAT64:
-                    {
-                        auto in = (double*)inBuffer;
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++) {
-                                out[info.outOffset[j]] = (int16_t)(in[info.inOffset[j]] * 32767.5 - 0.5);
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                }
-            }
-            break;
-
-            case SampleFormat::SINT24:
-            {
-                auto out = (int24_t*)outBuffer;
-
-                switch (info.inFormat)
-                {
-                    case SampleFormat::SINT16:
-                    {
-                        auto in = (int16_t*)inBuffer;
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                out[info.outOffset[j]] = (int32_t)(in[info.inOffset[j]] << 8);
-                                //out[info.outOffset[j]] <<= 8;
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::SINT24:
-                    {
-                        // Channel compensation and/or (de)interleaving only.
-                        auto in = (int24_t*)inBuffer;
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++) {
-                                out[info.outOffset[j]] = in[info.inOffset[j]];
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::SINT32:
-                    {
-                        auto in = (int32_t*)inBuffer;
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                out[info.outOffset[j]] = (int32_t)(in[info.inOffset[j]] >> 8);
-                                //out[info.outOffset[j]] >>= 8;
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::FLOAT32:
-                    {
-                        auto in = (float*)inBuffer;
-                        for (unsigned i = 0; i < nSamples; i++) {
-                            for (int j = 0; j < nChannels; j++) {
-                                out[info.outOffset[j]] = (int32_t)(in[info.inOffset[j]] * 8388607.5 - 0.5);
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::FLOAT64:
-                    {
-                        auto in = (double*)inBuffer;
-                        for (unsigned i = 0; i < nSamples; i++) {
-                            for (int j = 0; j < nChannels; j++) {
-                                out[info.outOffset[j]] = (int32_t)(in[info.inOffset[j]] * 8388607.5 - 0.5);
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                }
-            }
-            break;
-
-            case SampleFormat::SINT32:
-            {
-                auto out = (int32_t*)outBuffer;
-
-                switch (info.inFormat)
-                {
-
-                    case SampleFormat::SINT16:
-                    {
-                        auto in = (int16_t*)inBuffer;
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                auto& d = out[info.outOffset[j]];
-                                d = (int32_t)in[info.inOffset[j]];
-                                d <<= 16;
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::SINT24:
-                    {
-                        auto in = (int24_t*)inBuffer;
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                auto& d = out[info.outOffset[j]];
-                                d = (int32_t)in[info.inOffset[j]].asInt();
-                                //d <<= 8; If 24-bit data is in lower three bytes of int32_t.
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::SINT32:
-                    {
-                        // Channel compensation and/or (de)interleaving only.
-                        auto in = (int32_t*)inBuffer;
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                out[info.outOffset[j]] = in[info.inOffset[j]];
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::FLOAT32:
-                    {
-                        auto in = (float*)inBuffer;
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                out[info.outOffset[j]] = (int32_t)(in[info.inOffset[j]] * 2147483647.5 - 0.5);
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::FLOAT64:
-                    {
-                        auto in = (double*)inBuffer;
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                out[info.outOffset[j]] = (int32_t)(in[info.inOffset[j]] * 2147483647.5 - 0.5);
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                }
-            }
-            break;
+            auto out = outChannels[c];
+            auto in = inBuffer + info.inOffset[c] * inBytes;
 
-            case SampleFormat::FLOAT32:
-            {
-                float scale;
-                auto out = (float*)outBuffer;
-
-                switch (info.inFormat)
-                {
-
-                    case SampleFormat::SINT16:
-                    {
-                        auto in = (int16_t*)inBuffer;
-                        scale = (float)(1.0 / 32767.5);
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                auto& d = out[info.outOffset[j]];
-                                d = (float)in[info.inOffset[j]];
-                                d += 0.5f; // @@ BRY
-                                d *= scale;
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::SINT24:
-                    {
-                        auto in = (int24_t*)inBuffer;
-                        //scale = (float)(1.0 / 8388607.5);  // If 24-bit data is in lower three bytes of int32_t.
-                        scale = (float)(1.0 / 2147483647.5); // If 24-bit data is in upper three bytes of int32_t.
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                auto& d = out[info.outOffset[j]];
-                                d = in[info.inOffset[j]].asFloat(); // @@ asFloat has subtle casting
-                                d += 0.5f; // @@ BRY
-                                d *= scale;
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::SINT32:
-                    {
-                        auto in = (int32_t*)inBuffer;
-                        scale = (float)(1.0 / 2147483647.5);
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                auto& d = out[info.outOffset[j]];
-                                d = (float)in[info.inOffset[j]];
-                                d += 0.5f; // @@ BRY
-                                d *= scale;
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::FLOAT32:
-                    {
-                        // Channel compensation and/or (de)interleaving only.
-                        auto in = (float*)inBuffer;
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                out[info.outOffset[j]] = in[info.inOffset[j]];
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::FLOAT64:
-                    {
-                        auto in = (double*)inBuffer;
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                out[info.outOffset[j]] = (float)in[info.inOffset[j]];
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                }
-            }
-            break;
+            convertBuffer(info.outFormat, out, 1, info.inFormat, in, inStride, nSamples, 1);
 
-            case SampleFormat::FLOAT64:
+            if (swapBytes)
             {
-                double scale;
-                auto* out = (double*)outBuffer;
-
-                switch (info.inFormat)
-                {
-                    case SampleFormat::SINT16:
-                    {
-                        auto in = (int16_t*)inBuffer;
-                        scale = 1.0 / 32767.5;
-
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                auto& d = out[info.outOffset[j]];
-                                d = (double)in[info.inOffset[j]];
-                                d += 0.5;
-                                d *= scale;
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::SINT24:
-                    {
-                        auto in = (int24_t*)inBuffer;
-                        //scale = 1.0 / 8388607.5;  // If 24-bit data is in lower three bytes of int32_t
-                        scale = 1.0 / 2147483647.5; // If 24-bit data is in upper three bytes of int32_t
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                auto& d = out[info.outOffset[j]];
-                                d = double(in[info.inOffset[j]].asInt());
-                                d += 0.5;
-                                d *= scale;
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::SINT32:
-                    {
-                        auto in = (int32_t*)inBuffer;
-                        scale = 1.0 / 2147483647.5;
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                auto& d = out[info.outOffset[j]];
-                                d = (double)in[info.inOffset[j]];
-                                d += 0.5;
-                                d *= scale;
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::FLOAT32:
-                    {
-                        auto in = (float*)inBuffer;
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                out[info.outOffset[j]] = (double)in[info.inOffset[j]];
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-
-                    case SampleFormat::FLOAT64:
-                    {
-                        // Channel compensation and/or (de)interleaving only.
-                        auto in = (double*)inBuffer;
-                        for (unsigned i = 0; i < nSamples; i++)
-                        {
-                            for (int j = 0; j < nChannels; j++)
-                            {
-                                out[info.outOffset[j]] = in[info.inOffset[j]];
-                            }
-                            in += inStride;
-                            out += outStride;
-                        }
-                    }
-                    break;
-                }
+                byteSwapBuffer(info.outFormat, out, nSamples);
             }
-            break;
-
         }
     }
 
-#endif
-
 } // end of namaepsace
@@ -28,8 +28,11 @@
 \******************************************************************************/
 
 #include "SampleUtil.h"
+#include <cstring>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <chrono>
 #include <vector>
 
 namespace dfx
@@ -66,15 +69,68 @@ namespace dfx
     static constexpr StreamIOStatus StreamIO_Output_Underflow = 0x2;
 
     // ///////////////////////////////////////////////////////////////////
-    // Set these for your desired system-wide format for working samples
+    // The system-wide format for working samples. Follows the engine's.
+    // (See engine_t in SampleUtil.h)
 
-    using system_t = double;
-    static constexpr auto system_fmt = SampleFormat::FLOAT64;
+    using system_t = engine_t;
+    static constexpr auto system_fmt = FormatOf<system_t>::value;
    
     // ///////////////////////////////////////////////////////////////////
 
     typedef int (*CallbackPtr)(void* outBuff, void* inBuff, unsigned nFrames, double streamTime, StreamIOStatus ioStatus, void* userData);
 
+    // A play sink lets the user callback write its output straight into the
+    // device's channel buffers, instead of into the user play buffer that then
+    // gets converted into them. Each sample is converted once, from the type
+    // the callback renders in to the device format, as it is written. If the
+    // device takes the callback's type, Channel() hands out the raw buffer.
+
+    class PlaySink {
+    public:
+
+        char** channels{};      // One buffer per device play channel (not interleaved)
+        unsigned nChannels{};
+        unsigned nFrames{};
+        SampleFormat format{};  // The device format
+        bool swapBytes{};
+
+    public:
+
+        PlaySink() = default;
+
+        // Writes n frames of channel c, starting at frame, taking every
+        // stride'th sample of src.
+
+        template<class T>
+        void Write(unsigned c, unsigned frame, const T* src, unsigned n, int stride = 1)
+        {
+            auto dest = channels[c] + frame * nBytes(format);
+            convertBuffer(format, dest, 1, FormatOf<T>::value, const_cast<T*>(src), stride, n, 1);
+            if (swapBytes) byteSwapBuffer(format, dest, n);
+        }
+
+        // Writes n frames of silence to all the channels, starting at frame
+
+        void Clear(unsigned frame, unsigned n)
+        {
+            for (unsigned c = 0; c < nChannels; c++)
+            {
+                memset(channels[c] + frame * nBytes(format), 0, n * nBytes(format));
+            }
+        }
+
+        // The raw buffer of channel c, if the device takes samples of type T
+        // as is, else nullptr.
+
+        template<class T>
+        T* Channel(unsigned c)
+        {
+            return format == FormatOf<T>::value && !swapBytes ? reinterpret_cast<T*>(channels[c]) : nullptr;
+        }
+    };
+
+    typedef int (*SinkCallbackPtr)(PlaySink& sink, void* inBuff, unsigned nFrames, double streamTime, StreamIOStatus ioStatus, void* userData);
+
     // For buffer conversion
 
     struct ConvertInfo
@@ -92,9 +148,10 @@ namespace dfx
 
     struct CallbackInfo
     {
-        std::thread thread{};  // Used for certain shutdown operations
+        std::thread thread{};  // The stopper thread, for stops the callback asks for
         void* object{};        // Used as a "this" pointer.
         void* callback{};      // Generic pointer to user level processing callback
+        void* sinkCallback{};  // Or to one that writes through a PlaySink
         void* userData{};      // Generic pointer to data to pass to said callback
         void* errorCallback{};
         void* apiInfo{};       // void pointer for API specific callback information
@@ -219,6 +276,7 @@ namespace dfx
         SampleFormat devRecFormat{};
 
         std::mutex mutex{};
+        std::condition_variable stateChanged{}; // Signaled when the stream stops or closes
 
         double streamTime{};         // Number of elapsed seconds since the stream started.
 
@@ -243,8 +301,8 @@ namespace dfx
 
     extern void convertBuffer(DfxStream& stream, char* outBuffer, char* inBuffer, ConvertInfo& info);
 
-    // This way does interleave/de-interleave
-    //extern void convertBufferX(DfxStream& stream, char* outBuffer, char* inBuffer, ConvertInfo& info);
+    // This way fans interleaved user channels out to separate device channel buffers
+    extern void convertBufferX(DfxStream& stream, char** outChannels, char* inBuffer, ConvertInfo& info, bool swapBytes);
 
 
     // /////////////////////////////////////////////////////////////////
@@ -300,8 +358,20 @@ namespace dfx
         virtual bool Stop();  // should be overidden
         virtual bool Stopped() = 0;
 
+        // Blocks the calling (control) thread until the stream has stopped,
+        // or until the timeout runs out. Returns true if stopped.
+        bool WaitForStop(std::chrono::milliseconds timeout);
+
+        // Wakes up anyone in WaitForStop(). It takes a lock, so don't
+        // call it from the audio thread.
+        void NotifyStateChange();
+
         virtual void ConfigureUserCallback(CallbackPtr userCallback) = 0;
 
+        // Use this instead of ConfigureUserCallback() to have the callback
+        // render straight into the device buffers. (Skips the user play buffer.)
+        virtual void ConfigureSinkCallback(SinkCallbackPtr sinkCallback) = 0;
+
         virtual bool Open(long nInputChannels_, long nOutputChannels_, long bufferSize_, unsigned sampleRate_, void* userData_, bool verbose) = 0;
         virtual bool Close() = 0;
 
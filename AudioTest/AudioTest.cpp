@@ -136,10 +136,10 @@ void test1()
 
 struct MyData
 {
-	FrameBuffer<system_t>& fb;
+	FrameBuffer<double>& fb;
 	unsigned samplesPlayed;
 
-	MyData(FrameBuffer<system_t>& fb_) : fb(fb_), samplesPlayed{} {; }
+	MyData(FrameBuffer<double>& fb_) : fb(fb_), samplesPlayed{} {; }
 };
 
 int loopPlayBack(void* outBuff, void* inBuff, unsigned nFrames, double streamTime, StreamIOStatus ioStatus, void* userData)
@@ -180,8 +180,8 @@ int loopPlayBack(void* outBuff, void* inBuff, unsigned nFrames, double streamTim
 	for (unsigned i = 0; i < nf; i++)
 	{
 		auto sf = fb.GetStereoFrame(data->samplesPlayed++);
-		*p++ = sf.left;
-		*p++ = sf.right;
+		*p++ = static_cast<system_t>(sf.left);
+		*p++ = static_cast<system_t>(sf.right);
 	}
 
 	for (unsigned i = 0; i < left_over; i++)
@@ -240,8 +240,8 @@ int wavesPlayBack(void* outBuff, void* inBuff, unsigned nFrames, double streamTi
 			// be the sampling rate of the recorded file. So the tick function
 			// below might have to calculate an interpolated frame.
 			auto sf = waves->MonoTick();
-			*p++ = sf;
-			*p++ = sf;
+			*p++ = static_cast<system_t>(sf);
+			*p++ = static_cast<system_t>(sf);
 			--nFrames;
 			++cowboy;
 		}
@@ -254,8 +254,8 @@ int wavesPlayBack(void* outBuff, void* inBuff, unsigned nFrames, double streamTi
 			// be the sampling rate of the recorded file. So the tick function
 			// below might have to calculate an interpolated frame.
 			auto sf = waves->StereoTick();
-			*p++ = sf.left;
-			*p++ = sf.right;
+			*p++ = static_cast<system_t>(sf.left);
+			*p++ = static_cast<system_t>(sf.right);
 			--nFrames;
 			++cowboy;
 		}
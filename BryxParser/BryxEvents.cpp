@@ -0,0 +1,514 @@
+/******************************************************************************\
+ * Bryx - "Bryan exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate Bryx files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include <fstream>
+#include "BryxEvents.h"
+
+namespace bryx
+{
+	EventParser::EventParser()
+	: lexi()
+	, last_parser_error()
+	, handler(nullptr)
+	, file_moniker()
+	, source_text()
+	, name_buf()
+	, dfx_mode(true)
+	{
+		lexi.preserve_white_space = false;
+		lexi.Start();
+	}
+
+	EventParser::~EventParser()
+	{
+	}
+
+	ParserResult EventParser::LoadFile(std::string_view& fname, EventHandler& handler_)
+	{
+		// Same deal as Parser::LoadFile(). Read it all in, then lex
+		// straight out of memory.
+
+		auto result = ParserResult::NoError;
+		std::ifstream f(std::string(fname), std::ios_base::in | std::ios_base::binary);
+
+		if (!f.is_open())
+		{
+			result = ParserResult::FileOpenError;
+			LogError(result, std::string(fname));
+		}
+		else
+		{
+			f.seekg(0, std::ios_base::end);
+			auto nbytes = static_cast<size_t>(f.tellg());
+			f.seekg(0, std::ios_base::beg);
+
+			source_text.resize(nbytes);
+			f.read(source_text.data(), nbytes);
+
+			result = LoadBuffer(source_text, handler_);
+		}
+
+		return result;
+	}
+
+	ParserResult EventParser::LoadBuffer(std::string_view text, EventHandler& handler_)
+	{
+		// The text must outlive the parse, as the spans handed
+		// out refer into it.
+
+		handler = &handler_;
+		lexi.SetBuffer(text);
+		auto result = Parse();
+		handler = nullptr;
+
+		return result;
+	}
+
+	// ///////////////////////////////////////////////////////////////////////////
+
+	void EventParser::LogError(ParserResult result_, std::string msg_)
+	{
+		last_parser_error.ResetMsg();
+		last_parser_error.msg = msg_;
+		last_parser_error.code = result_;
+		last_parser_error.extent = lexi.curr_span.extent;
+	}
+
+	ParserResult EventParser::AdvanceToken()
+	{
+		auto& span = lexi.NextSpan();
+
+		if (span.type == TokenEnum::ERROR)
+		{
+			return ParserResult::LexicalError;
+		}
+
+		return ParserResult::NoError;
+	}
+
+	ParserResult EventParser::Emit(bool keep_going)
+	{
+		if (keep_going) return ParserResult::NoError;
+
+		LogError(ParserResult::StoppedByHandler, "stopped by event handler");
+		return ParserResult::StoppedByHandler;
+	}
+
+	ParserResult EventParser::EmitName(const TokenSpan& span)
+	{
+		if (span.has_escapes)
+		{
+			// The lexer has already vetted the escapes
+
+			Lexi::Unescape(span.text, name_buf);
+			return Emit(handler->Name(name_buf));
+		}
+
+		return Emit(handler->Name(span.text));
+	}
+
+	// //////////////////////////////////////////////////////////////////////////
+
+	ParserResult EventParser::Preparse(TokenSpan& leading_value)
+	{
+		// Same rules as Parser::Preparse(). We might have a file moniker,
+		// as in: moniker = { ... }. If we have a name that turns out not
+		// to be a moniker, it's the one and only value in the file, and
+		// we hand it back in leading_value.
+
+		file_moniker.clear();
+
+		lexi.Start();
+
+		auto result = AdvanceToken(); // Must start the ball rolling
+
+		if (result != ParserResult::NoError) return result;
+
+		auto& tkn = Peek();
+
+		if (tkn.type == TokenEnum::QuotedChars || tkn.type == TokenEnum::UnquotedChars)
+		{
+			TokenSpan name_span = tkn;
+
+			result = AdvanceToken();
+
+			if (result != ParserResult::NoError) return result;
+
+			// If auto-detect was turned on, the lexer has set the syntax
+			// mode by now, going by the kind of nv separator it saw.
+
+			if (Peek().type == TokenEnum::NVSeparator)
+			{
+				if (name_span.has_escapes)
+				{
+					Lexi::Unescape(name_span.text, file_moniker);
+				}
+				else file_moniker = name_span.text;
+
+				if (lexi.syntax_mode == SyntaxModeEnum::Json && name_span.type != TokenEnum::QuotedChars)
+				{
+					return ParserResult::InvalidStartingToken;
+				}
+
+				result = AdvanceToken();
+
+				if (result != ParserResult::NoError) return result;
+
+				if (dfx_mode && Peek().type != TokenEnum::LeftBrace)
+				{
+					result = ParserResult::WrongToken;
+				}
+			}
+			else if (lexi.syntax_mode == SyntaxModeEnum::AutoDetect)
+			{
+				result = ParserResult::CannotDetermineSyntaxMode;
+			}
+			else leading_value = name_span;
+		}
+		else if (lexi.syntax_mode == SyntaxModeEnum::AutoDetect)
+		{
+			result = ParserResult::CannotDetermineSyntaxMode;
+		}
+
+		return result;
+	}
+
+	ParserResult EventParser::Parse()
+	{
+		TokenSpan leading_value;
+
+		auto result = Preparse(leading_value);
+
+		if (result != ParserResult::NoError)
+		{
+			std::ostringstream msg;
+			msg << "Preparse(): Invalid file start -- " << to_string(Peek().type);
+			LogError(result, msg.str());
+			return result;
+		}
+
+		result = Emit(handler->StartDocument(file_moniker));
+
+		if (result != ParserResult::NoError) return result;
+
+		if (leading_value.type != TokenEnum::Empty)
+		{
+			result = Emit(handler->Simple(leading_value));
+		}
+		else if (!AtEnd())
+		{
+			if (dfx_mode && !file_moniker.empty())
+			{
+				result = ParseCurlyList();
+			}
+			else
+			{
+				// Per json.org, the file can be any kind of value. But
+				// if we had a moniker, it can't be another name-value pair.
+				result = ParseValue(!file_moniker.empty());
+			}
+		}
+
+		if (result != ParserResult::NoError) return result;
+
+		// We *must* be at the end now. No garbage junk allowed at the end
+		// of the file.
+
+		if (AtErr())
+		{
+			return ParserResult::LexicalError;
+		}
+		else if (!AtEnd())
+		{
+			result = ParserResult::UnexpectedToken;
+			std::ostringstream msg;
+			msg << "Parse(): token " << to_string(Peek().type);
+			LogError(result, msg.str());
+			return result;
+		}
+
+		return Emit(handler->EndDocument());
+	}
+
+	ParserResult EventParser::ParseValue(bool dont_allow_nv_pair)
+	{
+		// value
+		//   curly list (object)
+		//   square list (array)
+		//   string
+		//   number
+		//   true
+		//   false
+		//   null
+		//   name nvsep value   (unless dont_allow_nv_pair)
+
+		if (AtEnd())
+		{
+			if (AtErr()) return ParserResult::LexicalError;
+
+			LogError(ParserResult::UnexpectedEOT, "ParseValue(): expecting a value");
+			return ParserResult::UnexpectedEOT;
+		}
+
+		auto result = ParserResult::NoError;
+
+		auto& tkn = Peek();
+
+		switch (tkn.type)
+		{
+			case TokenEnum::LeftBrace:
+			{
+				result = ParseCurlyList();
+			}
+			break;
+
+			case TokenEnum::LeftSquareBracket:
+			{
+				result = ParseSquareList();
+			}
+			break;
+
+			case TokenEnum::QuotedChars:
+			case TokenEnum::UnquotedChars:
+			{
+				// Either a plain old string, or the name of a name-value pair.
+				// The span's text lives in the source buffer, so we can hang
+				// on to a copy while we look ahead.
+
+				TokenSpan saved = tkn;
+
+				result = AdvanceToken();
+
+				if (result != ParserResult::NoError) break;
+
+				if (Peek().type == TokenEnum::NVSeparator)
+				{
+					if (dont_allow_nv_pair)
+					{
+						result = ParserResult::TokenNotAllowed;
+						std::ostringstream msg;
+						msg << "ParseValue(): token " << to_string(saved.type) << '\n';
+						msg << "EG: Can't have name-value pair fby another name-value" << '\n';
+						LogError(result, msg.str());
+						break;
+					}
+
+					result = EmitName(saved);
+
+					if (result != ParserResult::NoError) break;
+
+					result = AdvanceToken(); // past the separator
+
+					if (result != ParserResult::NoError) break;
+
+					result = ParseValue(true);
+				}
+				else result = Emit(handler->Simple(saved));
+			}
+			break;
+
+			case TokenEnum::Number:
+			case TokenEnum::True:
+			case TokenEnum::False:
+			case TokenEnum::Null:
+			{
+				result = Emit(handler->Simple(tkn));
+
+				if (result != ParserResult::NoError) break;
+
+				result = AdvanceToken();
+			}
+			break;
+
+			default:
+			{
+				result = ParserResult::UnexpectedToken;
+				std::ostringstream msg;
+				msg << "ParseValue(): token " << to_string(tkn.type);
+				LogError(result, msg.str());
+			}
+			break;
+		}
+
+		return result;
+	}
+
+	ParserResult EventParser::ParseCurlyList()
+	{
+		// We're sitting on the left brace. Members are name-value pairs,
+		// separated by optional commas.
+
+		auto result = Emit(handler->StartCurlyList());
+
+		if (result == ParserResult::NoError)
+		{
+			result = AdvanceToken();
+		}
+
+		while (result == ParserResult::NoError)
+		{
+			if (AtEnd())
+			{
+				if (AtErr()) return ParserResult::LexicalError;
+
+				result = ParserResult::UnexpectedEOT;
+				LogError(result, "ParseCurlyList(): expecting token RightBrace");
+				break;
+			}
+
+			if (Peek().type == TokenEnum::RightBrace)
+			{
+				result = Emit(handler->EndCurlyList());
+
+				if (result == ParserResult::NoError)
+				{
+					result = AdvanceToken();
+				}
+
+				break;
+			}
+
+			result = ParseMember();
+
+			if (result == ParserResult::NoError && Peek().type == TokenEnum::Comma)
+			{
+				result = AdvanceToken();
+			}
+		}
+
+		return result;
+	}
+
+	ParserResult EventParser::ParseMember()
+	{
+		// member
+		//    ws string ws nvsep element
+
+		auto& tkn = Peek();
+
+		bool is_name = tkn.type == TokenEnum::QuotedChars;
+
+		if (lexi.syntax_mode == SyntaxModeEnum::Bryx)
+		{
+			is_name = is_name || tkn.type == TokenEnum::UnquotedChars;
+		}
+
+		if (!is_name)
+		{
+			std::ostringstream msg;
+			msg << "ParseMember(): expecting a name, got token " << to_string(tkn.type);
+			LogError(ParserResult::WrongToken, msg.str());
+			return ParserResult::WrongToken;
+		}
+
+		TokenSpan name_span = tkn;
+
+		auto result = AdvanceToken();
+
+		if (result != ParserResult::NoError) return result;
+
+		if (Peek().type != TokenEnum::NVSeparator)
+		{
+			if (AtErr()) return ParserResult::LexicalError;
+
+			std::ostringstream msg;
+			msg << "expecting token " << to_string(TokenEnum::NVSeparator);
+			LogError(ParserResult::WrongToken, msg.str());
+			return ParserResult::WrongToken;
+		}
+
+		result = EmitName(name_span);
+
+		if (result != ParserResult::NoError) return result;
+
+		result = AdvanceToken(); // past separator
+
+		if (result != ParserResult::NoError) return result;
+
+		return ParseValue(true); // but don't allow another nv pair
+	}
+
+	ParserResult EventParser::ParseSquareList()
+	{
+		// We're sitting on the left bracket. Elements are any kind of
+		// value, including name-value pairs, separated by optional commas.
+
+		auto result = Emit(handler->StartSquareList());
+
+		if (result == ParserResult::NoError)
+		{
+			result = AdvanceToken();
+		}
+
+		while (result == ParserResult::NoError)
+		{
+			if (AtEnd())
+			{
+				if (AtErr()) return ParserResult::LexicalError;
+
+				result = ParserResult::UnexpectedEOT;
+				LogError(result, "ParseSquareList(): expecting token RightSquareBracket");
+				break;
+			}
+
+			if (Peek().type == TokenEnum::RightSquareBracket)
+			{
+				result = Emit(handler->EndSquareList());
+
+				if (result == ParserResult::NoError)
+				{
+					result = AdvanceToken();
+				}
+
+				break;
+			}
+
+			result = ParseValue(false);
+
+			if (result == ParserResult::NoError && Peek().type == TokenEnum::Comma)
+			{
+				result = AdvanceToken();
+			}
+		}
+
+		return result;
+	}
+
+	// ///////////////////////////////////////////////////////////////////////////
+
+	void EventParser::PrintError(std::ostream& sout, std::string_view& ctx)
+	{
+		sout << "Context: " << ctx << std::endl;
+
+		last_parser_error.Print(sout);
+
+		// For an error span, the details come from the lexer's last error
+
+		lexi.MakeToken(lexi.curr_span)->Print(sout);
+	}
+
+}; // end of namespace
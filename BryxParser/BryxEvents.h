@@ -0,0 +1,157 @@
+#pragma once
+
+/******************************************************************************\
+ * Bryx - "Bryan exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate Bryx files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#include <string>
+#include <string_view>
+#include "BryxParser.h"
+
+namespace bryx
+{
+	// ////////////////////////////////////////////////////////////////////////
+	//
+	// Event (SAX-style) parsing
+	//
+	// Instead of building a parse tree, the EventParser hands each piece of
+	// the document to an EventHandler as it's found. Nothing is kept around
+	// after the callback returns, so memory use doesn't grow with the size
+	// of the document.
+	//
+	// The events for a name-value pair are Name() followed by the events for
+	// its value. So { a = 1, b = [2, 3] } comes out as:
+	//
+	//    StartCurlyList, Name(a), Simple(1), Name(b), StartSquareList,
+	//    Simple(2), Simple(3), EndSquareList, EndCurlyList
+	//
+	// Any callback can return false to stop the parse right there.
+	//
+	// ////////////////////////////////////////////////////////////////////////
+
+	class EventHandler {
+	public:
+
+		virtual ~EventHandler() { }
+
+		// moniker is the name of the outermost name-value pair, if the
+		// document has one, (eg: the "dfx" in dfx = { ... }), else empty.
+
+		virtual bool StartDocument(std::string_view /*moniker*/) { return true; }
+		virtual bool EndDocument() { return true; }
+
+		virtual bool StartCurlyList() { return true; }
+		virtual bool EndCurlyList() { return true; }
+
+		virtual bool StartSquareList() { return true; }
+		virtual bool EndSquareList() { return true; }
+
+		// The name has had any escapes translated. It's only good for the
+		// duration of the call.
+
+		virtual bool Name(std::string_view /*name*/) { return true; }
+
+		// Strings, numbers, true, false and null. The span refers into the
+		// source text. Quoted strings come without their quotes, but with
+		// their escapes still in them (see Lexi::Unescape()). Numbers are
+		// only delimited here, not parsed, so the handler only pays for
+		// the ones it wants (see Lexi::ParseBryxNumber()).
+
+		virtual bool Simple(const TokenSpan& /*span*/) { return true; }
+	};
+
+
+	class EventParser {
+	public:
+
+		Lexi lexi;
+
+		ParserResultPkg last_parser_error;
+
+		EventHandler* handler;
+
+		std::string file_moniker;
+
+		std::string source_text; // What LoadFile() read in, for the lexer to work out of
+		std::string name_buf;    // For unescaping names
+
+		bool dfx_mode;
+
+	public:
+
+		EventParser();
+		virtual ~EventParser();
+
+		ParserResult LoadFile(std::string_view& fname, EventHandler& handler_);
+		ParserResult LoadBuffer(std::string_view text, EventHandler& handler_);
+
+		void SetSyntaxMode(SyntaxModeEnum mode_)
+		{
+			lexi.SetSyntaxMode(mode_);
+		}
+
+		void SetDfxMode(bool dfx_mode_)
+		{
+			dfx_mode = dfx_mode_;
+		}
+
+		void PrintError(std::ostream& sout, std::string_view& ctx);
+
+	protected:
+
+		void LogError(ParserResult result_, std::string msg_);
+
+		ParserResult AdvanceToken();
+
+		const TokenSpan& Peek()
+		{
+			return lexi.curr_span;
+		}
+
+		bool AtEnd()
+		{
+			return lexi.curr_span.IsQuitToken();
+		}
+
+		bool AtErr()
+		{
+			return lexi.curr_span.type == TokenEnum::ERROR;
+		}
+
+		ParserResult Emit(bool keep_going);
+		ParserResult EmitName(const TokenSpan& span);
+
+		ParserResult Parse();
+		ParserResult Preparse(TokenSpan& leading_value);
+
+		ParserResult ParseValue(bool dont_allow_nv_pair);
+		ParserResult ParseCurlyList();
+		ParserResult ParseSquareList();
+		ParserResult ParseMember();
+	};
+
+}; // end of namespace
@@ -26,6 +26,7 @@
 \******************************************************************************/
 
 #include <sstream>
+#include <charconv>
 #include "BryxLexi.h"
 #include "Units.h"
 
@@ -156,9 +157,9 @@ namespace bryx
 		}
 		else
 		{
-			std::cout << "Token: " << bryx::to_string(type) << ", text = \"" << to_string() << "\"" << '\n';
+			sout << "Token: " << bryx::to_string(type) << ", text = \"" << to_string() << "\"" << '\n';
 		}
-		std::cout << "on row " << extent.srow << ", near col " << extent.scol << " (note: a tab char counts as one column) \n";
+		sout << "on row " << extent.srow << ", near col " << extent.scol << " (note: a tab char counts as one column) \n";
 	}
 
 	// /////////////////////////////////////////////////////////////////////////////
@@ -331,25 +332,30 @@ namespace bryx
 
 	NumberToken::NumberToken(TokenEnum type_, std::string text_, const Extent& extent_)
 	: TokenBase(type_, extent_)
-	, text(text_), number_traits()
+	, text(text_), engr_num_built(false), value(0.0), units(UnitEnum::None), number_traits()
 	{
 	}
 
 	NumberToken::NumberToken(TokenEnum type_, std::string text_)
 	: TokenBase(type_)
-	, text(text_), number_traits()
+	, text(text_), engr_num_built(false), value(0.0), units(UnitEnum::None), number_traits()
 	{
 	}
 
 	NumberToken::NumberToken(TokenEnum type_)
 	: TokenBase(type_)
-	, text(), number_traits()
+	, text(), engr_num_built(false), value(0.0), units(UnitEnum::None), number_traits()
 	{
 	}
 
 
 	NumberToken::NumberToken(const NumberToken& other)
 	: TokenBase(other) // (other.type, other.text, other.extent)
+	, text(other.text)
+	, engr_num(other.engr_num)
+	, engr_num_built(other.engr_num_built)
+	, value(other.value)
+	, units(other.units)
 	{
 		// Copy constructor
 		number_traits = other.number_traits;
@@ -360,6 +366,10 @@ namespace bryx
 	: TokenBase(other)
 		//: NumberToken(other.type, move(other.text), other.extent)
 		, text(move(other.text))
+		, engr_num(other.engr_num)
+		, engr_num_built(other.engr_num_built)
+		, value(other.value)
+		, units(other.units)
 	{
 		// Move constructor. Note argument is *not* const
 		//other.extent.Clear();
@@ -384,6 +394,10 @@ namespace bryx
 			//type = other.type;
 			//extent = other.extent;
 			text = other.text;
+			engr_num = other.engr_num;
+			engr_num_built = other.engr_num_built;
+			value = other.value;
+			units = other.units;
 			number_traits = other.number_traits;
 			//result_pkg = other.result_pkg;
 		}
@@ -401,6 +415,10 @@ namespace bryx
 			//type = other.type;
 			//extent = other.extent;
 			number_traits = other.number_traits;
+			engr_num = other.engr_num;
+			engr_num_built = other.engr_num_built;
+			value = other.value;
+			units = other.units;
 
 			//other.text = "foofoo";
 
@@ -420,9 +438,87 @@ namespace bryx
 		return *this;
 	}
 
-	void NumberToken::ProcessNum(std::ostream &serr)
+	bool NumberToken::ProcessNum()
 	{
+		// The number traits tell us where the digits, metric prefix and units
+		// are, so we can convert the digits straight to a double and look
+		// up the prefix and units in one go. The engineering notation form
+		// waits until someone actually asks for it.
+
+		std::string_view src(text);
+
+		int x = number_traits.end_locn;
+
+		units = UnitEnum::None;
+
+		if (number_traits.HasUnits())
+		{
+			x = number_traits.units_locn;
+			units = unit_parse_tree.find_unitname(src.substr(x));
+			if (units == UnitEnum::None)
+			{
+				// We have some units, we just don't know anything about them.
+				units = UnitEnum::Other;
+			}
+		}
+
+		int pfx_idx = -1;
+
+		if (number_traits.HasMetricPrefix())
+		{
+			pfx_idx = mpfx_table.MetricPrefixIndex(src[number_traits.metric_pfx_locn]);
+			if (number_traits.metric_pfx_locn < x) x = number_traits.metric_pfx_locn;
+		}
+
+		auto first = src.data();
+		auto last = first + x;
+
+		auto [p, ec] = std::from_chars(first, last, value);
+
+		if (ec == std::errc() && p == last)
+		{
+			if (pfx_idx != -1) value = mpfx_table.Scale(value, pfx_idx);
+			return true;
+		}
+
+		// Out of range, most likely. The long way around will sort
+		// out the infinities and errors.
+
+		std::stringstream serr;
 		engr_num.process_num_from_lexi(serr, text, number_traits);
+		engr_num_built = true;
+		value = engr_num.RawX();
+		units = engr_num.units;
+
+		return serr.str().empty();
+	}
+
+	const EngrNum& NumberToken::Engr() const
+	{
+		if (!engr_num_built)
+		{
+			// Any errors were already caught when the number was processed
+
+			std::stringstream serr;
+			engr_num.process_num_from_lexi(serr, text, number_traits);
+			engr_num_built = true;
+		}
+
+		return engr_num;
+	}
+
+	double NumberToken::X() const
+	{
+		// Applies scaled units like dB
+
+		auto x = value;
+
+		if (IsCat<UnitCatEnum::Ratio>(units))
+		{
+			x = Convert<UnitCatEnum::Ratio>(x, units, UnitEnum::SimpleRatio);
+		}
+
+		return x;
 	}
 
 	const std::string NumberToken::to_string() const
@@ -464,6 +560,10 @@ namespace bryx
 	Lexi::Lexi()
 	: src(0)
 	, temp_buf()
+	, buf()
+	, buf_p(nullptr)
+	, buffer_mode(false)
+	, curr_span()
 	, last_lexical_error()
 	, prev_token(std::make_shared<CharToken>(TokenEnum::Null))
 	, curr_token(std::make_shared<CharToken>(TokenEnum::SOT))
@@ -583,7 +683,7 @@ namespace bryx
 
 		while (c != EOF)
 		{
-			if (!isspace(c)) break;
+			if (!IsWhiteSpace(c)) break;
 
 			if (preserve_white_space)
 			{
@@ -601,6 +701,7 @@ namespace bryx
 		token_cnt = 0; lexi_posn.Clear();
 		prev_token = std::make_shared<CharToken>(TokenEnum::Null);
 		curr_token = std::make_shared<CharToken>(TokenEnum::SOT);
+		curr_span = TokenSpan(TokenEnum::SOT, std::string_view(), lexi_posn);
 		return curr_token;
 	}
 
@@ -609,6 +710,19 @@ namespace bryx
 		LexiResult result{ LexiResult::NoError };
 		last_lexical_error.Clear();
 
+		if (buffer_mode)
+		{
+			// Scan the span, then dress it up as a real token for the parser
+
+			if (!curr_token->IsQuitToken())
+			{
+				auto &span = NextSpan();
+				AcceptToken(MakeToken(span), false);
+			}
+
+			return curr_token;
+		}
+
 		// Yes, a while loop, but usually just one pass, which is terminated
 		// via break or return statement. If there's white space at the beginining,
 		// then two loops.
@@ -1100,6 +1214,413 @@ namespace bryx
 		return result;
 	}
 
+	// ///////////////////////////////////////////////////////////////////////////
+	// Memory buffer mode
+	//
+	// Same grammar as the stream collectors above, but we walk a pointer
+	// through the buffer and hand out spans of it rather than copying
+	// characters one at a time into temp_buf.
+	// ///////////////////////////////////////////////////////////////////////////
+
+	void Lexi::SkipBufWhiteSpace()
+	{
+		auto e = BufEnd();
+
+		while (buf_p < e)
+		{
+			char c = *buf_p;
+
+			if (c == '\n')
+			{
+				++lexi_posn.srow; lexi_posn.scol = 1;
+			}
+			else if (!IsWhiteSpace(c))
+			{
+				break;
+			}
+			else if (c != '\r')
+			{
+				++lexi_posn.scol;
+			}
+
+			++buf_p;
+		}
+	}
+
+	const TokenSpan& Lexi::NextSpan()
+	{
+		last_lexical_error.Clear();
+
+		if (curr_span.IsQuitToken())
+		{
+			return curr_span;
+		}
+
+		auto ws_start = buf_p;
+		auto ws_extent = WhereAreWe();
+
+		SkipBufWhiteSpace();
+
+		if (preserve_white_space && buf_p != ws_start)
+		{
+			auto extent = WhereAreWe();
+			extent.CopyStart(ws_extent);
+			AcceptSpan(TokenEnum::WhiteSpace, ws_start, extent);
+			return curr_span;
+		}
+
+		int c = PeekBufChar();
+
+		if (c == '{')
+		{
+			ScanSingleChar(TokenEnum::LeftBrace);
+		}
+		else if (c == '[')
+		{
+			ScanSingleChar(TokenEnum::LeftSquareBracket);
+		}
+		else if (c == '"')
+		{
+			ScanQuotedChars();
+		}
+		else if (IsAlpha(c))
+		{
+			if (ScanUnquotedChars() == LexiResult::NoError)
+			{
+				auto s = curr_span.text;
+				if (s == "true") curr_span.type = TokenEnum::True;
+				else if (s == "false") curr_span.type = TokenEnum::False;
+				else if (s == "null") curr_span.type = TokenEnum::Null;
+			}
+		}
+		else if (IsDigit(c) || c == '-')
+		{
+			ScanNumber();
+		}
+		else if (c == '}')
+		{
+			ScanSingleChar(TokenEnum::RightBrace);
+		}
+		else if (c == ']')
+		{
+			ScanSingleChar(TokenEnum::RightSquareBracket);
+		}
+		else if (c == ',')
+		{
+			ScanSingleChar(TokenEnum::Comma);
+		}
+		else if (IsTrialNVSeparator(c) && syntax_mode == SyntaxModeEnum::AutoDetect)
+		{
+			syntax_mode = NVSeparatorType(c);
+			ScanSingleChar(TokenEnum::NVSeparator);
+		}
+		else if (IsNVSeparator(c))
+		{
+			ScanSingleChar(TokenEnum::NVSeparator);
+		}
+		else if (c == EOF)
+		{
+			auto extent = WhereAreWe();
+			extent.Bump();
+			AcceptSpan(TokenEnum::EOT, buf_p, extent);
+		}
+		else
+		{
+			std::ostringstream msg;
+			msg << "NextSpan(): char = '" << (unsigned char)(c) << "'";
+			auto extent = WhereAreWe();
+			extent.Bump();
+			LogSpanError(LexiResult::UnexpectedChar, msg.str(), extent);
+		}
+
+		return curr_span;
+	}
+
+	void Lexi::AcceptSpan(TokenEnum type, const char* p, const Extent& extent)
+	{
+		// The span runs from p up to where we are now
+
+		curr_span.type = type;
+		curr_span.extent = extent;
+		curr_span.text = std::string_view(p, static_cast<size_t>(buf_p - p));
+		curr_span.has_escapes = false;
+
+		++token_cnt;
+	}
+
+	void Lexi::LogSpanError(LexiResult result_, std::string msg_, const Extent& extent_)
+	{
+		// Like LogError(), we don't absorb the offending character
+
+		AcceptSpan(TokenEnum::ERROR, buf_p, extent_);
+		last_lexical_error = LexiResultPkg(msg_, result_, extent_);
+	}
+
+	LexiResult Lexi::ScanSingleChar(TokenEnum type)
+	{
+		auto p = buf_p;
+		auto extent = WhereAreWe();
+		extent.Bump();
+		SkipBufChars(buf_p + 1);
+		AcceptSpan(type, p, extent);
+		return LexiResult::NoError;
+	}
+
+	LexiResult Lexi::ScanQuotedChars()
+	{
+		// Like CollectQuotedChars(), strings can't span lines. Escapes
+		// are only checked here; Unescape() does the translating, and
+		// only for those strings that actually need it.
+
+		SkipBufChars(buf_p + 1); // skip quote
+
+		auto s = buf_p;
+		auto p = s;
+		auto e = BufEnd();
+		auto extent = WhereAreWe();
+
+		bool has_escapes = false;
+
+		while (p < e)
+		{
+			char c = *p;
+
+			if (c == '"')
+			{
+				break;
+			}
+
+			if (c == '\r' || c == '\n')
+			{
+				extent.ecol = extent.scol + static_cast<int>(p - s);
+				LogSpanError(LexiResult::UnterminatedString, "ScanQuotedChars(): ending quote for string expected before new line", extent);
+				return LexiResult::UnterminatedString;
+			}
+
+			if (IsBackSlash(c))
+			{
+				has_escapes = true;
+				if (++p == e) break;
+			}
+
+			++p;
+		}
+
+		if (p == e)
+		{
+			extent.ecol = extent.scol + static_cast<int>(p - s);
+			LogSpanError(LexiResult::UnexpectedEOF, "ScanQuotedChars(): expected character '\"'", extent);
+			return LexiResult::UnexpectedEOF;
+		}
+
+		extent.ecol = extent.scol + static_cast<int>(p - s);
+
+		SkipBufChars(p);
+		AcceptSpan(TokenEnum::QuotedChars, s, extent);
+		SkipBufChars(p + 1); // skip closing quote
+
+		curr_span.has_escapes = has_escapes;
+
+		if (has_escapes)
+		{
+			// Catch bad escapes now, so that errors show up where they
+			// would in stream mode
+
+			std::string dummy;
+			auto result = Unescape(curr_span.text, dummy);
+
+			if (result != LexiResult::NoError)
+			{
+				LogSpanError(result, "ScanQuotedChars(): invalid or unsupported escaped character", extent);
+				return result;
+			}
+		}
+
+		return LexiResult::NoError;
+	}
+
+	LexiResult Lexi::ScanUnquotedChars()
+	{
+		// Same rules as CollectUnquotedChars()
+
+		auto s = buf_p;
+		auto p = s;
+		auto e = BufEnd();
+		auto extent = WhereAreWe();
+
+		while (p < e)
+		{
+			int c = static_cast<unsigned char>(*p);
+
+			if (isalnum(c) || c == '-' || c == '_' || c == '.')
+			{
+				++p;
+			}
+			else if (IsWhiteSpace(c) || c == ',')
+			{
+				break;
+			}
+			else
+			{
+				extent.ecol = extent.scol + static_cast<int>(p - s);
+				SkipBufChars(p);
+				std::ostringstream msg;
+				msg << "ScanUnquotedChars(): an unquoted field cannot contain character '" << char(c) << "'\n";
+				LogSpanError(LexiResult::UnexpectedChar, msg.str(), extent);
+				return LexiResult::UnexpectedChar;
+			}
+		}
+
+		extent.ecol = extent.scol + static_cast<int>(p - s);
+		SkipBufChars(p);
+		AcceptSpan(TokenEnum::UnquotedChars, s, extent);
+
+		return LexiResult::NoError;
+	}
+
+	LexiResult Lexi::ScanNumber()
+	{
+		// We just delimit the number here, same as CollectNumber(). The
+		// actual parsing waits until someone calls MakeToken().
+
+		auto s = buf_p;
+		auto p = s;
+		auto e = BufEnd();
+		auto extent = WhereAreWe();
+
+		while (p < e)
+		{
+			int c = static_cast<unsigned char>(*p);
+
+			if (IsDigit(c) || IsAlpha(c) || c == '-' || c == '+' || c == '.' || c == '%')
+			{
+				++p;
+			}
+			else break;
+		}
+
+		extent.ecol = extent.scol + static_cast<int>(p - s);
+		SkipBufChars(p);
+		AcceptSpan(TokenEnum::Number, s, extent);
+
+		return LexiResult::NoError;
+	}
+
+	token_ptr Lexi::MakeToken(const TokenSpan& span)
+	{
+		// NOTE: For error spans, the details are in last_lexical_error,
+		// so call this before lexing the next span.
+
+		token_ptr t;
+
+		switch (span.type)
+		{
+			case TokenEnum::LeftBrace:
+			case TokenEnum::RightBrace:
+			case TokenEnum::LeftSquareBracket:
+			case TokenEnum::RightSquareBracket:
+			case TokenEnum::NVSeparator:
+			case TokenEnum::Comma:
+			{
+				t = std::make_shared<CharToken>(span.type, span.text[0], span.extent);
+			}
+			break;
+
+			case TokenEnum::QuotedChars:
+			{
+				if (span.has_escapes)
+				{
+					std::string s;
+					auto result = Unescape(span.text, s);
+
+					if (result != LexiResult::NoError)
+					{
+						t = MakeErrorToken(result, "MakeToken(): invalid or unsupported escaped character", span.extent);
+					}
+					else t = std::make_shared<SimpleToken>(span.type, std::move(s), span.extent);
+				}
+				else t = std::make_shared<SimpleToken>(span.type, std::string(span.text), span.extent);
+			}
+			break;
+
+			case TokenEnum::Number:
+			{
+				// Might be a number token or an error token
+				t = ParseBryxNumber(span.text);
+				t->extent = span.extent;
+			}
+			break;
+
+			case TokenEnum::EOT:
+			{
+				t = std::make_shared<CharToken>(span.type, static_cast<char>(EOF), span.extent);
+			}
+			break;
+
+			case TokenEnum::ERROR:
+			{
+				t = MakeErrorToken(last_lexical_error.code, last_lexical_error.msg, span.extent);
+			}
+			break;
+
+			default:
+			{
+				// UnquotedChars, True, False, Null, WhiteSpace
+				t = std::make_shared<SimpleToken>(span.type, std::string(span.text), span.extent);
+			}
+			break;
+		}
+
+		return t;
+	}
+
+	// A static member function
+
+	LexiResult Lexi::Unescape(std::string_view text, std::string& dest)
+	{
+		// Translates the escapes the same way HandleEscapedChar() does
+
+		dest.clear();
+		dest.reserve(text.size());
+
+		auto p = text.begin();
+		auto e = text.end();
+
+		while (p != e)
+		{
+			char c = *p++;
+
+			if (!IsBackSlash(c))
+			{
+				dest.push_back(c);
+				continue;
+			}
+
+			if (p == e)
+			{
+				return LexiResult::InvalidEscapedChar;
+			}
+
+			c = *p++;
+
+			switch (c)
+			{
+				case '"': dest.push_back('"'); break;
+				case '\\': dest.push_back('\\'); break;
+				case '/': dest.push_back('/'); break;
+				case 'b': dest.push_back('\b'); break;
+				case 'f': dest.push_back('\f'); break;
+				case 'r': dest.push_back('\r'); break;
+				case 'n': dest.push_back('\n'); break;
+				case 't': dest.push_back('\t'); break;
+				case 'u': return LexiResult::Unsupported; // Can't do escaped hex characters yet
+				default: return LexiResult::InvalidEscapedChar;
+			}
+		}
+
+		return LexiResult::NoError;
+	}
+
 	// Support when using string views later on
 
 	inline int bump_char(std::string_view::const_iterator& pit, std::string_view::const_iterator& eit)
@@ -1296,7 +1817,7 @@ namespace bryx
 		// prefixes. We're relying on that, here, actually.
 		// @@ Except as noted above, "meter" is a problem.
 
-		auto idx = mpfx_parse_tree.MetricPrefixIndex(c);
+		auto idx = mpfx_table.MetricPrefixIndex(c);
 
 		if (idx != -1)
 		{
@@ -1350,16 +1871,11 @@ namespace bryx
 
 				Extent extent(0, 0, number_traits.end_locn);
 
-				auto t = std::make_shared<NumberToken>(TokenEnum::Number, src.data(), extent);
+				auto t = std::make_shared<NumberToken>(TokenEnum::Number, std::string(src), extent);
 
 				t->number_traits = number_traits;
-				std::stringstream serr;
-
-				t->ProcessNum(serr);
-
-				auto str = serr.str();
 
-				if (str.empty())
+				if (t->ProcessNum())
 				{
 					return t;  // Got's us a real live token!
 				}
@@ -43,6 +43,7 @@
 #include <sstream>
 #include <istream>
 #include <string>
+#include <string_view>
 #include "ResultPkg.h"
 #include "EngrNum.h"
 
@@ -291,11 +292,15 @@ namespace bryx
 
 		std::string text; // Will get instantiated with text from the source
 
+		mutable EngrNum engr_num;        // Built from the source text on first call to Engr()
+		mutable bool engr_num_built;
+
 	public:
 
 		friend class Lexi;
 
-		EngrNum engr_num;                // The source text will be analyzed and parsed into this
+		double value;                    // Metric prefix applied, but no scaled units like dB and %
+		UnitEnum units;
 		LexiNumberTraits number_traits;  // Will get filled in for possible number tokens
 
 	public:
@@ -313,7 +318,16 @@ namespace bryx
 
 	public:
 
-		void ProcessNum(std::ostream& serr);
+		bool ProcessNum(); // Returns false if the number couldn't be processed
+
+		// The engineering notation form of the number. It's expensive to build,
+		// and most callers only want the value, so it isn't built until asked
+		// for. Not thread safe.
+
+		const EngrNum& Engr() const;
+
+		double RawX() const { return value; } // Metric prefixes applied, but no scaled units like dB and %
+		double X() const;                     // Scaled units like dB and % applied.
 
 	public:
 
@@ -349,6 +363,32 @@ namespace bryx
 
 	using token_ptr = std::shared_ptr<TokenBase>;
 
+	// A lightweight token used when lexing straight out of a memory buffer.
+	// The text refers into the source buffer, so a span is only good for
+	// as long as the buffer is. Quoted strings come without their quotes,
+	// with any escapes left as is (has_escapes tells you to Unescape() them).
+	// Numbers are only delimited, not parsed. Use Lexi::MakeToken() to turn
+	// a span into a full blown token when you need one.
+
+	struct TokenSpan {
+		TokenEnum type;
+		Extent extent;
+		std::string_view text;
+		bool has_escapes;
+
+		TokenSpan() : type(TokenEnum::Empty), extent(), text(), has_escapes(false) { }
+
+		TokenSpan(TokenEnum type_, std::string_view text_, const Extent& extent_)
+		: type(type_), extent(extent_), text(text_), has_escapes(false)
+		{
+		}
+
+		bool IsQuitToken() const
+		{
+			return bryx::IndicatesQuit(type);
+		}
+	};
+
 	class Lexi {
 	public:
 
@@ -356,6 +396,14 @@ namespace bryx
 
 		std::ostringstream temp_buf;
 
+		// Memory buffer mode. When set, we never touch src or temp_buf.
+
+		std::string_view buf;
+		const char* buf_p;
+		bool buffer_mode;
+
+		TokenSpan curr_span;
+
 		LexiResultPkg last_lexical_error;
 
 		token_ptr prev_token;
@@ -380,6 +428,15 @@ namespace bryx
 		void SetStreamBuf(std::streambuf* sb_)
 		{
 			src.rdbuf(sb_);
+			buffer_mode = false;
+		}
+
+		void SetBuffer(std::string_view buf_)
+		{
+			// The buffer must outlive any spans we hand out
+			buf = buf_;
+			buf_p = buf.data();
+			buffer_mode = true;
 		}
 
 		void SetSyntaxMode(SyntaxModeEnum mode_)
@@ -397,7 +454,9 @@ namespace bryx
 
 		inline static bool IsWhiteSpace(int c)
 		{
-			return (c == ' ' || c == '\r' || c == '\n' || c == '\t') ? true : false;
+			// Same as isspace() in the "C" locale. Both the stream and
+			// buffer modes go by this, so they agree on what's white.
+			return (c == ' ' || c == '\r' || c == '\n' || c == '\t' || c == '\f' || c == '\v') ? true : false;
 		}
 
 		inline static bool IsZero(int c)
@@ -502,6 +561,25 @@ namespace bryx
 			return NextPeek();
 		}
 
+		inline const char* BufEnd() const
+		{
+			return buf.data() + buf.size();
+		}
+
+		inline int PeekBufChar() const
+		{
+			return buf_p < BufEnd() ? static_cast<unsigned char>(*buf_p) : EOF;
+		}
+
+		inline void SkipBufChars(const char* p)
+		{
+			// For runs of characters that we know stay on one line
+			lexi_posn.scol += static_cast<int>(p - buf_p);
+			buf_p = p;
+		}
+
+		void SkipBufWhiteSpace();
+
 		Extent WhereAreWe();
 
 		int SkipWhiteSpace();
@@ -519,6 +597,14 @@ namespace bryx
 
 		void AcceptToken(token_ptr tkn, bool advance);
 
+		// Buffer mode only: the zero-copy version of Next()
+
+		const TokenSpan& NextSpan();
+
+		token_ptr MakeToken(const TokenSpan& span);
+
+		static LexiResult Unescape(std::string_view text, std::string& dest);
+
 	protected:
 
 		LexiResult CollectSingleCharToken(TokenEnum type, int c);
@@ -527,6 +613,13 @@ namespace bryx
 		LexiResult CollectUnquotedChars();
 		LexiResult CollectNumber();
 
+		void AcceptSpan(TokenEnum type, const char* p, const Extent& extent);
+		void LogSpanError(LexiResult result_, std::string msg_, const Extent& extent_);
+		LexiResult ScanSingleChar(TokenEnum type);
+		LexiResult ScanQuotedChars();
+		LexiResult ScanUnquotedChars();
+		LexiResult ScanNumber();
+
 	public:
 
 		static std::shared_ptr<TokenBase> ParseBryxNumber(std::string_view text);
@@ -25,6 +25,7 @@
  *
 \******************************************************************************/
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include "BryxParser.h"
@@ -50,6 +51,7 @@ namespace bryx
 			case ParserResult::FileOpenError: s = "FileOpenError"; break;
 			case ParserResult::Unsupported: s = "Unsupported"; break;
 			case ParserResult::UnexpectedEOT: s = "Unexpected EOT"; break;
+			case ParserResult::StoppedByHandler: s = "Stopped by event handler"; break;
 			default: break;
 		}
 
@@ -138,9 +140,9 @@ namespace bryx
 	// /////////////////////////////////////////////////////////////////////////
 
 
-	NameValue::NameValue(const std::string& name_, std::shared_ptr<Value>& val_)
+	NameValue::NameValue(const std::string& interned_name_, value_ptr val_)
 	: Value(ValueEnum::NameValuePair)
-	, pair(name_, move(val_))
+	, pair{ interned_name_, val_ }
 	{
 		//std::cout << "NameValue default ctor called\n";
 	};
@@ -152,10 +154,9 @@ namespace bryx
 
 	// /////////////////////////////////////////////////////////////////////////
 
-	// WARNING! Have to make this struct or msvc compiler complains when using polymorphic make_unique() construction
-
-	SquareList::SquareList()
-		: Value(ValueEnum::SquareList)
+	SquareList::SquareList(std::pmr::memory_resource* mr_)
+	: Value(ValueEnum::SquareList)
+	, values(mr_)
 	{
 		//std::cout << "SquareList default ctor called\n"; 
 	}
@@ -165,9 +166,39 @@ namespace bryx
 		//std::cout << "SquareList dtor called\n"; 
 	}
 
-	void SquareList::Add(std::shared_ptr <Value>& v)
+	// /////////////////////////////////////////////////////////////////////////
+
+	FlatDict::const_iterator FlatDict::find(std::string_view name) const
 	{
-		values.push_back(move(v));
+		auto it = std::lower_bound(entries.begin(), entries.end(), name, [](const nv_type& e, std::string_view n) { return e.first < n; });
+
+		if (it != entries.end() && it->first == name)
+		{
+			return it;
+		}
+
+		return entries.end();
+	}
+
+	void FlatDict::Assign(NameValue** members, size_t n)
+	{
+		// Sort the member pointers, since nv_type itself can't be
+		// reassigned. Stable, so the first of any duplicates wins.
+
+		std::stable_sort(members, members + n, [](const NameValue* a, const NameValue* b) { return a->pair.first < b->pair.first; });
+
+		entries.clear();
+		entries.reserve(n);
+
+		for (size_t i = 0; i < n; i++)
+		{
+			if (i > 0 && members[i]->pair.first == members[i - 1]->pair.first)
+			{
+				continue;
+			}
+
+			entries.push_back(members[i]->pair);
+		}
 	}
 
 
@@ -181,9 +212,14 @@ namespace bryx
 
 	Parser::Parser()
 	: lexi{}
+	, arena{}
+	, arena_block_size{ ValueArena::DefaultBlockSize }
 	, root{}
 	, root_map{}
+	, element_stack{}
+	, member_stack{}
 	, file_moniker{}
+	, source_text{}
 	, curr_token_index{ -1 }
 	, dfx_mode{ true }
 	, debug_mode{ false }
@@ -204,8 +240,11 @@ namespace bryx
 
 	ParserResult Parser::LoadFile(std::string_view& fname)
 	{
+		// We read the whole file in one go and lex straight out of memory.
+		// Much faster than going through the stream a character at a time.
+
 		auto result = ParserResult::NoError;
-		std::fstream f(fname, std::ios_base::in);
+		std::ifstream f(std::string(fname), std::ios_base::in | std::ios_base::binary);
 
 		if (!f.is_open())
 		{
@@ -214,98 +253,97 @@ namespace bryx
 		}
 		else
 		{
-			auto fbuf = f.rdbuf();
-			SetStreamBuf(fbuf);
-			result = Parse();
+			f.seekg(0, std::ios_base::end);
+			auto nbytes = static_cast<size_t>(f.tellg());
+			f.seekg(0, std::ios_base::beg);
+
+			source_text.resize(nbytes);
+			f.read(source_text.data(), nbytes);
+
+			result = LoadBuffer(source_text);
 		}
 
 		return result;
 	}
 
+	ParserResult Parser::LoadBuffer(std::string_view text)
+	{
+		// The text must outlive the parse. The parse tree itself
+		// keeps its own copies of the strings.
+
+		// Node memory tracks source size pretty closely, so
+		// we can usually get the whole tree in one block.
+
+		arena_block_size = std::max(text.size(), ValueArena::DefaultBlockSize);
+
+		lexi.SetBuffer(text);
+		return Parse();
+	}
+
 
 	// ///////////////////////////////////////////////////////////////////////////
 	// Property-value helpers
 	// NOTE: These are static functions.
 
-	const curly_list_type* Parser::AsCurlyList(const std::shared_ptr<Value>& valPtr)
+	const curly_list_type* Parser::AsCurlyList(const Value* valPtr)
 	{
-		auto objptr = std::dynamic_pointer_cast<CurlyList>(valPtr);
-
-		if (objptr)
+		if (valPtr && valPtr->type == ValueEnum::CurlyList)
 		{
-			auto& obj_map_ptr = objptr->dict;
-			return &obj_map_ptr;
+			return &static_cast<const CurlyList*>(valPtr)->dict;
 		}
 		else return nullptr;
 	}
 
-	curly_list_type* Parser::AsCurlyList(std::shared_ptr<Value>& valPtr)
+	curly_list_type* Parser::AsCurlyList(value_ptr valPtr)
 	{
-		auto fred = std::dynamic_pointer_cast<CurlyList>(valPtr);
-
-		if (fred)
+		if (valPtr && valPtr->type == ValueEnum::CurlyList)
 		{
-			auto& george = fred->dict;
-			return &george;
+			return &static_cast<CurlyList*>(valPtr)->dict;
 		}
 		else return nullptr;
 	}
 
-	curly_list_type* Parser::GetCurlyListProperty(const curly_list_type* parent_map_ptr, const std::string prop_name)
+	curly_list_type* Parser::GetCurlyListProperty(const curly_list_type* parent_map_ptr, std::string_view prop_name)
 	{
-		auto shptr = GetPropertyValue(parent_map_ptr, prop_name);
+		return AsCurlyList(GetPropertyValue(parent_map_ptr, prop_name));
+	}
 
-		if (shptr)
+	square_list_type* Parser::AsSquareList(value_ptr valPtr)
+	{
+		if (valPtr && valPtr->type == ValueEnum::SquareList)
 		{
-			return AsCurlyList(shptr);
+			return &static_cast<SquareList*>(valPtr)->values;
 		}
 		else return nullptr;
 	}
 
-	square_list_type* Parser::AsSquareList(std::shared_ptr<Value>& valPtr)
+	square_list_type* Parser::GetSquareListProperty(const curly_list_type* parent_map_ptr, std::string_view prop_name)
 	{
-		auto fred = std::dynamic_pointer_cast<SquareList>(valPtr);
+		return AsSquareList(GetPropertyValue(parent_map_ptr, prop_name));
+	}
 
-		if (fred)
+	NameValue* Parser::AsNameValue(value_ptr valPtr)
+	{
+		if (valPtr && valPtr->type == ValueEnum::NameValuePair)
 		{
-			auto& george = fred->values;
-			return &george;
+			return static_cast<NameValue*>(valPtr);
 		}
 		else return nullptr;
 	}
 
-
-	square_list_type* Parser::GetSquareListProperty(const curly_list_type* parent_map_ptr, const std::string prop_name)
+	SimpleValue* Parser::AsSimpleValue(value_ptr valPtr)
 	{
-		auto shptr = GetPropertyValue(parent_map_ptr, prop_name);
+		// Everything but the lists and pairs is a simple value
 
-		if (shptr)
+		if (valPtr && !valPtr->is_curly_list() && !valPtr->is_square_list() && !valPtr->is_pair())
 		{
-			return AsSquareList(shptr);
+			return static_cast<SimpleValue*>(valPtr);
 		}
-		else
-		{
-			return nullptr;
-		}
-	}
-
-	std::shared_ptr<NameValue> Parser::AsNameValue(std::shared_ptr<Value>& valPtr)
-	{
-		return std::dynamic_pointer_cast<NameValue>(valPtr);
-	}
-
-
-	std::shared_ptr<SimpleValue> Parser::AsSimpleValue(std::shared_ptr<Value>& valPtr)
-	{
-		return std::dynamic_pointer_cast<SimpleValue>(valPtr);
+		else return nullptr;
 	}
 
-	std::shared_ptr<Value> Parser::GetPropertyValue(const curly_list_type* parent_map_ptr, const std::string prop_name)
+	value_ptr Parser::GetPropertyValue(const curly_list_type* parent_map_ptr, std::string_view prop_name)
 	{
-		// NOTE: We don't use at() because it throws a std::out_of_range exception if key not found.
-		// While you can catch this exception just fine, the problem is VS still shows in the debug
-		// output window which is annoying. So we do things the tedious way here.
-
 		auto search = parent_map_ptr->find(prop_name);
 
 		if (search != parent_map_ptr->end())
@@ -318,16 +356,13 @@ namespace bryx
 		}
 	}
 
-	std::optional<std::string> Parser::GetSimpleProperty(const curly_list_type* parent_map_ptr, const std::string prop_name)
+	std::optional<std::string> Parser::GetSimpleProperty(const curly_list_type* parent_map_ptr, std::string_view prop_name)
 	{
-		auto shptr = GetPropertyValue(parent_map_ptr, prop_name);
+		auto svptr = AsSimpleValue(GetPropertyValue(parent_map_ptr, prop_name));
 
-		if (shptr)
+		if (svptr)
 		{
-			auto qq = std::dynamic_pointer_cast<SimpleValue>(shptr);
-			auto svptr = qq.get();
-			auto& tkn = svptr->tkn;
-			return tkn->to_string();
+			return svptr->tkn->to_string();
 		}
 		else
 		{
@@ -335,6 +370,17 @@ namespace bryx
 		}
 	}
 
+	void Parser::ResetTree()
+	{
+		// Toss any previous tree in one fell swoop
+
+		root = nullptr;
+		root_map = nullptr;
+		element_stack.clear();
+		member_stack.clear();
+		arena = std::make_unique<ValueArena>(arena_block_size);
+	}
+
 	// ///////////////////////////////////////////////////////////////////////////
 
 	void Parser::LogError(ParserResult result_, std::string msg_, int token_id_)
@@ -545,7 +591,7 @@ namespace bryx
 	{
 		auto result = ParserResult::NoError;
 
-		root_map = 0;
+		ResetTree();
 		curr_token_index = 0;
 
 		lexi.Start();
@@ -710,7 +756,7 @@ namespace bryx
 		return result;
 	}
 
-	ParserResult Parser::CollectCurlyList(std::shared_ptr<Value>& place_holder)
+	ParserResult Parser::CollectCurlyList(value_ptr& place_holder)
 	{
 		// Collect {}-list (aka json objects)
 
@@ -741,16 +787,16 @@ namespace bryx
 				{
 					// Make a pointer to our soon-to-be list (aka object), which may end up empty
 
-					std::shared_ptr<Value> new_list;
+					value_ptr new_list = nullptr;
 
 					// (2) Descend and instantiate new list. 
 					//     Might get instantiated as an empty list if EOF token coming in.
 
 					result = CollectMembers(new_list); // This will magically instantiate list
 
-					// Back from the abyss, so  transfer ownership of list to the place_holder
+					// Back from the abyss, so hand the list to the place_holder
 
-					place_holder = move(new_list);
+					place_holder = new_list;
 				}
 				else
 				{
@@ -764,7 +810,7 @@ namespace bryx
 		return result;
 	}
 
-	ParserResult Parser::CollectSquareList(std::shared_ptr<Value>& place_holder)
+	ParserResult Parser::CollectSquareList(value_ptr& place_holder)
 	{
 		auto result = ParserResult::NoError;
 
@@ -793,23 +839,23 @@ namespace bryx
 
 				//auto new_node = make_unique<BryxCollection>(ValueEnum::List); 
 
-				std::shared_ptr<Value> new_list;
+				value_ptr new_list = nullptr;
 
 				// (2) Descend and instantiate new list. 
 				//     Might get instantiated as an empty list if EOF token index coming in.
 
 				result = CollectElements(new_list); // This will magically instantiate list
 
-				// Back from the abyss, so  transfer ownership of list to the place_holder
+				// Back from the abyss, so hand the list to the place_holder
 
-				place_holder = move(new_list);
+				place_holder = new_list;
 			}
 		}
 
 		return result;
 	}
 
-	ParserResult Parser::CollectValue(std::shared_ptr<Value>& place_holder, bool expect, bool dont_allow_nv_pair)
+	ParserResult Parser::CollectValue(value_ptr& place_holder, bool expect, bool dont_allow_nv_pair)
 	{
 		auto result = ParserResult::NoError;
 
@@ -880,7 +926,7 @@ namespace bryx
 
 						AdvanceToken();
 
-						std::shared_ptr<Value> vp; // Set up pointer to value, initially pointing nowhere.
+						value_ptr vp = nullptr; // Set up pointer to value, initially pointing nowhere.
 
 						// expect value, advance past it, record if fail
 						result = CollectValue(vp, true, true); // (true, true) --> expect value, don't allow another nv_pair
@@ -888,10 +934,7 @@ namespace bryx
 						if (result == ParserResult::NoError)
 						{
 							// We've got all the data we need for our name-value pair.
-							// Make us a smart pointer and move contents into the place holder
-							// Note that the name is in the prev_token.
-							auto nvp = std::make_unique<NameValue>(saved_name, vp);
-							place_holder = move(nvp); // Transfer ownership to place_holder. Ain't C++ fun!
+							place_holder = arena->New<NameValue>(arena->Intern(saved_name), vp);
 						}
 					}
 				}
@@ -905,8 +948,7 @@ namespace bryx
 					// But no worries, it has now become "prev_token", so we can find it there.
 
 					auto t = lexi.prev_token;
-					auto sp = std::make_unique<SimpleValue>(ValueEnum::QuotedString, t); // @@ NEED TO GENERALIZE THIS FOR UNQOUTED POSSIBILITIES TOO
-					place_holder = move(sp); // Transfer ownership to place_holder. Ain't C++ fun!
+					place_holder = arena->NewTracked<SimpleValue>(ValueEnum::QuotedString, t); // @@ NEED TO GENERALIZE THIS FOR UNQOUTED POSSIBILITIES TOO
 					// NO! We've already skipped past this!    AdvanceToken(); // Skip past this simple token
 				}
 
@@ -916,21 +958,18 @@ namespace bryx
 				//auto val_type = tkn->type == TokenEnum::FloatingNumber ? ValueEnum::FloatingNumber : ValueEnum::WholeNumber;
 				//if (tkn->type == TokenEnum::NumberWithUnits) val_type = ValueEnum::NumberWithUnits;
 				auto val_type = ValueEnum::Number;
-				auto sp = std::make_unique<SimpleValue>(val_type, tkn);
-				place_holder = move(sp); // Transfer ownership to place_holder. Ain't C++ fun!
+				place_holder = arena->NewTracked<SimpleValue>(val_type, tkn);
 				AdvanceToken(); // Skip past this simple token
 			}
 			else if (tkn->type == TokenEnum::True || tkn->type == TokenEnum::False)
 			{
 				auto val_type = tkn->type == TokenEnum::True ? ValueEnum::True : ValueEnum::False;
-				auto sp = std::make_unique<SimpleValue>(val_type, tkn);
-				place_holder = move(sp); // Transfer ownership to place_holder. Ain't C++ fun!
+				place_holder = arena->NewTracked<SimpleValue>(val_type, tkn);
 				AdvanceToken(); // Skip past this simple token
 			}
 			else if (tkn->type == TokenEnum::Null)
 			{
-				auto sp = std::make_unique<SimpleValue>(ValueEnum::Null, tkn);
-				place_holder = move(sp); // Transfer ownership to place_holder. Ain't C++ fun!
+				place_holder = arena->NewTracked<SimpleValue>(ValueEnum::Null, tkn);
 				AdvanceToken(); // Skip past this simple token
 			}
 		}
@@ -938,7 +977,7 @@ namespace bryx
 		return result;
 	}
 
-	ParserResult Parser::CollectMembers(std::shared_ptr<Value>& head_ptr)
+	ParserResult Parser::CollectMembers(value_ptr& head_ptr)
 	{
 		// Collect members of a {}-list. By definition, such lists are
 		// implemented as maps, and as such, each element MUST be in
@@ -946,7 +985,8 @@ namespace bryx
 
 		auto result = ParserResult::NoError;
 
-		auto lp = std::make_unique<CurlyList>(MapTypeEnum::Map);
+		auto lp = arena->New<CurlyList>(MapTypeEnum::Map, arena->Resource());
+		auto mark = member_stack.size();
 
 		while (NotAtEnd())
 		{
@@ -965,7 +1005,7 @@ namespace bryx
 			// brace is either a quoted_chars token or the ending brace.
 			// NOTE: only name-value pairs allowed in the list, not just any value.
 
-			std::shared_ptr<NameValue> nvp; // Hopeful pointer to member
+			NameValue* nvp = nullptr; // Hopeful pointer to member
 
 			result = CollectMember(nvp);  // and advance
 
@@ -981,7 +1021,7 @@ namespace bryx
 			else
 			{
 				// Add member to list
-				lp->Insert(nvp);
+				member_stack.push_back(nvp);
 			}
 
 			// We expect either a comma, another start of a member token, or an ending right brace
@@ -1014,9 +1054,12 @@ namespace bryx
 			// Ready for next go 'round
 		}
 
-		// We have our list constructed, so transfer ownership.
+		// We have our members, so move them into the list proper.
+
+		lp->dict.Assign(member_stack.data() + mark, member_stack.size() - mark);
+		member_stack.resize(mark);
 
-		head_ptr = move(lp);
+		head_ptr = lp;
 
 		// @@ BUG FIX: Must set this in case this curly list is the only thing in the file and
 		// we have error on the last member of the curly list.
@@ -1031,7 +1074,7 @@ namespace bryx
 		return result;
 	}
 
-	ParserResult Parser::CollectMember(std::shared_ptr<NameValue>& place_holder)
+	ParserResult Parser::CollectMember(NameValue*& place_holder)
 	{
 		// Collect member of a {}-list.
 		// If member found, it's instantiated, soon to be owned by place_holder.
@@ -1097,7 +1140,7 @@ namespace bryx
 
 					AdvanceToken(); // past separator
 
-					std::shared_ptr<Value> vp; // Set up pointer to value, initially pointing nowhere.
+					value_ptr vp = nullptr; // Set up pointer to value, initially pointing nowhere.
 
 					// expect value, advance past it, record if fail
 					result = CollectValue(vp, true, true);  // (true, true) --> expect value, but don't allow another nv pair
@@ -1105,10 +1148,7 @@ namespace bryx
 					if (result == ParserResult::NoError)
 					{
 						// We've got all the data we need for our name-value pair.
-						// Make us a smart pointer and move contents into the place holder
-						// Note that the name is in the prev_token.
-						auto nvp = std::make_unique<NameValue>(saved_name, vp);
-						place_holder = move(nvp); // Transfer ownership to place_holder. Ain't C++ fun!
+						place_holder = arena->New<NameValue>(arena->Intern(saved_name), vp);
 					}
 				}
 			}
@@ -1117,13 +1157,14 @@ namespace bryx
 		return result;
 	}
 
-	ParserResult Parser::CollectElements(std::shared_ptr<Value>& head_ptr)
+	ParserResult Parser::CollectElements(value_ptr& head_ptr)
 	{
 		// Collect elements of a []-list (aka json array)
 
 		auto result = ParserResult::NoError;
 
-		auto lp = std::make_unique<SquareList>();
+		auto lp = arena->New<SquareList>(arena->Resource());
+		auto mark = element_stack.size();
 
 		while (NotAtEnd())
 		{
@@ -1137,7 +1178,7 @@ namespace bryx
 			// We may have one or more value, or possibly none. So next token after
 			// opening bracket might be an ending bracket.
 
-			std::shared_ptr<Value> ep; // Hopeful pointer to element
+			value_ptr ep = nullptr; // Hopeful pointer to element
 
 			result = CollectElement(ep);  // advances too
 
@@ -1153,7 +1194,7 @@ namespace bryx
 			else
 			{
 				// Add element to list
-				lp->Add(ep);
+				element_stack.push_back(ep);
 			}
 
 			// We expect either a comma, the start of another member element or a right square bracket
@@ -1186,9 +1227,12 @@ namespace bryx
 			// Ready for next go 'round
 		}
 
-		// We have our list constructed, so transfer ownership.
+		// We have our elements, so copy them into the list at their final size.
+
+		lp->values.assign(element_stack.begin() + mark, element_stack.end());
+		element_stack.resize(mark);
 
-		head_ptr = move(lp);
+		head_ptr = lp;
 
 		// @@ BUG FIX: Must set this in case this array is the only thing in the file and
 		// we have error on the last element of the array.
@@ -1203,7 +1247,7 @@ namespace bryx
 		return result;
 	}
 
-	ParserResult Parser::CollectElement(std::shared_ptr<Value>& place_holder)
+	ParserResult Parser::CollectElement(value_ptr& place_holder)
 	{
 		// Collect element of a []-list.
 		// If element found, it's instantiated, soon to be owned by place_holder.
@@ -1235,15 +1279,15 @@ namespace bryx
 
 			// Not at end of list, so expecting a value. We allow whitespace to come first.
 
-			std::shared_ptr<Value> vp; // Set up pointer to value, initially pointing nowhere.
+			value_ptr vp = nullptr; // Set up pointer to value, initially pointing nowhere.
 
 			// expect value, advance past it, record if fail. Allows whitespace intially.
 			result = CollectValue(vp, true);
 
 			if (result == ParserResult::NoError)
 			{
-				// We got our precious value, move it into our place holder
-				place_holder = move(vp);
+				// We got our precious value, hand it to our place holder
+				place_holder = vp;
 			}
 		}
 
@@ -1278,7 +1322,7 @@ namespace bryx
 		{
 			case ValueEnum::QuotedString:   // Bryx string
 			{
-				auto& sv = dynamic_cast<const SimpleValue&>(jv);
+				auto& sv = static_cast<const SimpleValue&>(jv);
 				auto& txt = sv.tkn->to_string();
 
 				if (lexi.StringNeedsQuotes(txt))
@@ -1293,7 +1337,7 @@ namespace bryx
 			break;
 			case ValueEnum::UnquotedString:   // Bryx string
 			{
-				auto& sv = dynamic_cast<const SimpleValue&>(jv);
+				auto& sv = static_cast<const SimpleValue&>(jv);
 				auto& txt = sv.tkn->to_string();
 				if (lexi.StringNeedsQuotes(txt)) // @@ Don't techinically need this here
 				{
@@ -1307,7 +1351,7 @@ namespace bryx
 			break;
 			case ValueEnum::Number:    // Bryx number
 			{
-				auto& sv = dynamic_cast<const SimpleValue&>(jv);
+				auto& sv = static_cast<const SimpleValue&>(jv);
 				auto& txt = sv.tkn->to_string();
 
 				if (lexi.NeedsQuotes(sv.tkn))
@@ -1334,7 +1378,7 @@ namespace bryx
 			break;
 			case ValueEnum::NameValuePair:  // Bryx name value pair (deprecated)
 			{
-				auto& nvpair = dynamic_cast<const NameValue&>(jv);
+				auto& nvpair = static_cast<const NameValue&>(jv);
 				auto& n = nvpair.pair.first; // name (string)
 
 				if (lexi.StringNeedsQuotes(n))
@@ -1348,7 +1392,7 @@ namespace bryx
 
 				sout << ' ' << lexi.NVSeparator() << ' ';
 
-				const auto& legs = *nvpair.pair.second; // val (unique ptr to Value)
+				const auto& legs = *nvpair.pair.second; // val (pointer to Value)
 
 				int indentpp = indent + indent_amt;
 
@@ -1357,7 +1401,7 @@ namespace bryx
 			break;
 			case ValueEnum::CurlyList:       // Bryx object
 			{
-				auto& jvobj = dynamic_cast<const CurlyList&>(jv);
+				auto& jvobj = static_cast<const CurlyList&>(jv);
 				auto& dict = jvobj.dict;
 
 				if (dict.size() == 0)
@@ -1397,7 +1441,7 @@ namespace bryx
 			break;
 			case ValueEnum::SquareList:          // Bryx array
 			{
-				auto& jvarr = dynamic_cast<const SquareList&>(jv);
+				auto& jvarr = static_cast<const SquareList&>(jv);
 				const auto& vs = jvarr.values;
 
 				if (vs.size() == 0)
@@ -31,8 +31,10 @@
 #include <map>
 #include <unordered_map>
 #include <optional>
+#include <memory_resource>
 #include "BryxLexi.h"
 #include "MapTypeEnum.h"
+#include "ValueArena.h"
 
 namespace bryx
 {
@@ -52,7 +54,8 @@ namespace bryx
 		CannotDetermineSyntaxMode,
 		FileOpenError,
 		Unsupported,
-		UnexpectedEOT
+		UnexpectedEOT,
+		StoppedByHandler
 	};
 
 	extern std::string to_string(ParserResult result);
@@ -145,7 +148,12 @@ namespace bryx
 
 	// ////////////////////////////////////////////////////////////////////////
 
-	// WARNING! Have to make this struct or msvc compiler complains when using polymorphic make_unique() construction
+	// Parse tree nodes are owned by the parser's ValueArena. A value_ptr
+	// is just a handle; it's good for as long as the parser's tree is.
+
+	using value_ptr = Value*;
+
+	// ////////////////////////////////////////////////////////////////////////
 
 	struct SimpleValue : Value {
 	public:
@@ -172,38 +180,59 @@ namespace bryx
 		token_ptr CompatibleWithNumber();
 	};
 
-	using nv_type = std::pair<const std::string, std::shared_ptr<Value>>;
+	// The name is interned in the arena, so it's shared by all the
+	// pairs that happen to use it.
 
-	// WARNING! Have to make this struct or msvc compiler complains when using polymorphic make_unique() construction
+	struct nv_type {
+		const std::string& first;
+		value_ptr second;
+	};
 
 	struct NameValue : Value {
 	public:
 		nv_type pair;
 	public:
-		NameValue(const std::string& name_, std::shared_ptr<Value>& val_);
+		NameValue(const std::string& interned_name_, value_ptr val_);
 		virtual ~NameValue();
 	};
 
-	// WARNING! Have to make this struct or msvc compiler complains when using polymorphic make_unique() construction
-
-	using square_list_type = std::vector<std::shared_ptr<Value>>;
+	using square_list_type = std::pmr::vector<value_ptr>;
 
 	struct SquareList : Value {
 	public:
 		square_list_type values;
 	public:
-		SquareList();
+		explicit SquareList(std::pmr::memory_resource* mr_);
 		virtual ~SquareList();
-	public:
-		void Add(std::shared_ptr <Value>& v);
 	};
 
-	// NOTE: Even though map below is typed to store "strings" for values, what are really
-	// stored are const strings, or at least that's what you get back.
+	// A {}-list is a flat array of name-value pairs, sorted by name, so
+	// lookups are a binary search. Like the std::map it replaces, the
+	// first of any duplicate names wins.
+
+	class FlatDict {
+	public:
+
+		using entries_type = std::pmr::vector<nv_type>;
+		using const_iterator = entries_type::const_iterator;
+
+		entries_type entries;
+
+	public:
+
+		explicit FlatDict(std::pmr::memory_resource* mr_) : entries(mr_) { }
 
-	using curly_list_type = std::map<std::string, std::shared_ptr<Value>>;
+		const_iterator begin() const { return entries.begin(); }
+		const_iterator end() const { return entries.end(); }
+		size_t size() const { return entries.size(); }
+		bool empty() const { return entries.empty(); }
 
-	// WARNING! Have to make this struct or msvc compiler complains when using polymorphic make_unique() construction
+		const_iterator find(std::string_view name) const;
+
+		void Assign(NameValue** members, size_t n);
+	};
+
+	using curly_list_type = FlatDict;
 
 	struct CurlyList : Value {
 	public:
@@ -213,8 +242,9 @@ namespace bryx
 
 	public:
 
-		CurlyList(MapTypeEnum map_code_)
+		CurlyList(MapTypeEnum map_code_, std::pmr::memory_resource* mr_)
 		: Value(ValueEnum::CurlyList)
+		, dict(mr_)
 		, map_code(map_code_)
 		{
 			//std::cout << "CurlyList default ctor called\n";
@@ -224,26 +254,9 @@ namespace bryx
 		{
 			//std::cout << "CurlyList dtor called\n";
 		}
-
-		void Insert(std::shared_ptr<NameValue>& nvp)
-		{
-			if (map_code == MapTypeEnum::Raw)
-			{
-				//values.push_back(move(nvp));
-				//values.emplace_back(move(nvp->pair));
-			}
-			else
-			{
-				// for map only: malwares[nvp->name] = std::move(nvp->val);
-				// emplace works for all other types except vectors
-				dict.emplace(move(nvp->pair));
-			}
-		}
 	};
 
 
-
-
 	// ////////////////////////////////////////////////////////////////////////
 	//
 	// Parser
@@ -257,11 +270,23 @@ namespace bryx
 
 		ParserResultPkg last_parser_error;
 
-		std::shared_ptr<Value> root;
+		std::unique_ptr<ValueArena> arena; // Owns the whole parse tree
+		size_t arena_block_size;
+
+		value_ptr root;
 		curly_list_type* root_map; // Only valid if we start out with a curly list!
 
+		// Children of the lists currently being collected. Each list pops
+		// its own children off the top when done and copies them into
+		// the arena at their final size.
+
+		std::vector<value_ptr> element_stack;
+		std::vector<NameValue*> member_stack;
+
 		std::string file_moniker;
 
+		std::string source_text; // What LoadFile() read in, for the lexer to work out of
+
 		int curr_token_index;
 
 		bool dfx_mode;
@@ -275,6 +300,7 @@ namespace bryx
 		virtual ~Parser();
 
 		ParserResult LoadFile(std::string_view& fname);
+		ParserResult LoadBuffer(std::string_view text);
 
 		void SetStreamBuf(std::streambuf* sb_)
 		{
@@ -295,21 +321,22 @@ namespace bryx
 
 		// This stuff is useful when "reading" the loaded parse tree
 
-		static const curly_list_type* AsCurlyList(const std::shared_ptr<Value>& valPtr);
-		static curly_list_type* AsCurlyList(std::shared_ptr<Value>& valPtr);
+		static const curly_list_type* AsCurlyList(const Value* valPtr);
+		static curly_list_type* AsCurlyList(value_ptr valPtr);
+
+		static value_ptr GetPropertyValue(const curly_list_type* parent_map_ptr, std::string_view prop_name);
 
-		static std::shared_ptr<Value> GetPropertyValue(const curly_list_type* parent_map_ptr, const std::string prop_name);
+		static curly_list_type* GetCurlyListProperty(const curly_list_type* parent_map_ptr, std::string_view prop_name);
 
-		static curly_list_type* GetCurlyListProperty(const curly_list_type* parent_map_ptr, const std::string prop_name);
+		static square_list_type* AsSquareList(value_ptr valPtr);
+		static square_list_type* GetSquareListProperty(const curly_list_type* parent_map_ptr, std::string_view prop_name);
 
-		static square_list_type* AsSquareList(std::shared_ptr<Value>& valPtr);
-		static square_list_type* GetSquareListProperty(const curly_list_type* parent_map_ptr, const std::string prop_name);
+		static NameValue* AsNameValue(value_ptr valPtr);
 
-		static std::shared_ptr<NameValue> AsNameValue(std::shared_ptr<Value>& valPtr);
-		// @@ problematic: static std::optional<NameValue> GetNameValueProperty(const curly_list_type* parent_map_ptr, const std::string prop_name);
+		static SimpleValue* AsSimpleValue(value_ptr valPtr);
+		static std::optional<std::string> GetSimpleProperty(const curly_list_type* parent_map_ptr, std::string_view prop_name);
 
-		static std::shared_ptr<SimpleValue> AsSimpleValue(std::shared_ptr<Value>& valPtr);
-		static std::optional<std::string> GetSimpleProperty(const curly_list_type* parent_map_ptr, const std::string prop_name);
+		void ResetTree();
 
 	public:
 
@@ -355,14 +382,14 @@ namespace bryx
 		virtual ParserResult Preparse();
 		virtual ParserResult Parse();
 
-		ParserResult CollectCurlyList(std::shared_ptr<Value>& place_holder);
-		ParserResult CollectSquareList(std::shared_ptr<Value>& place_holder);
-		ParserResult CollectValue(std::shared_ptr<Value>& place_holder, bool expect, bool dont_allow_nv_pair = false);
-		ParserResult CollectMembers(std::shared_ptr<Value>& head_ptr);
-		ParserResult CollectMember(std::shared_ptr<NameValue>& place_holder);
+		ParserResult CollectCurlyList(value_ptr& place_holder);
+		ParserResult CollectSquareList(value_ptr& place_holder);
+		ParserResult CollectValue(value_ptr& place_holder, bool expect, bool dont_allow_nv_pair = false);
+		ParserResult CollectMembers(value_ptr& head_ptr);
+		ParserResult CollectMember(NameValue*& place_holder);
 
-		ParserResult CollectElements(std::shared_ptr<Value>& head_ptr);
-		ParserResult CollectElement(std::shared_ptr<Value>& place_holder);
+		ParserResult CollectElements(value_ptr& head_ptr);
+		ParserResult CollectElement(value_ptr& place_holder);
 
 	public:
 
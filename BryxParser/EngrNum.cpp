@@ -418,6 +418,13 @@ namespace bryx
 					std::memset(q, 0, len); // ensures null-termination too
 #endif
 				}
+				else
+				{
+					// Only the one digit. Clear out whatever was left behind
+					// it, so the decimal point adjustment doesn't pick it up.
+					char* q = new_mantissa + 1;
+					std::memset(q, 0, mantissa + ndigits_reserved + 1 - q);
+				}
 
 			}
 		}
@@ -801,7 +808,7 @@ namespace bryx
 			// Parse the metric prefix
 			char pfx = src[y];
 
-			auto idx = mpfx_parse_tree.MetricPrefixIndex(pfx);
+			auto idx = mpfx_table.MetricPrefixIndex(pfx);
 
 			if (idx != -1)
 			{
@@ -833,7 +840,7 @@ namespace bryx
 
 		n = static_cast<int>(src.length());
 
-		if (x < ndigits_reserved) // Does not include null
+		if (n <= ndigits_reserved) // Does not include null
 		{
 			std::memcpy(mantissa, src.data(), n);
 			mantissa[n] = 0;
@@ -861,7 +868,7 @@ namespace bryx
 
 		if (number_tkn_ptr)
 		{
-			*this = number_tkn_ptr->engr_num;
+			*this = number_tkn_ptr->Engr();
 		}
 		else
 		{
@@ -1,4 +1,5 @@
 #include "Units.h"
+#include <cmath>
 
 /******************************************************************************\
  * Bryx - "Bryan exchange format" - source code
@@ -81,13 +82,32 @@ namespace bryx
 
         if (index != -1)
         {
-            return children.at(index).id; // The enumerated pfx in integer form
+            return nodes[index].id; // The enumerated pfx in integer form
         }
         else return -1;
     }
 
     const MpfxParseTree mpfx_parse_tree(metric_db);
 
+    MpfxTable::MpfxTable(const std::vector<metric_db_elem>& pfx_list)
+    {
+        std::fill(std::begin(index), std::end(index), static_cast<signed char>(-1));
+
+        for (auto& e : pfx_list)
+        {
+            auto idx = static_cast<int>(e.prefix);
+
+            if (e.moniker.length() == 1)
+            {
+                index[static_cast<unsigned char>(e.moniker[0])] = static_cast<signed char>(idx);
+            }
+
+            scale[idx] = std::pow(10.0, std::abs(e.tens_exp));
+        }
+    }
+
+    const MpfxTable mpfx_table(metric_db);
+
 
     // /////////////////////////////////////////////////
 
@@ -80,11 +80,6 @@ namespace bryx
 
         virtual ~MpfxParseTree() = default;
 
-        virtual std::shared_ptr<SymTree> MakeNewTree()
-        {
-            return std::make_shared<MpfxParseTree>();
-        }
-
         void add_pfxname(std::string_view s, MetricPrefixEnum pfx)
         {
             SymTree::addkey(s, static_cast<int>(pfx));
@@ -102,6 +97,37 @@ namespace bryx
 
     extern const MpfxParseTree mpfx_parse_tree;
 
+    // /////////////////////////////////////////////
+    // Flat lookup of the single character metric
+    // prefixes, for when we're parsing numbers and
+    // just want the answer for one character. Also
+    // holds the exact power of ten for each prefix.
+
+    class MpfxTable {
+    public:
+
+        signed char index[256];  // Index into metric_db, or -1 if not a prefix
+        double scale[static_cast<int>(MetricPrefixEnum::Count)];
+
+    public:
+
+        explicit MpfxTable(const std::vector<metric_db_elem>& pfx_list);
+
+        int MetricPrefixIndex(char c) const
+        {
+            return index[static_cast<unsigned char>(c)];
+        }
+
+        double Scale(double x, int idx) const
+        {
+            // Dividing by 10^3 rounds better than multiplying by 10^-3
+
+            return metric_db[idx].tens_exp < 0 ? x / scale[idx] : x * scale[idx];
+        }
+    };
+
+    extern const MpfxTable mpfx_table;
+
     enum class UnitEnum
     {
         DB, 
@@ -184,11 +210,6 @@ namespace bryx
 
         virtual ~UnitParseTree() = default;
 
-        virtual std::shared_ptr<SymTree> MakeNewTree()
-        {
-            return std::make_shared<UnitParseTree>();
-        }
-
         void add_unitname(std::string_view s, UnitEnum unit)
         {
             SymTree::addkey(s, static_cast<int>(unit));
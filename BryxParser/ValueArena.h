@@ -0,0 +1,125 @@
+#pragma once
+
+/******************************************************************************\
+ * DFX - "Drum font exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This software helps facilitate the real-time playing of multi-layered drum
+ * samples, by implementing a language that specifies a master directory of the
+ * the sample wave files for a drum kit: where the samples are, what they are
+ * for, and a summary of their properties. The DFX format allows modifications
+ * of sample levels to achieve a unified, pleasing mix of sounds. Mechanisms
+ * such as velocity layers and round robins are supported for this purpose.
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate DFX files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace bryx
+{
+	class Value;
+
+	// ///////////////////////////////////////////////////////////////////////////
+	// The parse tree nodes all live in one of these. Nodes are carved out of a
+	// monotonic buffer and never freed one at a time. The names of name-value
+	// pairs are interned, so a font with a thousand robins has just one "fname"
+	// string. Releasing the arena releases the whole tree in one go.
+	// ///////////////////////////////////////////////////////////////////////////
+
+	class ValueArena {
+	public:
+
+		static constexpr size_t DefaultBlockSize = 64 * 1024;
+
+		std::pmr::monotonic_buffer_resource pool;
+
+		std::unordered_set<std::string> names;  // Interned names. Node based, so references stay put.
+
+		std::vector<Value*> tracked;            // Nodes holding things outside the arena (ie. tokens)
+
+		size_t bytes_allocated;
+		size_t nodes_allocated;
+
+	public:
+
+		explicit ValueArena(size_t initial_block_size = DefaultBlockSize)
+		: pool(initial_block_size)
+		, names()
+		, tracked()
+		, bytes_allocated(0)
+		, nodes_allocated(0)
+		{
+		}
+
+		ValueArena(const ValueArena&) = delete;
+		ValueArena& operator=(const ValueArena&) = delete;
+
+		~ValueArena()
+		{
+			Release();
+		}
+
+		std::pmr::memory_resource* Resource()
+		{
+			return &pool;
+		}
+
+		template<class T, class... Args>
+		T* New(Args&&... args)
+		{
+			// For nodes whose storage is all in the arena. Their
+			// destructors never get called.
+
+			void* mem = pool.allocate(sizeof(T), alignof(T));
+			bytes_allocated += sizeof(T);
+			++nodes_allocated;
+			return ::new (mem) T(std::forward<Args>(args)...);
+		}
+
+		template<class T, class... Args>
+		T* NewTracked(Args&&... args)
+		{
+			// For nodes that own something outside the arena. We
+			// run their destructors when the arena is released.
+
+			auto p = New<T>(std::forward<Args>(args)...);
+			tracked.push_back(p);
+			return p;
+		}
+
+		const std::string& Intern(const std::string& name)
+		{
+			return *names.insert(name).first;
+		}
+
+		void Release();
+	};
+
+}; // end of namespace
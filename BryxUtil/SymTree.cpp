@@ -25,129 +25,123 @@
  *
 \******************************************************************************/
 
+#include <algorithm>
 #include "SymTree.h"
 
 namespace bryx
 {
-	int SymTree::add_internal(char c)
+	SymTree::SymTree()
 	{
-		children.push_back(SymElem(c));
-		return static_cast<int>(children.size()) - 1;
+		build();
 	}
 
-	int SymTree::add_leaf(char c, int id)
-	{
-		children.push_back(SymElem(c, id));
-		return static_cast<int>(children.size()) - 1;
-	}
-
-	int SymTree::find_index(char c_) const
+	void SymTree::addkey(std::string_view key, int id)
 	{
-		int index = -1;
+		if (key.empty()) return;
 
-		auto it = std::find_if(children.begin(), children.end(),
-			[c_](const SymElem& x)
+		auto it = std::lower_bound(keys.begin(), keys.end(), key,
+			[](const std::pair<std::string, int>& x, std::string_view k)
 			{
-				return x.c == c_;
+				return x.first < k;
 			});
 
-		if (it != children.end())
+		if (it != keys.end() && it->first == key)
 		{
-			index = static_cast<int>(std::distance(children.begin(), it));
+			// Already there. What to do? Replace the id?
+			// For now, that's what we'll do
+			it->second = id;
 		}
+		else keys.insert(it, std::make_pair(std::string(key), id));
 
-		return index;
+		build();
 	}
 
-	int SymTree::insert_internal(char c)
+	void SymTree::build()
 	{
-		// ASSUMES there are more characters coming after c.
-		// This is very important!
-
-		int index = find_index(c);
+		// Lay the tree out breadth first, so that all the children of a
+		// node get appended to the node array together. Each node covers
+		// the range of (sorted) keys that share its prefix. Within that
+		// range, the keys that end right at the node come first, then the
+		// keys are grouped by their next character.
 
-		if (index == -1)
-		{
-			// Not already there
-			index = add_internal(c);
-			auto new_tree = MakeNewTree();
-			children.at(index).child = new_tree;
-		}
-		else
+		struct Pending
 		{
-			// Already there, but there may not be a new tree
-			// for the next char which we ASSUME is coming.
-			// So create that new tree
+			int node;
+			size_t b, e;  // Range of keys sharing this node's prefix
+			size_t depth; // Length of that prefix
+		};
 
-			auto p = children.at(index).child;
-			if (!p)
-			{
-				p = MakeNewTree();
-				children.at(index).child = p;
-			}
-		}
+		nodes.clear();
+		nodes.emplace_back();
 
-		return index;
-	}
-
-	int SymTree::insert_leaf(char c, int id)
-	{
-		int index = find_index(c);
+		std::vector<Pending> queue;
+		queue.push_back({ 0, 0, keys.size(), 0 });
 
-		if (index == -1)
+		for (size_t q = 0; q < queue.size(); q++)
 		{
-			// Not already there
-			index = add_leaf(c, id);
-		}
-		else
-		{
-			// Already there. Now, its id might be different from the
-			// stored id. In particular, the stored id might be -1,
-			// which means this element wasn't the "end" of a valid
-			// key, but merely a prefix. If id == -1, then it should
-			// be the case that child is not a nullptr. @@ ASSERT THIS?
+			auto pending = queue[q];
 
-			auto& elem = children.at(index);
+			size_t i = pending.b;
 
-			if (elem.id == -1)
+			while (i < pending.e && keys[i].first.length() == pending.depth)
 			{
-				// @@ TODO: ASSERT Child not null?
-				elem.id = id;
+				++i; // Ends at this node. Its id was set when the node was made.
 			}
-			else
+
+			nodes[pending.node].first_child = static_cast<int>(nodes.size());
+
+			while (i < pending.e)
 			{
-				// @@ TODO:
-				// What to do? Replace the id?
-				// For now, that's what we'll do
+				char c = keys[i].first[pending.depth];
+
+				size_t j = i + 1;
+				while (j < pending.e && keys[j].first[pending.depth] == c) ++j;
+
+				// If a key ends on this character, it sorts first in the group
+
+				int id = keys[i].first.length() == pending.depth + 1 ? keys[i].second : -1;
 
-				elem.id = id;
+				int child = static_cast<int>(nodes.size());
+				nodes.emplace_back(c, id);
+				nodes[pending.node].nchildren++;
+
+				queue.push_back({ child, i, j, pending.depth + 1 });
+
+				i = j;
 			}
 		}
 
-		return index;
+		std::fill(std::begin(first_char), std::end(first_char), -1);
+
+		auto& root = nodes[0];
+
+		for (int k = 0; k < root.nchildren; k++)
+		{
+			int child = root.first_child + k;
+			first_char[static_cast<unsigned char>(nodes[child].c)] = child;
+		}
 	}
 
-	void SymTree::addkey(std::string_view key, int id)
+	int SymTree::find_index(char c_) const
 	{
-		auto n = key.length();
+		// Returns the node for the first character of a key, or -1
 
-		auto tp = this;
+		return first_char[static_cast<unsigned char>(c_)];
+	}
 
-		for (size_t i = 0; i < n; i++)
-		{
-			auto c = key[i];
+	int SymTree::find_child(int node, char c_) const
+	{
+		auto& elem = nodes[node];
 
-			if (i < n - 1)
-			{
-				auto idx = tp->insert_internal(c);
-				auto p = tp->children.at(idx).child;
-				tp = p.get();
-			}
-			else
-			{
-				auto idx = tp->insert_leaf(c, id);
-			}
+		auto p = nodes.data() + elem.first_child;
+		auto e = p + elem.nchildren;
+
+		for (; p != e; ++p)
+		{
+			if (p->c == c_) return static_cast<int>(p - nodes.data());
 		}
+
+		return -1;
 	}
 
 	int SymTree::search(std::string_view candy_key) const
@@ -157,69 +151,35 @@ namespace bryx
 
 		auto n = candy_key.length();
 
-		auto tp = this;
+		if (n == 0) return -1;
 
-		int id = -1;
+		int node = find_index(candy_key[0]);
 
-		for (size_t i = 0; i < n; i++)
+		for (size_t i = 1; i < n && node != -1; i++)
 		{
-			auto c = candy_key[i];
-
-			int index = tp->find_index(c);
-
-			if (index == -1)
-			{
-				// Didn't find character, so we've failed
-				id = -1;
-				break;
-			}
-			else
-			{
-				// The character was found. Now, if it's the last character in
-				// our key, then the corresponding element in the 
-				// tree better have a non-negative id, which is our signal that
-				// we've reached a valid end of a key. Note that the element may
-				// also have a child, which means that we are at a valid key
-				// end which is also a prefix of another valid key.
-				// If, however, the id *is* negative, it means we're not at a
-				// valid key end, so our key is for sure just a
-				// prefix of another valid key.
-				// The upshot is this: Test for a non-negative id. If we find
-				// one, our search is a success. Otherwise, not.
-				// 
-
-				auto& elem = tp->children.at(index);
-
-				if (i == n - 1)
-				{
-					id = elem.id;  // sign of id tells the tale
-					break;
-				}
-
-				// Alrighty then, we should sally forth with the
-				// rest of the characters in the string
-
-				tp = elem.child.get();
-
-				if (!tp)
-				{
-					// Well, according to the tree, there are no more characters
-					// in the stored key, yet clearly we have more characters
-					// in our candidate key, so this means there is no match.
-					// We've only got a partial match, which is an error for now.
-					id = -1; 
-					break;
-				}
-			}
+			node = find_child(node, candy_key[i]);
 		}
 
-		return id;
+		// If we've run out of characters on a node that isn't the end of
+		// a valid key, our key is just a prefix of another key. The sign
+		// of the id tells the tale.
+
+		return node == -1 ? -1 : nodes[node].id;
 	}
 
 	void SymTree::print(std::ostream& sout, int indent) const
 	{
-		for (auto& v : children)
+		print_node(sout, 0, indent);
+	}
+
+	void SymTree::print_node(std::ostream& sout, int node, int indent) const
+	{
+		auto& elem = nodes[node];
+
+		for (int k = 0; k < elem.nchildren; k++)
 		{
+			auto& v = nodes[elem.first_child + k];
+
 			for (int i = 0; i < indent; i++) sout << '.';
 
 			sout << "'" << v.c << "'";
@@ -233,10 +193,7 @@ namespace bryx
 
 			sout << '\n';
 
-			if (v.child)
-			{
-				v.child->print(sout, indent + 3);
-			}
+			print_node(sout, elem.first_child + k, indent + 3);
 		}
 	}
 
@@ -30,58 +30,61 @@
 
 #include <iostream>
 #include <vector>
+#include <string>
 #include <string_view>
+#include <utility>
 
 // /////////////////////////////////////////////////////
 // Symbol tree support:
 // Supports mapping from a string key to an int.
 // This is for unique keys only. Implements a low
-// overhead, multi-way tree. Probably faster than
-// the usual map algs for the purposes I need them,
-// (mapping unit names into unit codes.) In such a 
-// database, each level of the tree will probably not
-// have many elements, so a brute-force searching 
-// through those elements is likely to be fast. Much
-// faster than hashing or walking a binary tree.
+// overhead, multi-way tree, flattened into one
+// contiguous array of nodes. The children of a node
+// sit next to each other in that array, sorted by
+// character, and the first character of a key is
+// found with a 256 entry jump table. So a search
+// never allocates and touches very little memory.
+// In such a database (mapping unit names into unit
+// codes), each level of the tree will probably not
+// have many elements, so a brute-force searching
+// through those elements is likely to be fast.
+// Adding a key rebuilds the node array, which is
+// fine for the few dozen keys we have, all added
+// up front.
  
 namespace bryx
 {
-	class SymTree;
-
-	struct SymElem
+	struct SymNode
 	{
-		std::shared_ptr<SymTree> child;
-		int id; // It's important that an id == -1 means "not at the end of a valid key"
+		int first_child; // Index of first child in the node array. The rest follow it.
+		int nchildren;
+		int id;          // It's important that an id == -1 means "not at the end of a valid key"
 		char c;
 
-		SymElem() : child(nullptr), id(-1), c(0) { }
-		explicit SymElem(char c_, int id_ = -1) : child(nullptr), id(id_), c(c_) { }
-
+		SymNode() : first_child(0), nchildren(0), id(-1), c(0) { }
+		SymNode(char c_, int id_) : first_child(0), nchildren(0), id(id_), c(c_) { }
 	};
 
 	class SymTree {
 	public:
 
-		std::vector<SymElem> children;
+		std::vector<std::pair<std::string, int>> keys; // Sorted by key
+		std::vector<SymNode> nodes;                    // nodes[0] is the root
+		int first_char[256];                           // Index of root child for each char, or -1
 
 	public:
 
+		SymTree();
 		virtual ~SymTree() = default;
 
-		virtual std::shared_ptr<SymTree> MakeNewTree()
-		{
-			return std::make_shared<SymTree>();
-		}
-
 	protected:
 
-		int add_internal(char c);
-		int add_leaf(char c, int id);
+		void build();
 
 		int find_index(char c_) const;
+		int find_child(int node, char c_) const;
 
-		int insert_internal(char c);
-		int insert_leaf(char c, int id);
+		void print_node(std::ostream& sout, int node, int indent) const;
 
 	public:
 
@@ -0,0 +1,484 @@
+/******************************************************************************\
+ * DFX - "Drum font exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This software helps facilitate the real-time playing of multi-layered drum
+ * samples, by implementing a language that specifies a master directory of the
+ * the sample wave files for a drum kit: where the samples are, what they are
+ * for, and a summary of their properties. The DFX format allows modifications
+ * of sample levels to achieve a unified, pleasing mix of sounds. Mechanisms
+ * such as velocity layers and round robins are supported for this purpose.
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate DFX files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+// A benchmark for the drum font front end. We generate a synthetic font of
+// kits x instruments x layers x robins in either Bryx or Json syntax, then
+// time each stage separately: lexing, parsing, verifying, and building the
+// font. Then we time building the font in one pass, straight from the parse
+// events, for comparison. For each stage we report the rate, heap bytes
+// allocated, and the peak resident set size so far.
+//
+// usage: DfxBench [kits instruments layers robins] [-json] [-reps n] [-o file]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include "DrumFont.h"
+
+#if defined(__OS_WINDOWS__)
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace dfx;
+
+// ///////////////////////////////////////////////////////////////////////////
+// Counting allocator. Every heap allocation in the program goes through here.
+
+static std::atomic<size_t> heap_bytes{ 0 };
+static std::atomic<size_t> heap_allocs{ 0 };
+
+void* operator new(size_t n)
+{
+	heap_bytes += n;
+	++heap_allocs;
+
+	if (void* p = std::malloc(n ? n : 1))
+	{
+		return p;
+	}
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+static size_t PeakRSS()
+{
+#if defined(__OS_WINDOWS__)
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+	{
+		return pmc.PeakWorkingSetSize;
+	}
+	return 0;
+#else
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+	return static_cast<size_t>(ru.ru_maxrss) * 1024; // Linux reports kilobytes
+#endif
+}
+
+// ///////////////////////////////////////////////////////////////////////////
+
+struct BenchSpec
+{
+	int kits = 2;
+	int instruments = 32;
+	int layers = 8;
+	int robins = 8;
+	int reps = 5;
+	bool json = false;
+	std::string out_fname;
+};
+
+class DocWriter {
+public:
+
+	std::ostringstream sout;
+	bool json;
+	int indent;
+
+public:
+
+	explicit DocWriter(bool json_) : sout(), json(json_), indent(0) { }
+
+	void Indent()
+	{
+		for (int i = 0; i < indent; i++) sout << '\t';
+	}
+
+	void Name(const std::string& name)
+	{
+		Indent();
+		if (json) sout << '"' << name << "\" : ";
+		else sout << name << " = ";
+	}
+
+	void Open(char c)
+	{
+		sout << c << '\n';
+		++indent;
+	}
+
+	void Close(char c, bool last)
+	{
+		--indent;
+		Indent();
+		sout << c << (last ? "" : ",") << '\n';
+	}
+
+	void Prop(const std::string& name, const std::string& val, bool last, bool quote = false)
+	{
+		// Numbers with units have to be quoted in json
+
+		Name(name);
+		if (quote || json) sout << '"' << val << '"';
+		else sout << val;
+		sout << (last ? "" : ",") << '\n';
+	}
+
+	void Prop(const std::string& name, int val, bool last)
+	{
+		Name(name);
+		sout << val << (last ? "" : ",") << '\n';
+	}
+};
+
+static std::string MakeDocument(const BenchSpec& spec)
+{
+	DocWriter w(spec.json);
+
+	if (spec.json) w.sout << "\"dfx\" : ";
+	else w.sout << "dfx = ";
+
+	w.Open('{');
+
+	for (int k = 0; k < spec.kits; k++)
+	{
+		w.Name("kit" + std::to_string(k));
+		w.Open('{');
+		w.Prop("path", "kit" + std::to_string(k), false, true);
+		w.Name("instruments");
+		w.Open('{');
+
+		for (int i = 0; i < spec.instruments; i++)
+		{
+			w.Name("drum" + std::to_string(i));
+			w.Open('{');
+			w.Prop("note", i % 128, false);
+			w.Prop("path", "drum" + std::to_string(i), false, true);
+			w.Name("velocities");
+			w.Open('[');
+
+			for (int v = 0; v < spec.layers; v++)
+			{
+				int vel_code = 1 + (v * 127) / spec.layers;
+				w.Name("v" + std::to_string(vel_code));
+				w.Open('{');
+				w.Name("robins");
+				w.Open('[');
+
+				for (int r = 0; r < spec.robins; r++)
+				{
+					std::ostringstream fname;
+					fname << "d" << i << "_v" << vel_code << "_r" << r << ".wav";
+
+					w.Name("r" + std::to_string(r));
+					w.Open('{');
+					w.Prop("fname", fname.str(), false, true);
+					w.Prop("start", 100 + r, false);
+					w.Prop("end", 48000 + r, false);
+					w.Prop("peak", "-" + std::to_string(6 + r % 12) + "dB", false);
+					w.Prop("rms", "-" + std::to_string(20 + r % 12) + "dB", true);
+					w.Close('}', r == spec.robins - 1);
+				}
+
+				w.Close(']', true);
+				w.Close('}', v == spec.layers - 1);
+			}
+
+			w.Close(']', true);
+			w.Close('}', i == spec.instruments - 1);
+		}
+
+		w.Close('}', true);
+		w.Close('}', k == spec.kits - 1);
+	}
+
+	w.Close('}', true);
+
+	return w.sout.str();
+}
+
+// ///////////////////////////////////////////////////////////////////////////
+
+struct StageStats
+{
+	const char* name = "";
+	const char* unit = "";
+	double best_secs = 1e30;
+	size_t items = 0;
+	size_t bytes = 0;
+	size_t allocs = 0;
+	size_t peak_rss = 0;
+};
+
+class StageTimer {
+public:
+
+	StageStats& stats;
+	std::chrono::steady_clock::time_point t0;
+	size_t bytes0;
+	size_t allocs0;
+
+public:
+
+	explicit StageTimer(StageStats& stats_)
+	: stats(stats_)
+	, t0(std::chrono::steady_clock::now())
+	, bytes0(heap_bytes)
+	, allocs0(heap_allocs)
+	{
+	}
+
+	void Stop(size_t items)
+	{
+		auto t1 = std::chrono::steady_clock::now();
+		double secs = std::chrono::duration<double>(t1 - t0).count();
+
+		// Allocation counts don't vary from rep to rep, so the
+		// last one is as good as any
+
+		stats.best_secs = std::min(stats.best_secs, secs);
+		stats.items = items;
+		stats.bytes = heap_bytes - bytes0;
+		stats.allocs = heap_allocs - allocs0;
+		stats.peak_rss = PeakRSS();
+	}
+};
+
+static void Report(std::ostream& sout, const StageStats& s)
+{
+	double rate = s.best_secs > 0 ? s.items / s.best_secs : 0;
+
+	sout << std::left << std::setw(16) << s.name << std::right
+		<< std::fixed << std::setprecision(3)
+		<< std::setw(10) << s.best_secs * 1000.0 << " ms"
+		<< std::setw(12) << s.items << ' ' << std::left << std::setw(7) << s.unit << std::right
+		<< std::setprecision(0)
+		<< std::setw(14) << rate << " /s"
+		<< std::setw(12) << s.bytes << " B heap"
+		<< std::setw(10) << s.allocs << " allocs"
+		<< std::setw(8) << s.peak_rss / (1024 * 1024) << " MB peak"
+		<< std::endl;
+}
+
+static bool ParseArgs(int argc, char* argv[], BenchSpec& spec)
+{
+	int dims[4] = { spec.kits, spec.instruments, spec.layers, spec.robins };
+	int ndims = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+
+		if (arg == "-json")
+		{
+			spec.json = true;
+		}
+		else if (arg == "-reps" && i + 1 < argc)
+		{
+			spec.reps = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (arg == "-o" && i + 1 < argc)
+		{
+			spec.out_fname = argv[++i];
+		}
+		else if (ndims < 4 && std::atoi(arg.c_str()) > 0)
+		{
+			dims[ndims++] = std::atoi(arg.c_str());
+		}
+		else
+		{
+			std::cout << "usage: DfxBench [kits instruments layers robins] [-json] [-reps n] [-o file]" << std::endl;
+			return false;
+		}
+	}
+
+	spec.kits = dims[0];
+	spec.instruments = dims[1];
+	spec.layers = std::min(dims[2], 127); // velocity codes have to fit
+	spec.robins = dims[3];
+
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	BenchSpec spec;
+
+	if (!ParseArgs(argc, argv, spec))
+	{
+		return -1;
+	}
+
+	std::cout << "Generating " << (spec.json ? "json" : "bryx") << " font: "
+		<< spec.kits << " kits x " << spec.instruments << " instruments x "
+		<< spec.layers << " layers x " << spec.robins << " robins" << std::endl;
+
+	auto text = MakeDocument(spec);
+
+	std::cout << "Document size: " << text.size() << " bytes" << std::endl;
+
+	if (!spec.out_fname.empty())
+	{
+		std::ofstream f(spec.out_fname, std::ios_base::out | std::ios_base::binary);
+		f << text;
+	}
+
+	StageStats lex_stream{ "lex (stream)", "tokens" };
+	StageStats lex_buffer{ "lex (buffer)", "tokens" };
+	StageStats parse{ "parse", "nodes" };
+	StageStats verify{ "verify", "nodes" };
+	StageStats build{ "build font", "nodes" };
+	StageStats one_pass{ "one pass build", "nodes" };
+
+	size_t arena_bytes = 0;
+
+	std::ostream nullout(nullptr); // Swallows the log and the chatter from BuildFont()
+
+	for (int rep = 0; rep < spec.reps; rep++)
+	{
+		{
+			std::stringbuf sb(text);
+			Lexi lexi(&sb);
+			lexi.preserve_white_space = false;
+			lexi.Start();
+
+			StageTimer t(lex_stream);
+			size_t n = 0;
+			while (!lexi.Next()->IsQuitToken()) ++n;
+			t.Stop(n);
+		}
+
+		{
+			Lexi lexi;
+			lexi.preserve_white_space = false;
+			lexi.SetBuffer(text);
+			lexi.Start();
+
+			StageTimer t(lex_buffer);
+			size_t n = 0;
+			while (!lexi.NextSpan().IsQuitToken()) ++n;
+			t.Stop(n);
+		}
+
+		auto df = std::make_unique<DrumFont>();
+		df->StartLog(nullout);
+		df->sound_font_path = spec.json ? "bench.json" : "bench.dfx";
+
+		size_t nodes = 0;
+
+		{
+			StageTimer t(parse);
+			auto rv = df->LoadBuffer(text);
+			nodes = df->arena->nodes_allocated;
+			t.Stop(nodes);
+
+			if (rv != ParserResult::NoError)
+			{
+				std::string_view ctx = "DfxBench";
+				df->PrintError(std::cout, ctx);
+				return -1;
+			}
+
+			arena_bytes = df->arena->bytes_allocated;
+		}
+
+		{
+			StageTimer t(verify);
+			bool ok = df->Verify();
+			t.Stop(nodes);
+
+			if (!ok)
+			{
+				std::cout << "Verify failed with " << df->errcnt << " errors" << std::endl;
+				return -1;
+			}
+		}
+
+		{
+			auto cout_buf = std::cout.rdbuf(nullout.rdbuf());
+			StageTimer t(build);
+			df->BuildFont();
+			t.Stop(nodes);
+			std::cout.rdbuf(cout_buf);
+		}
+
+		df.reset();
+
+		{
+			auto sf = std::make_unique<DrumFont>();
+			sf->StartLog(nullout);
+			sf->sound_font_path = spec.json ? "bench.json" : "bench.dfx";
+
+			StageTimer t(one_pass);
+
+			EventParser ep;
+			DfxEventBuilder builder(nullout, false, "");
+			auto rv = ep.LoadBuffer(text, builder);
+
+			if (rv != ParserResult::NoError || builder.errcnt > 0)
+			{
+				std::cout << "One pass build failed" << std::endl;
+				return -1;
+			}
+
+			sf->BuildFont(builder.kits);
+			t.Stop(nodes);
+		}
+	}
+
+	std::cout << "Best of " << spec.reps << " runs:" << std::endl;
+
+	Report(std::cout, lex_stream);
+	Report(std::cout, lex_buffer);
+	Report(std::cout, parse);
+	Report(std::cout, verify);
+	Report(std::cout, build);
+	Report(std::cout, one_pass);
+
+	std::cout << "Parse tree arena: " << arena_bytes << " bytes" << std::endl;
+
+	return 0;
+}
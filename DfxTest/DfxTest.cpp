@@ -44,6 +44,7 @@ int TestDfx()
 	//std::string_view filename = "../TestFiles/Test1.dfx";
 	std::string_view filename = "../TestFiles/Test2.dfx";
 	//std::string_view filename = "../TestFiles/Test1NC.dfx";
+	//std::string_view filename = "../TestFiles/VelocityCurves.dfx";
 	//std::string_view filename = "../TestFiles/TestKit.dfx";
 	//std::string_view filename = "../TestFiles/TestKitWIncludes.dfx";
 
@@ -88,6 +88,39 @@ namespace dfx
 		throw std::exception("Invalid sample format");
 	}
 
+	// Scans from the end till we see a signal above a threshold. Returns the
+	// index of that frame, or nframes if nothing is above threshold.
+
+	static unsigned FindLastFrameAbove(FrameBuffer<double>& buffer, unsigned nframes, double threshold)
+	{
+		unsigned endFrame = nframes;
+
+		while (endFrame > 0)
+		{
+			auto x = std::abs(buffer.GetAbsMaxOfFrame(--endFrame));
+			if (x >= threshold) return endFrame;
+		}
+
+		// Nothing above threshold, so we'll have to punt
+		return nframes;
+	}
+
+	unsigned FindEffectiveEnd(FrameBuffer<double>& buffer, double floor_db)
+	{
+		const double threshold = pow(10.0, floor_db / 20.0);
+
+		unsigned lastFrame = FindLastFrameAbove(buffer, buffer.nFrames, threshold);
+
+		if (lastFrame == buffer.nFrames)
+		{
+			// All below the floor (or empty). Rather than silence the
+			// whole thing, we leave it be.
+			return buffer.nFrames;
+		}
+
+		return lastFrame + 1;
+	}
+
 	// This is an attempt to judge the practical "extent" and "volume" of an audio signal.
 	// We only do this for frame buffers of doubles.
 
@@ -140,19 +173,7 @@ namespace dfx
 
 		constexpr double end_threshold = 0.0001;
 
-		unsigned endFrame = nframes;
-
-		while (1)
-		{
-			auto x = std::abs(buffer.GetAbsMaxOfFrame(--endFrame));
-			if (x >= end_threshold) break;
-			if (endFrame == 0)
-			{
-				// Nothing above threshold, so we'll have to punt
-				endFrame = nframes;
-				break;
-			}
-		}
+		unsigned endFrame = FindLastFrameAbove(buffer, nframes, end_threshold);
 
 		const auto nframes_chunk = nframes / 100;
 
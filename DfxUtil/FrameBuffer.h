@@ -146,6 +146,17 @@ namespace dfx
 			dataRate = other.dataRate;
 		}
 
+		void Release()
+		{
+			// Drops our claim on the samples (without touching them,
+			// unlike Clear(), since someone else may be aliasing them.)
+
+			samples = nullptr;
+			nFrames = 0;
+			nChannels = 0;
+			nSamples = 0;
+		}
+
 		void Clear()
 		{
 			for (unsigned i = 0; i < nSamples; i++)
@@ -178,6 +189,23 @@ namespace dfx
 			}
 		}
 
+		void Truncate(unsigned nFrames_)
+		{
+			// Keeps just the first nFrames_ frames. We copy into a smaller
+			// array so that the tail memory is actually given back (once
+			// anybody aliasing the old samples lets go of them too.)
+
+			if (nFrames_ < nFrames)
+			{
+				auto nSamples_ = nFrames_ * nChannels;
+				auto p = std::shared_ptr<T[]>(new T[nSamples_]);
+				memcpy(p.get(), samples.get(), nSamples_ * sizeof(T));
+				samples = p; // We auto release claim on old samples
+				nFrames = nFrames_;
+				nSamples = nSamples_;
+			}
+		}
+
 		void SetDataRate(double dataRate_)
 		{
 			dataRate = dataRate_;
@@ -359,7 +387,7 @@ namespace dfx
 
 			for (unsigned i = 0; i < nChannels; i++)
 			{
-				auto x = samples[sampleIndx + 1];
+				auto x = samples[sampleIndx + i];
 				if (x > pos_max) pos_max = x;
 				if (x < neg_max) neg_max = x;
 			}
@@ -531,6 +559,12 @@ namespace dfx
 
 	WaveStats ComputeStatsII(FrameBuffer<double>& buffer, SampleFormat data_type, double file_rate, double duration);
 
+	// Finds the frame one past where the signal last rises above the given floor (in dBFS).
+	// Everything after that is tail we don't need to keep or to play. Returns nFrames
+	// if nothing rises above the floor.
+
+	extern unsigned FindEffectiveEnd(FrameBuffer<double>& buffer, double floor_db);
+
 	extern double ComputePeakRms(FrameBuffer<double>& fb, double duration);
 
 	extern double ComputePeakRms(FrameBuffer<double>& fb, unsigned startFrame, unsigned endFrame);
@@ -33,6 +33,7 @@
 \******************************************************************************/
 
 #include "MemWave.h"
+#include "SampleCache.h"
 
 namespace dfx
 {
@@ -159,6 +160,32 @@ namespace dfx
 		else return false;
 	}
 
+	bool MemWave::LoadShared(const std::filesystem::path& path_, unsigned start_frame, unsigned end_frame, double scale_factor_code, double tail_floor_db)
+	{
+		// Like Load() followed by TrimTail(), except the samples come from
+		// (and go into) the process wide sample cache. So if someone else has
+		// already loaded the same stretch of the same file, we just alias theirs.
+
+		auto& cache = SampleCache::Instance();
+		auto key = SampleCache::MakeKey(path_, start_frame, end_frame, scale_factor_code, tail_floor_db);
+
+		if (cache.Find(key, buff))
+		{
+			path = path_;
+			return true;
+		}
+
+		bool b = Load(path_, start_frame, end_frame, scale_factor_code);
+
+		if (b)
+		{
+			TrimTail(tail_floor_db);
+			cache.Insert(key, buff);
+		}
+
+		return b;
+	}
+
 	bool MemWave::LoadRaw(const std::filesystem::path& path_, unsigned nChannels_, SampleFormat format_, double fileRate_)
 	{
 		path = path_;
@@ -182,6 +209,26 @@ namespace dfx
 		return false;
 	}
 
+	unsigned MemWave::TrimTail(double floor_db)
+	{
+		// Cuts the wave off where it fades below the floor for good, so that
+		// voices playing it get retired there instead of mixing near silence.
+		// The tail memory is given back as well. Returns the number of frames
+		// trimmed.
+
+		if (floor_db >= 0.0)
+		{
+			return 0;
+		}
+
+		unsigned oldFrames = buff.nFrames;
+		unsigned endFrame = FindEffectiveEnd(buff, floor_db);
+
+		buff.Truncate(endFrame);
+
+		return oldFrames - buff.nFrames;
+	}
+
 	void MemWave::AliasSamples(MemWave& other)
 	{
 		if (this != &other)
@@ -193,6 +240,13 @@ namespace dfx
 		Reset();
 	}
 
+	void MemWave::ReleaseSamples()
+	{
+		// Lets go of any aliased samples, without clearing them
+		buff.Release();
+		Reset();
+	}
+
 	void MemWave::SetRate(double sampleRate_)
 	{
 		sampleRate = sampleRate_;
@@ -38,6 +38,11 @@
 
 namespace dfx
 {
+	// Default floor (in dBFS) below which the tail of a wave is considered silence.
+	// Matches the end threshold that ComputeStats() uses. Zero means don't trim.
+
+	static constexpr double DefaultTailFloor_dB = -80.0;
+
 	class MemWave {
 	public:
 
@@ -68,8 +73,13 @@ namespace dfx
 		bool Load(const std::filesystem::path& path_, unsigned start_frame = 0, unsigned end_frame = 0, double scale_factor_code = 1);
 		bool LoadRaw(const std::filesystem::path& path_, unsigned nChannels_, SampleFormat format_, double fileRate_);
 
+		bool LoadShared(const std::filesystem::path& path_, unsigned start_frame = 0, unsigned end_frame = 0, double scale_factor_code = 1, double tail_floor_db = DefaultTailFloor_dB);
+
+		unsigned TrimTail(double floor_db = DefaultTailFloor_dB);
+
 		void Reset();
 		void AliasSamples(MemWave& other);
+		void ReleaseSamples();
 
 		void SetRate(double sampleRate_);
 		void AddTime(double delta_);
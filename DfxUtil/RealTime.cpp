@@ -0,0 +1,290 @@
+/******************************************************************************\
+ * DFX - "Drum font exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This software helps facilitate the real-time playing of multi-layered drum
+ * samples, by implementing a language that specifies a master directory of the
+ * the sample wave files for a drum kit: where the samples are, what they are
+ * for, and a summary of their properties. The DFX format allows modifications
+ * of sample levels to achieve a unified, pleasing mix of sounds. Mechanisms
+ * such as velocity layers and round robins are supported for this purpose.
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate DFX files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "RealTime.h"
+
+#if defined(__OS_WINDOWS__)
+#include <windows.h>
+#include <malloc.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace dfx
+{
+	bool LockAllMemory(std::ostream& serr)
+	{
+#if defined(__linux__)
+		if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+		{
+			serr << "Couldn't lock memory. (Needs CAP_IPC_LOCK, or a big enough memlock limit.)" << std::endl;
+			return false;
+		}
+
+		return true;
+#else
+		serr << "Locking all memory isn't supported here. Only the samples get locked." << std::endl;
+		return false;
+#endif
+	}
+
+	size_t Prefault(const void* p, size_t nBytes, bool lock)
+	{
+		if (p == nullptr || nBytes == 0)
+		{
+			return 0;
+		}
+
+#if defined(__OS_WINDOWS__)
+		SYSTEM_INFO si;
+		GetSystemInfo(&si);
+		size_t pageSize = si.dwPageSize;
+		if (lock) VirtualLock(const_cast<void*>(p), nBytes);
+#elif defined(__linux__)
+		size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		if (lock) mlock(p, nBytes);
+#else
+		size_t pageSize = 4096;
+		(void)lock;
+#endif
+
+		// Read a byte from each page. Volatile, so the reads aren't optimized away.
+
+		auto bytes = static_cast<const volatile unsigned char*>(p);
+		unsigned char sum = 0;
+		size_t nPages = 0;
+
+		for (size_t i = 0; i < nBytes; i += pageSize, nPages++)
+		{
+			sum += bytes[i];
+		}
+
+		sum += bytes[nBytes - 1];
+		(void)sum;
+
+		return nPages;
+	}
+
+	bool MakeThreadRealTime(int priority, int cpu)
+	{
+#if defined(__OS_WINDOWS__)
+		bool ok = SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+
+		if (cpu >= 0)
+		{
+			ok = SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0 && ok;
+		}
+
+		(void)priority;
+		return ok;
+#elif defined(__linux__)
+		sched_param sp{};
+		sp.sched_priority = priority;
+		bool ok = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp) == 0;
+
+		if (cpu >= 0)
+		{
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			CPU_SET(cpu, &cpus);
+			ok = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0 && ok;
+		}
+
+		return ok;
+#else
+		(void)priority;
+		(void)cpu;
+		return false;
+#endif
+	}
+
+	// ////////////////////////////////////////////////////////////////////
+
+	static thread_local bool onAudioThread = false;
+
+	static std::atomic<unsigned> rtAllocs{ 0 };
+	static std::atomic<unsigned> rtFrees{ 0 };
+	static std::atomic<unsigned> rtLocks{ 0 };
+	static std::atomic<const char*> rtLastLock{ nullptr };
+
+	RtAudioScope::RtAudioScope()
+	: wasOn(onAudioThread)
+	{
+		onAudioThread = true;
+	}
+
+	RtAudioScope::~RtAudioScope()
+	{
+		onAudioThread = wasOn;
+	}
+
+	bool RtCheckOn()
+	{
+		return onAudioThread;
+	}
+
+	void RtCheckLock(const char* what)
+	{
+		if (onAudioThread)
+		{
+			rtLocks.fetch_add(1, std::memory_order_relaxed);
+			rtLastLock.store(what, std::memory_order_relaxed);
+		}
+	}
+
+	bool RtCheckReport(std::ostream& serr)
+	{
+		unsigned nAllocs = rtAllocs.exchange(0);
+		unsigned nFrees = rtFrees.exchange(0);
+		unsigned nLocks = rtLocks.exchange(0);
+		const char* lastLock = rtLastLock.exchange(nullptr);
+
+		if (nAllocs == 0 && nFrees == 0 && nLocks == 0)
+		{
+			return false;
+		}
+
+		serr << "WARNING: On the audio thread: " << nAllocs << " allocation(s), " << nFrees << " free(s), " << nLocks << " lock(s)";
+		if (lastLock) serr << " (last lock: " << lastLock << ")";
+		serr << std::endl;
+
+		return true;
+	}
+
+} // end of namespace
+
+#if defined(DFX_RT_CHECK)
+
+// Counts heap use on the audio thread. The plain and aligned forms are
+// replaced. The nothrow forms end up in these by default. (The aligned
+// forms don't: they have their own allocation functions.)
+
+void* operator new(size_t n)
+{
+	if (dfx::onAudioThread) dfx::rtAllocs.fetch_add(1, std::memory_order_relaxed);
+
+	if (void* p = std::malloc(n ? n : 1))
+	{
+		return p;
+	}
+
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t n)
+{
+	return operator new(n);
+}
+
+void operator delete(void* p) noexcept
+{
+	if (p && dfx::onAudioThread) dfx::rtFrees.fetch_add(1, std::memory_order_relaxed);
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	operator delete(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	operator delete(p);
+}
+
+void* operator new(size_t n, std::align_val_t al)
+{
+	if (dfx::onAudioThread) dfx::rtAllocs.fetch_add(1, std::memory_order_relaxed);
+
+	auto align = static_cast<size_t>(al);
+	if (n == 0) n = 1;
+
+#if defined(__OS_WINDOWS__)
+	void* p = _aligned_malloc(n, align);
+#else
+	// aligned_alloc() wants the size to be a multiple of the alignment
+	void* p = std::aligned_alloc(align, (n + align - 1) / align * align);
+#endif
+
+	if (p)
+	{
+		return p;
+	}
+
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t n, std::align_val_t al)
+{
+	return operator new(n, al);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+	if (p && dfx::onAudioThread) dfx::rtFrees.fetch_add(1, std::memory_order_relaxed);
+
+#if defined(__OS_WINDOWS__)
+	_aligned_free(p);
+#else
+	std::free(p);
+#endif
+}
+
+void operator delete[](void* p, std::align_val_t al) noexcept
+{
+	operator delete(p, al);
+}
+
+void operator delete(void* p, size_t, std::align_val_t al) noexcept
+{
+	operator delete(p, al);
+}
+
+void operator delete[](void* p, size_t, std::align_val_t al) noexcept
+{
+	operator delete(p, al);
+}
+
+#endif
@@ -0,0 +1,111 @@
+#pragma once
+
+/******************************************************************************\
+ * DFX - "Drum font exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This software helps facilitate the real-time playing of multi-layered drum
+ * samples, by implementing a language that specifies a master directory of the
+ * the sample wave files for a drum kit: where the samples are, what they are
+ * for, and a summary of their properties. The DFX format allows modifications
+ * of sample levels to achieve a unified, pleasing mix of sounds. Mechanisms
+ * such as velocity layers and round robins are supported for this purpose.
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate DFX files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+
+namespace dfx
+{
+	// Real time safety. The audio thread must never wait on anything it
+	// doesn't control: not the heap, not a lock, not the disk. That includes
+	// page faults. The first touch of a sample page that's been swapped out
+	// (or never touched) can glitch the first hit of a robin. So we lock
+	// the process memory, touch every sample page ahead of time, and run
+	// the audio thread at a real time priority.
+
+	// Locks all the process memory, now and to come, in ram (mlockall).
+	// On Windows, there's no such thing. Prefault() locks the samples there.
+
+	extern bool LockAllMemory(std::ostream& serr);
+
+	// Touches each page of the buffer, so it's in ram before the audio
+	// thread gets to it. If lock is set, also locks the pages in. Returns
+	// the number of pages touched.
+
+	extern size_t Prefault(const void* p, size_t nBytes, bool lock);
+
+	// Makes the calling thread a real time one (SCHED_FIFO), at priority
+	// 1 to 99. If cpu isn't -1, also pins it to that cpu.
+
+	extern bool MakeThreadRealTime(int priority, int cpu = -1);
+
+	// ////////////////////////////////////////////////////////////////////
+	//
+	// A detector for heap and lock use on the audio thread. Mark the
+	// code that runs on the audio thread with an RtAudioScope. Calling
+	// RtCheckLock() where we take locks, and (in builds with DFX_RT_CHECK
+	// defined) every heap allocation and free, gets counted if it happens
+	// inside the scope. Nothing is printed from the audio thread. Call
+	// RtCheckReport() from some other thread to see what happened.
+	//
+	// ////////////////////////////////////////////////////////////////////
+
+	class RtAudioScope {
+	public:
+
+		bool wasOn;
+
+		RtAudioScope();
+		~RtAudioScope();
+	};
+
+	extern bool RtCheckOn();
+	extern void RtCheckLock(const char* what);
+
+	// A mutex that tells the detector when it's locked
+
+	class RtCheckedMutex {
+	public:
+
+		std::mutex mtx;
+		const char* name;
+
+	public:
+
+		RtCheckedMutex(const char* name_) : mtx(), name(name_) {}
+
+		void lock() { RtCheckLock(name); mtx.lock(); }
+		bool try_lock() { RtCheckLock(name); return mtx.try_lock(); }
+		void unlock() { mtx.unlock(); }
+	};
+
+	// Prints (and clears) what's been caught since the last report.
+	// Returns true if anything was.
+
+	extern bool RtCheckReport(std::ostream& serr);
+
+} // end of namespace
@@ -0,0 +1,150 @@
+/******************************************************************************\
+ * DFX - "Drum font exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This software helps facilitate the real-time playing of multi-layered drum
+ * samples, by implementing a language that specifies a master directory of the
+ * the sample wave files for a drum kit: where the samples are, what they are
+ * for, and a summary of their properties. The DFX format allows modifications
+ * of sample levels to achieve a unified, pleasing mix of sounds. Mechanisms
+ * such as velocity layers and round robins are supported for this purpose.
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate DFX files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include <ostream>
+#include "SampleCache.h"
+
+namespace dfx
+{
+	SampleCache& SampleCache::Instance()
+	{
+		static SampleCache cache;
+		return cache;
+	}
+
+	SampleKey SampleCache::MakeKey(const std::filesystem::path& path_, unsigned start_frame, unsigned end_frame, double scale_factor_code, double tail_floor_db)
+	{
+		std::error_code ec;
+		auto canon = std::filesystem::weakly_canonical(path_, ec);
+
+		SampleKey key;
+		key.path = ec ? path_.generic_string() : canon.generic_string();
+		key.start_frame = start_frame;
+		key.end_frame = end_frame;
+		key.scale_factor_code = scale_factor_code;
+		key.tail_floor_db = tail_floor_db;
+		key.format = SampleFormat::FLOAT64; // All we do at the moment
+		return key;
+	}
+
+	bool SampleCache::Find(const SampleKey& key, FrameBuffer<double>& buff)
+	{
+		std::lock_guard<RtCheckedMutex> lock(mtx);
+
+		auto it = entries.find(key);
+
+		if (it == entries.end())
+		{
+			++stats.misses;
+			return false;
+		}
+
+		buff.Alias(it->second);
+
+		++stats.hits;
+		stats.bytesSaved += buff.nSamples * sizeof(double);
+
+		return true;
+	}
+
+	void SampleCache::Insert(const SampleKey& key, FrameBuffer<double>& buff)
+	{
+		std::lock_guard<RtCheckedMutex> lock(mtx);
+
+		// If another thread beat us to it, keep theirs and share it instead
+
+		auto it = entries.find(key);
+
+		if (it != entries.end())
+		{
+			buff.Alias(it->second);
+			return;
+		}
+
+		FrameBuffer<double> entry;
+		entry.Alias(buff);
+		entries.emplace(key, std::move(entry));
+
+		stats.bytesLoaded += buff.nSamples * sizeof(double);
+	}
+
+	SampleCacheStats SampleCache::GetStats()
+	{
+		std::lock_guard<RtCheckedMutex> lock(mtx);
+		return stats;
+	}
+
+	void SampleCache::ResetStats()
+	{
+		std::lock_guard<RtCheckedMutex> lock(mtx);
+		stats = SampleCacheStats{};
+	}
+
+	size_t SampleCache::Purge()
+	{
+		// If we're the only ones holding onto a buffer, then no kit
+		// is using it anymore. (Say, after swapping kits.)
+
+		std::lock_guard<RtCheckedMutex> lock(mtx);
+
+		size_t n = 0;
+
+		for (auto it = entries.begin(); it != entries.end(); )
+		{
+			if (it->second.samples.use_count() <= 1)
+			{
+				it = entries.erase(it);
+				++n;
+			}
+			else ++it;
+		}
+
+		return n;
+	}
+
+	void SampleCache::Clear()
+	{
+		std::lock_guard<RtCheckedMutex> lock(mtx);
+		entries.clear();
+	}
+
+	void SampleCache::DumpStats(std::ostream& sout)
+	{
+		auto s = GetStats();
+
+		sout << "Sample cache: " << s.hits << " hits, " << s.misses << " misses, "
+			<< s.bytesLoaded << " bytes loaded, " << s.bytesSaved << " bytes saved" << std::endl;
+	}
+
+} // end of namespace
@@ -0,0 +1,107 @@
+#pragma once
+
+/******************************************************************************\
+ * DFX - "Drum font exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This software helps facilitate the real-time playing of multi-layered drum
+ * samples, by implementing a language that specifies a master directory of the
+ * the sample wave files for a drum kit: where the samples are, what they are
+ * for, and a summary of their properties. The DFX format allows modifications
+ * of sample levels to achieve a unified, pleasing mix of sounds. Mechanisms
+ * such as velocity layers and round robins are supported for this purpose.
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate DFX files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <filesystem>
+#include "FrameBuffer.h"
+#include "RealTime.h"
+
+namespace dfx
+{
+	// What makes two loaded sample buffers the same. The path is made
+	// canonical, so different relative paths to the same file match up.
+
+	struct SampleKey
+	{
+		std::string path;
+		unsigned start_frame;
+		unsigned end_frame;
+		double scale_factor_code;
+		double tail_floor_db;
+		SampleFormat format;  // How the samples are stored in memory
+
+		bool operator<(const SampleKey& other) const
+		{
+			return std::tie(path, start_frame, end_frame, scale_factor_code, tail_floor_db, format) <
+				std::tie(other.path, other.start_frame, other.end_frame, other.scale_factor_code, other.tail_floor_db, other.format);
+		}
+	};
+
+	struct SampleCacheStats
+	{
+		size_t hits{};
+		size_t misses{};
+		size_t bytesLoaded{};  // Actually read in from files
+		size_t bytesSaved{};   // Would've been read in again, but for the cache
+	};
+
+	// A process wide cache of the sample buffers loaded from wave files. When
+	// several kits, drums, or includes use the same wave, they all alias one
+	// buffer, which nobody is supposed to modify once it's in here. Only meant
+	// to be used at load time, never from the audio thread.
+
+	class SampleCache {
+	public:
+
+		std::map<SampleKey, FrameBuffer<double>> entries;
+		SampleCacheStats stats;
+		RtCheckedMutex mtx{ "SampleCache" };
+
+	public:
+
+		static SampleCache& Instance();
+
+		static SampleKey MakeKey(const std::filesystem::path& path_, unsigned start_frame, unsigned end_frame, double scale_factor_code, double tail_floor_db);
+
+		bool Find(const SampleKey& key, FrameBuffer<double>& buff);
+		void Insert(const SampleKey& key, FrameBuffer<double>& buff);
+
+		SampleCacheStats GetStats();
+		void ResetStats();
+
+		size_t Purge(); // Drops buffers nobody else is using any more
+		void Clear();
+
+		void DumpStats(std::ostream& sout);
+
+	protected:
+
+		SampleCache() = default;
+	};
+
+} // end of namespace
@@ -177,6 +177,26 @@ namespace dfx
     extern unsigned nBytes(SampleFormat f);
     extern std::pair<double, double> maxVal(SampleFormat f);
 
+    // The sample format for a sample type, as in FormatOf<float>::value
+
+    template<class T> struct FormatOf;
+    template<> struct FormatOf<int16_t> { static constexpr SampleFormat value = SampleFormat::SINT16; };
+    template<> struct FormatOf<int24_t> { static constexpr SampleFormat value = SampleFormat::SINT24; };
+    template<> struct FormatOf<int32_t> { static constexpr SampleFormat value = SampleFormat::SINT32; };
+    template<> struct FormatOf<float> { static constexpr SampleFormat value = SampleFormat::FLOAT32; };
+    template<> struct FormatOf<double> { static constexpr SampleFormat value = SampleFormat::FLOAT64; };
+
+    // The sample type the engine mixes in, and hands to the audio device.
+    // Float by default, which fits twice as many samples in a SIMD register
+    // as double does. Define DFX_ENGINE_DOUBLE (for the whole build) to mix
+    // in double instead. The waves themselves are kept in double either way.
+
+#if defined(DFX_ENGINE_DOUBLE)
+    using engine_t = double;
+#else
+    using engine_t = float;
+#endif
+
     // ////////////////////////////////////////////
 
     inline void swap(int16_t* ptr)
@@ -1,4 +1,5 @@
 #include "VelocityCurves.h"
+#include <cmath>
 
 namespace dfx
 {
@@ -157,4 +158,79 @@ namespace dfx
         }
     }
 
-}
\ No newline at end of file
+
+    //
+    // ////////////////////////////////////////////////////
+    //
+
+    VelocityCurve::VelocityCurve()
+    : type(VelocityCurveType::Unspecified)
+    , param(0.0)
+    , gains()
+    {
+        gains.fill(1.0);
+    }
+
+    VelocityCurve::VelocityCurve(VelocityCurveType type_, double param_)
+    : VelocityCurve()
+    {
+        Generate(type_, param_);
+    }
+
+    void VelocityCurve::Generate(VelocityCurveType type_, double param_)
+    {
+        type = type_;
+        param = param_;
+
+        double full_scale = NCodes - 1;
+
+        switch (type)
+        {
+            case VelocityCurveType::Linear:
+            {
+                for (int i = 0; i < NCodes; i++)
+                {
+                    gains[i] = i / full_scale;
+                }
+            }
+            break;
+
+            case VelocityCurveType::Knee:
+            {
+                // The knee curve works in velocity codes, so scale
+                // those back to gains.
+
+                KneeCurve kc(NCodes, 0.0, full_scale, param);
+
+                for (int i = 0; i < NCodes; i++)
+                {
+                    gains[i] = kc.pts[i] / full_scale;
+                }
+            }
+            break;
+
+            case VelocityCurveType::DynRange:
+            {
+                // The dynamic range curve starts at velocity 1. Velocity 0
+                // is silent.
+
+                DynRangeCurve dc(param, NCodes - 1);
+
+                gains[0] = 0.0;
+
+                for (int i = 1; i < NCodes; i++)
+                {
+                    gains[i] = dc.pts[i - 1];
+                }
+            }
+            break;
+
+            default:
+            {
+                gains.fill(1.0);
+            }
+            break;
+        }
+    }
+
+} // end of namespace
@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <array>
 
 namespace dfx
 {
@@ -56,4 +57,41 @@ namespace dfx
         void Generate(double dB_);
     };
 
-}
\ No newline at end of file
+    // The shapes a velocity curve can have. Unspecified means none was
+    // given, which is full gain at every velocity.
+
+    enum class VelocityCurveType
+    {
+        Unspecified,
+        Linear,
+        Knee,     // param is the knee position, 0 < knee < 1
+        DynRange  // param is the dynamic range, in dB
+    };
+
+    // A velocity curve, boiled down to a gain for each of the 128
+    // midi velocity codes. The curve is worked out when the font is
+    // loaded, so at note on it's just a table lookup.
+
+    class VelocityCurve {
+    public:
+
+        static constexpr int NCodes = 128;
+
+        VelocityCurveType type;
+        double param;
+        std::array<double, NCodes> gains;
+
+    public:
+
+        VelocityCurve();
+        VelocityCurve(VelocityCurveType type_, double param_);
+
+        void Generate(VelocityCurveType type_, double param_);
+
+        bool IsSpecified() const { return type != VelocityCurveType::Unspecified; }
+        bool SameAs(const VelocityCurve& other) const { return type == other.type && param == other.param; }
+
+        double Gain(int velCode) const { return gains[velCode & (NCodes - 1)]; }
+    };
+
+} // end of namespace
@@ -0,0 +1,241 @@
+/******************************************************************************\
+ * DFX - "Drum font exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This software helps facilitate the real-time playing of multi-layered drum
+ * samples, by implementing a language that specifies a master directory of the
+ * the sample wave files for a drum kit: where the samples are, what they are
+ * for, and a summary of their properties. The DFX format allows modifications
+ * of sample levels to achieve a unified, pleasing mix of sounds. Mechanisms
+ * such as velocity layers and round robins are supported for this purpose.
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate DFX files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include <cmath>
+#include "VoiceRender.h"
+
+namespace dfx
+{
+	// Channels is 1 for mono, 2 for stereo, and 0 for however many the
+	// buffer has (multi-mic waves). See MicMix for which gains each uses.
+	// M is the type we mix in. (See engine_t.) The samples are turned into
+	// M as they're read, so all the mixing math is done in M.
+
+	template<typename M, typename T, unsigned Channels>
+	static inline void MixFrame(const T* a, const MicMix& mix, StereoFrame<M>& out)
+	{
+		if constexpr (Channels == 1)
+		{
+			M x = static_cast<M>(a[0]);
+			out.left += static_cast<M>(mix.gain[0].left) * x;
+			out.right += static_cast<M>(mix.gain[0].right) * x;
+		}
+		else if constexpr (Channels == 2)
+		{
+			out.left += static_cast<M>(mix.gain[0].left) * static_cast<M>(a[0]);
+			out.right += static_cast<M>(mix.gain[1].right) * static_cast<M>(a[1]);
+		}
+		else
+		{
+			M left = 0;
+			M right = 0;
+
+			for (unsigned k = 0; k < mix.nMics; k++)
+			{
+				M x = static_cast<M>(a[mix.mic[k]]);
+				left += static_cast<M>(mix.gain[k].left) * x;
+				right += static_cast<M>(mix.gain[k].right) * x;
+			}
+
+			out.left += left;
+			out.right += right;
+		}
+	}
+
+	template<typename M, typename T, unsigned Channels>
+	static inline void MixFrame(const T* a, const T* b, double frac, const MicMix& mix, StereoFrame<M>& out)
+	{
+		// Same as above, but between frame a and the one after it, b
+
+		if constexpr (Channels == 1)
+		{
+			M x = static_cast<M>(a[0] + frac * (b[0] - a[0]));
+			out.left += static_cast<M>(mix.gain[0].left) * x;
+			out.right += static_cast<M>(mix.gain[0].right) * x;
+		}
+		else if constexpr (Channels == 2)
+		{
+			out.left += static_cast<M>(mix.gain[0].left) * static_cast<M>(a[0] + frac * (b[0] - a[0]));
+			out.right += static_cast<M>(mix.gain[1].right) * static_cast<M>(a[1] + frac * (b[1] - a[1]));
+		}
+		else
+		{
+			M left = 0;
+			M right = 0;
+
+			for (unsigned k = 0; k < mix.nMics; k++)
+			{
+				auto c = mix.mic[k];
+				M x = static_cast<M>(a[c] + frac * (b[c] - a[c]));
+				left += static_cast<M>(mix.gain[k].left) * x;
+				right += static_cast<M>(mix.gain[k].right) * x;
+			}
+
+			out.left += left;
+			out.right += right;
+		}
+	}
+
+	template<typename M, typename T, unsigned Channels, bool Interpolate>
+	static unsigned RenderFrames(const FrameBuffer<T>& buff, double& time, double deltaTime, bool& finished, const MicMix& mix, StereoFrame<M>* out, unsigned nFrames)
+	{
+		const unsigned stride = Channels ? Channels : buff.nChannels;
+		const T* s = buff.samples.get();
+		const double last = buff.nFrames - 1.0;
+
+		// Work out how many frames we can do before getting near the end
+		// of the samples. Those frames need no bounds checks. Interpolating
+		// reads the frame after, so there we stop a frame short. (That also
+		// covers any round off in adding up the time.)
+
+		const double room = (Interpolate ? last - 1.0 : last) - time;
+
+		unsigned n = 0;
+
+		if (room >= 0.0)
+		{
+			double k = room / deltaTime + 1.0;
+			n = k < nFrames ? static_cast<unsigned>(k) : nFrames;
+		}
+
+		if (Interpolate)
+		{
+			double t = time;
+
+			for (unsigned i = 0; i < n; i++)
+			{
+				auto indx = static_cast<unsigned>(t);
+				const T* a = s + indx * stride;
+				MixFrame<M, T, Channels>(a, a + stride, t - indx, mix, out[i]);
+				t += deltaTime;
+			}
+
+			time = t;
+		}
+		else
+		{
+			// Here the time always lands right on a frame
+
+			auto indx = static_cast<unsigned>(time);
+			auto step = static_cast<unsigned>(deltaTime);
+
+			for (unsigned i = 0; i < n; i++)
+			{
+				MixFrame<M, T, Channels>(s + indx * stride, mix, out[i]);
+				indx += step;
+			}
+
+			time += n * deltaTime;
+		}
+
+		// The last frame or two, done carefully, just like MemWave::StereoTick()
+
+		for (unsigned i = n; i < nFrames; i++)
+		{
+			if (time > last)
+			{
+				time = last;
+				finished = true;
+				return i;
+			}
+
+			auto indx = static_cast<unsigned>(time);
+			double frac = time - indx;
+			const T* a = s + indx * stride;
+
+			if (Interpolate && frac > 0.0 && indx < last)
+			{
+				MixFrame<M, T, Channels>(a, a + stride, frac, mix, out[i]);
+			}
+			else
+			{
+				MixFrame<M, T, Channels>(a, mix, out[i]);
+			}
+
+			time += deltaTime;
+		}
+
+		return nFrames;
+	}
+
+	template<typename M, unsigned Channels, bool Interpolate>
+	static unsigned RenderWave(MemWave& wave, const MicMix& mix, StereoFrame<M>* out, unsigned nFrames)
+	{
+		if (wave.finished)
+		{
+			return 0;
+		}
+
+		return RenderFrames<M, double, Channels, Interpolate>(wave.buff, wave.time, wave.deltaTime, wave.finished, mix, out, nFrames);
+	}
+
+	// Indexed by channel layout (mono, stereo, multi), then by whether to interpolate
+
+	template<typename M>
+	static const StereoRenderFn<M> stereoRenderers[3][2] =
+	{
+		{ RenderWave<M, 1, false>, RenderWave<M, 1, true> },
+		{ RenderWave<M, 2, false>, RenderWave<M, 2, true> },
+		{ RenderWave<M, 0, false>, RenderWave<M, 0, true> }
+	};
+
+	template<typename M>
+	StereoRenderFn<M> ChooseStereoRenderer(const MemWave& wave)
+	{
+		auto nChannels = wave.buff.nChannels;
+		int layout = nChannels <= 1 ? 0 : nChannels == 2 ? 1 : 2;
+		return stereoRenderers<M>[layout][wave.interpolate ? 1 : 0];
+	}
+
+	template StereoRenderFn<float> ChooseStereoRenderer<float>(const MemWave& wave);
+	template StereoRenderFn<double> ChooseStereoRenderer<double>(const MemWave& wave);
+
+	StereoFrame<double> PanGains(double pan, unsigned nChannels)
+	{
+		if (pan < -1.0) pan = -1.0;
+		if (pan > 1.0) pan = 1.0;
+
+		if (nChannels <= 1)
+		{
+			static const double quarter_pi = std::atan(1.0);
+			static const double root2 = std::sqrt(2.0);
+
+			double theta = (pan + 1.0) * quarter_pi; // 0 to pi/2
+			return { root2 * std::cos(theta), root2 * std::sin(theta) };
+		}
+
+		return { pan > 0.0 ? 1.0 - pan : 1.0, pan < 0.0 ? 1.0 + pan : 1.0 };
+	}
+
+} // end of namespace
@@ -0,0 +1,88 @@
+#pragma once
+
+/******************************************************************************\
+ * DFX - "Drum font exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This software helps facilitate the real-time playing of multi-layered drum
+ * samples, by implementing a language that specifies a master directory of the
+ * the sample wave files for a drum kit: where the samples are, what they are
+ * for, and a summary of their properties. The DFX format allows modifications
+ * of sample levels to achieve a unified, pleasing mix of sounds. Mechanisms
+ * such as velocity layers and round robins are supported for this purpose.
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate DFX files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+#include "MemWave.h"
+
+namespace dfx
+{
+	// Voice rendering. Rather than ticking a playing wave one frame at a
+	// time, and checking every frame whether it's finished, interpolated,
+	// mono or stereo, we render a run of frames with an inner loop that's
+	// specialized for how the wave is to be played. The specialization is
+	// picked once, at note on, from a small dispatch table.
+
+	constexpr unsigned MAX_MICS = 16;
+
+	// How the channels (mics) of a wave mix into the stereo output. Only
+	// the mics listed get played, so a muted mic costs nothing to render.
+	// Mono and stereo waves use just the gains they need: mono plays mic 0
+	// with gain[0] on both sides. Stereo plays mic 0 left with gain[0].left,
+	// and mic 1 right with gain[1].right.
+
+	struct MicMix
+	{
+		unsigned nMics;                     // How many are listed
+		unsigned mic[MAX_MICS];             // Which channel of the wave
+		StereoFrame<double> gain[MAX_MICS]; // Its left and right gains
+	};
+
+	// Renders up to nFrames frames of the wave, through the mic mix, adding
+	// them into the stereo output block. Returns the number of frames
+	// rendered, which is less than nFrames only if the wave finished along
+	// the way. M is the type to mix in: float or double. The engine uses
+	// engine_t.
+
+	template<typename M>
+	using StereoRenderFn = unsigned (*)(MemWave& wave, const MicMix& mix, StereoFrame<M>* out, unsigned nFrames);
+
+	// Picks the renderer for the wave's channel layout, and for whether its
+	// data rate matches the playback rate. So call this after the samples are
+	// aliased and the rate is set, and again if either changes.
+
+	template<typename M = engine_t>
+	StereoRenderFn<M> ChooseStereoRenderer(const MemWave& wave);
+
+	extern template StereoRenderFn<float> ChooseStereoRenderer<float>(const MemWave& wave);
+	extern template StereoRenderFn<double> ChooseStereoRenderer<double>(const MemWave& wave);
+
+	// The left and right gains for a pan position, from -1 (hard left) to
+	// 1 (hard right). A mono wave is placed with a constant power pan law,
+	// scaled so that center is unity gain on both sides. For a stereo (or
+	// multi-mic) wave, which is already placed, pan is a balance control:
+	// it turns down the far side only.
+
+	extern StereoFrame<double> PanGains(double pan, unsigned nChannels);
+
+} // end of namespace
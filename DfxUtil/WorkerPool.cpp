@@ -0,0 +1,216 @@
+/******************************************************************************\
+ * DFX - "Drum font exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This software helps facilitate the real-time playing of multi-layered drum
+ * samples, by implementing a language that specifies a master directory of the
+ * the sample wave files for a drum kit: where the samples are, what they are
+ * for, and a summary of their properties. The DFX format allows modifications
+ * of sample levels to achieve a unified, pleasing mix of sounds. Mechanisms
+ * such as velocity layers and round robins are supported for this purpose.
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate DFX files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include <chrono>
+#include "WorkerPool.h"
+#include "RealTime.h"
+
+#if defined(__OS_WINDOWS__)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace dfx
+{
+	void CpuRelax()
+	{
+		// Tells the cpu we're spinning. Eases up on the core's resources (and
+		// the memory bus) while we wait.
+
+#if defined(__OS_WINDOWS__)
+		YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+		_mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+		__asm__ __volatile__("yield");
+#endif
+	}
+
+	bool PinThread(std::thread& thread, unsigned cpu)
+	{
+#if defined(__OS_WINDOWS__)
+		return SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(cpu, &cpus);
+		return pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus) == 0;
+#else
+		return false;
+#endif
+	}
+
+	// ////////////////////////////////////////////////////////////////////
+
+	WorkerPool::WorkerPool()
+	: threads{}
+	, job(nullptr)
+	, ctx(nullptr)
+	, ticket(0)
+	, pending(0)
+	, quit(false)
+	, priority(0)
+	{
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		Stop();
+	}
+
+	bool WorkerPool::Start(unsigned nWorkers, bool pin, int priority_)
+	{
+		Stop();
+
+		priority = priority_;
+
+		// Spinning workers sharing a cpu would just get in each other's way.
+		// So no more workers than there are cpus besides the audio thread's.
+
+		unsigned nCpus = std::thread::hardware_concurrency();
+
+		if (nCpus > 0 && nWorkers > nCpus - 1) nWorkers = nCpus - 1;
+		if (nWorkers > MAX_WORKERS) nWorkers = MAX_WORKERS;
+
+		quit = false;
+		pending = 0;
+
+		bool pinned = true;
+
+		// The workers start from the current ticket, so none miss a job
+		// handed out before they get going.
+
+		unsigned seen = ticket.load(std::memory_order_relaxed);
+
+		for (unsigned w = 1; w <= nWorkers; w++)
+		{
+			threads.emplace_back([this, w, seen] { Run(w, seen); });
+
+			if (pin && nCpus > 1)
+			{
+				pinned = PinThread(threads.back(), w % nCpus) && pinned;
+			}
+		}
+
+		return pinned;
+	}
+
+	void WorkerPool::Stop()
+	{
+		quit = true;
+
+		for (auto& t : threads)
+		{
+			t.join();
+		}
+
+		threads.clear();
+	}
+
+	void WorkerPool::Dispatch(WorkerJob job_, void* ctx_, unsigned nHelpers_)
+	{
+		if (nHelpers_ > Size()) nHelpers_ = Size();
+
+		job = job_;
+		ctx = ctx_;
+		pending.store(nHelpers_, std::memory_order_relaxed);
+
+		// The release here publishes the job to the workers
+
+		unsigned count = (ticket.load(std::memory_order_relaxed) >> 8) + 1;
+		ticket.store((count << 8) | nHelpers_, std::memory_order_release);
+	}
+
+	void WorkerPool::Wait()
+	{
+		// The helpers are busy on the same block we are. So they should
+		// be done about when we are, and it's not worth backing off far.
+
+		unsigned spins = 0;
+
+		while (pending.load(std::memory_order_acquire) != 0)
+		{
+			if (++spins < 1024) CpuRelax();
+			else std::this_thread::yield();
+		}
+	}
+
+	void WorkerPool::Run(unsigned worker, unsigned seen)
+	{
+		unsigned idle = 0;
+
+		if (priority > 0)
+		{
+			MakeThreadRealTime(priority);
+		}
+
+		while (!quit.load(std::memory_order_relaxed))
+		{
+			unsigned t = ticket.load(std::memory_order_acquire);
+
+			if (t != seen)
+			{
+				seen = t;
+				idle = 0;
+
+				if (worker <= (t & 0xff))
+				{
+					RtAudioScope scope; // The job's part of the audio thread's work
+					job(ctx, worker);
+					pending.fetch_sub(1, std::memory_order_release);
+				}
+			}
+			else
+			{
+				// Spin, then yield, then nap. A block at 48 kHz with 64 frames is
+				// about 1.3 ms, so spinning through 4096 relaxes (a few tens of
+				// microseconds) doesn't miss the next one, and napping only
+				// happens once the drums have been quiet for a while.
+
+				++idle;
+
+				if (idle < 4096) CpuRelax();
+				else if (idle < 8192) std::this_thread::yield();
+				else std::this_thread::sleep_for(std::chrono::microseconds(100));
+			}
+		}
+	}
+
+} // end of namespace
@@ -0,0 +1,107 @@
+#pragma once
+
+/******************************************************************************\
+ * DFX - "Drum font exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This software helps facilitate the real-time playing of multi-layered drum
+ * samples, by implementing a language that specifies a master directory of the
+ * the sample wave files for a drum kit: where the samples are, what they are
+ * for, and a summary of their properties. The DFX format allows modifications
+ * of sample levels to achieve a unified, pleasing mix of sounds. Mechanisms
+ * such as velocity layers and round robins are supported for this purpose.
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate DFX files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace dfx
+{
+	// A small pool of worker threads for the audio thread to hand work to,
+	// once per block. There are no mutexes or condition variables anywhere
+	// in here: the audio thread publishes a job by bumping a counter, and
+	// waits for it by spinning on another. Idle workers spin too, backing
+	// off to yielding, then to short naps, the longer nothing comes along.
+	// (So a pool that's been idle for a while takes a little longer to wake
+	// up. It stays hot as long as blocks keep coming.)
+
+	constexpr unsigned MAX_WORKERS = 8;
+
+	// The job each worker runs. worker is 1 to the number of helpers asked
+	// for. (By convention, the calling thread is worker 0.)
+
+	using WorkerJob = void (*)(void* ctx, unsigned worker);
+
+	class WorkerPool {
+	public:
+
+		std::vector<std::thread> threads;
+
+		WorkerJob job;
+		void* ctx;
+
+		// A count of the jobs in the upper bits, and how many of the workers
+		// take part in the latest in the low byte. Both are in the one word,
+		// so a worker sees them change together.
+
+		std::atomic<unsigned> ticket;
+		std::atomic<unsigned> pending;    // Helpers not done with the job yet
+		std::atomic<bool> quit;
+		int priority;                     // Real time priority of the workers, or 0 to leave as is
+
+	public:
+
+		WorkerPool();
+		virtual ~WorkerPool();
+
+		WorkerPool(const WorkerPool&) = delete;
+		void operator=(const WorkerPool&) = delete;
+
+		// NOTE: Not thread safe. Start and stop the pool when the audio stream isn't running.
+		// If pin is set, worker n runs on cpu n only (leaving cpu 0 to the audio thread.)
+		// There won't be more workers than there are cpus, less one. If priority
+		// isn't 0, the workers run at that real time priority. (See RealTime.h)
+
+		bool Start(unsigned nWorkers, bool pin = true, int priority_ = 0);
+		void Stop();
+
+		unsigned Size() const { return static_cast<unsigned>(threads.size()); }
+
+		// Hands the job to the first nHelpers workers, and returns right away.
+		// Call Wait() before handing out another.
+
+		void Dispatch(WorkerJob job_, void* ctx_, unsigned nHelpers_);
+		void Wait();
+
+	protected:
+
+		void Run(unsigned worker, unsigned seen);
+	};
+
+	extern void CpuRelax();
+	extern bool PinThread(std::thread& thread, unsigned cpu);
+
+} // end of namespace
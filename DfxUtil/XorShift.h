@@ -0,0 +1,89 @@
+#pragma once
+
+/******************************************************************************\
+ * DFX - "Drum font exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This software helps facilitate the real-time playing of multi-layered drum
+ * samples, by implementing a language that specifies a master directory of the
+ * the sample wave files for a drum kit: where the samples are, what they are
+ * for, and a summary of their properties. The DFX format allows modifications
+ * of sample levels to achieve a unified, pleasing mix of sounds. Mechanisms
+ * such as velocity layers and round robins are supported for this purpose.
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate DFX files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+#include <cstdint>
+
+namespace dfx
+{
+	// A small, fast xorshift64* random number generator. No allocations,
+	// no locks, so it's safe to call from the audio thread. Given the same
+	// seed, it hands out the same sequence, which makes offline renders
+	// reproducible.
+
+	class XorShiftRng {
+	public:
+
+		static constexpr uint64_t DefaultSeed = 0x9E3779B97F4A7C15ull;
+
+		uint64_t state;
+
+	public:
+
+		explicit XorShiftRng(uint64_t seed_ = DefaultSeed)
+		{
+			Seed(seed_);
+		}
+
+		void Seed(uint64_t seed_)
+		{
+			// The all zeros state is a fixed point, so avoid it
+			state = seed_ ? seed_ : DefaultSeed;
+		}
+
+		uint64_t Next()
+		{
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			return state * 0x2545F4914F6CDD1Dull;
+		}
+
+		unsigned Below(unsigned n)
+		{
+			// Returns 0 <= r < n. Uses the multiply and shift trick
+			// rather than modulus. The bias is negligible for our sizes.
+
+			return static_cast<unsigned>(((Next() >> 32) * n) >> 32);
+		}
+
+		double Uniform()
+		{
+			// Returns 0.0 <= x < 1.0, using the top 53 bits
+
+			return (Next() >> 11) * (1.0 / 9007199254740992.0);
+		}
+	};
+
+} // end of namespace
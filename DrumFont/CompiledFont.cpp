@@ -0,0 +1,643 @@
+/******************************************************************************\
+ * DFX - "Drum font exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This software helps facilitate the real-time playing of multi-layered drum
+ * samples, by implementing a language that specifies a master directory of the
+ * the sample wave files for a drum kit: where the samples are, what they are
+ * for, and a summary of their properties. The DFX format allows modifications
+ * of sample levels to achieve a unified, pleasing mix of sounds. Mechanisms
+ * such as velocity layers and round robins are supported for this purpose.
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate DFX files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include <map>
+#include <set>
+#include <fstream>
+#include <sstream>
+#include "CompiledFont.h"
+
+namespace dfx
+{
+	// ////////////////////////////////////////////////////
+	// Low level reading and writing
+
+	template<typename T>
+	static void WritePod(std::ostream& out, const T& x)
+	{
+		out.write(reinterpret_cast<const char*>(&x), sizeof(T));
+	}
+
+	template<typename T>
+	static bool ReadPod(std::istream& in, T& x)
+	{
+		in.read(reinterpret_cast<char*>(&x), sizeof(T));
+		return in.good();
+	}
+
+	static void WriteStr(std::ostream& out, const std::string& s)
+	{
+		WritePod(out, static_cast<uint32_t>(s.size()));
+		out.write(s.data(), s.size());
+	}
+
+	static bool ReadStr(std::istream& in, std::string& s)
+	{
+		// The strings are names and paths, so anything longer than
+		// this means the file is corrupt. Don't go allocating it.
+
+		static constexpr uint32_t MaxLen = 64 * 1024;
+
+		uint32_t n;
+		if (!ReadPod(in, n) || n > MaxLen) return false;
+		s.resize(n);
+		in.read(s.data(), n);
+		return in.good();
+	}
+
+	static void WritePadding(std::ostream& out, uint64_t from, uint64_t to)
+	{
+		static const char zeros[64] = { 0 };
+
+		while (from < to)
+		{
+			auto n = (to - from) < sizeof(zeros) ? (to - from) : sizeof(zeros);
+			out.write(zeros, n);
+			from += n;
+		}
+	}
+
+	static uint64_t AlignUp(uint64_t x, uint64_t align)
+	{
+		return (x + align - 1) / align * align;
+	}
+
+	// ////////////////////////////////////////////////////
+	// Sources
+
+	std::filesystem::path CompiledFont::CompiledPath(const std::filesystem::path& font_path)
+	{
+		auto p = font_path;
+		p.replace_extension(".dfxc");
+		return p;
+	}
+
+	uint64_t CompiledFont::HashFile(const std::filesystem::path& path)
+	{
+		// 64 bit FNV-1a. Not cryptographic, but we're only trying to
+		// notice edits, not fend off attackers.
+
+		uint64_t h = 0xcbf29ce484222325ull;
+
+		std::ifstream in(path, std::ios::binary);
+
+		std::vector<char> chunk(65536);
+
+		while (in)
+		{
+			in.read(chunk.data(), chunk.size());
+			auto n = in.gcount();
+
+			for (std::streamsize i = 0; i < n; i++)
+			{
+				h ^= static_cast<unsigned char>(chunk[i]);
+				h *= 0x100000001b3ull;
+			}
+		}
+
+		return h;
+	}
+
+	bool CompiledFont::MakeSource(CompiledSource& src, const std::filesystem::path& path, bool with_hash)
+	{
+		std::error_code ec;
+
+		src.path = path.generic_string();
+		src.size = std::filesystem::file_size(path, ec);
+		if (ec) return false;
+
+		src.mtime = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+		if (ec) return false;
+
+		src.hash = with_hash ? HashFile(path) : 0;
+
+		return true;
+	}
+
+	bool CompiledFont::SourceIsCurrent(const CompiledSource& src)
+	{
+		CompiledSource now;
+
+		if (!MakeSource(now, src.path, false))
+		{
+			return false; // Gone missing
+		}
+
+		if (now.size != src.size)
+		{
+			return false;
+		}
+
+		if (now.mtime == src.mtime)
+		{
+			return true;
+		}
+
+		// Touched, but maybe not changed
+
+		return HashFile(src.path) == src.hash;
+	}
+
+	// ////////////////////////////////////////////////////
+	// Saving
+
+	bool CompiledFont::Save(std::ostream& serr, const std::filesystem::path& dfxc_path, const std::vector<std::shared_ptr<DrumKit>>& kits, const std::vector<std::filesystem::path>& source_paths, double tail_floor_db)
+	{
+		// Gather up the sources: the font files given to us, plus all the
+		// wave files. Also lay out the sample data. Robins sharing the
+		// same samples (see SampleCache) share the same block.
+
+		std::vector<std::filesystem::path> all_sources = source_paths;
+		std::set<std::string> seen_waves;
+
+		std::map<const double*, uint64_t> block_offsets;
+		std::vector<std::pair<const double*, uint64_t>> blocks; // samples, nSamples
+		uint64_t data_size = 0;
+
+		for (auto& kit : kits)
+		{
+			for (auto& drum : kit->drums)
+			{
+				for (auto& layer : drum->velocityLayers)
+				{
+					for (auto& robin : layer.robinMgr.robins)
+					{
+						if (seen_waves.insert(robin.fullPath.generic_string()).second)
+						{
+							all_sources.push_back(robin.fullPath);
+						}
+
+						auto& buff = robin.wave.buff;
+						auto p = buff.samples.get();
+
+						if (p && block_offsets.find(p) == block_offsets.end())
+						{
+							data_size = AlignUp(data_size, BlockAlign);
+							block_offsets[p] = data_size;
+							blocks.emplace_back(p, buff.nSamples);
+							data_size += buff.nSamples * sizeof(double);
+						}
+					}
+				}
+			}
+		}
+
+		std::vector<CompiledSource> sources;
+
+		for (auto& path : all_sources)
+		{
+			CompiledSource src;
+
+			if (!MakeSource(src, path))
+			{
+				serr << "Can't compile font: can't find source file " << path << std::endl;
+				return false;
+			}
+
+			sources.push_back(src);
+		}
+
+		std::ofstream out(dfxc_path, std::ios::binary | std::ios::trunc);
+
+		if (!out)
+		{
+			serr << "Can't create compiled font file " << dfxc_path << std::endl;
+			return false;
+		}
+
+		// Header
+
+		WritePod(out, Magic);
+		WritePod(out, Version);
+		WritePod(out, ByteOrderCheck);
+		WritePod(out, static_cast<uint32_t>(SampleFormat::FLOAT64));
+		WritePod(out, tail_floor_db);
+
+		// Sources
+
+		WritePod(out, static_cast<uint32_t>(sources.size()));
+
+		for (auto& src : sources)
+		{
+			WriteStr(out, src.path);
+			WritePod(out, src.size);
+			WritePod(out, src.mtime);
+			WritePod(out, src.hash);
+		}
+
+		// Kits
+
+		WritePod(out, static_cast<uint32_t>(kits.size()));
+
+		for (auto& kit : kits)
+		{
+			WriteStr(out, kit->name);
+			WriteStr(out, kit->cumulativePath.generic_string());
+			WriteStr(out, kit->basePath.generic_string());
+			WriteStr(out, kit->includeBasePath.generic_string());
+			WriteStr(out, kit->kitPath.generic_string());
+			WritePod(out, static_cast<int32_t>(kit->velCurve.type));
+			WritePod(out, kit->velCurve.param);
+			WritePod(out, static_cast<int32_t>(kit->levelBy));
+			WritePod(out, kit->levelTarget);
+			WritePod(out, static_cast<int32_t>(kit->robinStrategy));
+			WritePod(out, kit->velocityJitter);
+
+			WritePod(out, static_cast<uint32_t>(kit->drums.size()));
+
+			for (auto& drum : kit->drums)
+			{
+				WriteStr(out, drum->name);
+				WriteStr(out, drum->cumulativePath.generic_string());
+				WriteStr(out, drum->drumPath.generic_string());
+				WriteStr(out, drum->includePath.generic_string());
+				WritePod(out, static_cast<int32_t>(drum->midiNote));
+				WritePod(out, drum->pan);
+				WritePod(out, static_cast<int32_t>(drum->bus));
+				WritePod(out, static_cast<int32_t>(drum->velCurve.type));
+				WritePod(out, drum->velCurve.param);
+
+				WritePod(out, static_cast<uint32_t>(drum->velocityLayers.size()));
+
+				for (auto& layer : drum->velocityLayers)
+				{
+					WriteStr(out, layer.cumulativePath.generic_string());
+					WriteStr(out, layer.localPath.generic_string());
+					WritePod(out, static_cast<int32_t>(layer.vrange.velCode));
+					WritePod(out, static_cast<int32_t>(layer.vrange.iMinVel));
+					WritePod(out, static_cast<int32_t>(layer.vrange.iMaxVel));
+					WritePod(out, layer.vrange.fMinVel);
+					WritePod(out, layer.vrange.fMaxVel);
+
+					WritePod(out, static_cast<uint32_t>(layer.robinMgr.robins.size()));
+
+					for (auto& robin : layer.robinMgr.robins)
+					{
+						auto& buff = robin.wave.buff;
+
+						WriteStr(out, robin.fileName.generic_string());
+						WriteStr(out, robin.fullPath.generic_string());
+						WritePod(out, robin.peak);
+						WritePod(out, robin.rms);
+						WritePod(out, static_cast<uint32_t>(robin.start_frame));
+						WritePod(out, static_cast<uint32_t>(robin.end_frame));
+						WritePod(out, robin.weight);
+
+						auto p = buff.samples.get();
+						uint64_t offset = p ? block_offsets[p] : 0;
+
+						WritePod(out, offset);
+						WritePod(out, static_cast<uint32_t>(buff.nFrames));
+						WritePod(out, static_cast<uint32_t>(buff.nChannels));
+						WritePod(out, buff.dataRate);
+					}
+				}
+			}
+		}
+
+		// Samples. The data starts on a page boundary.
+
+		uint64_t pos = static_cast<uint64_t>(out.tellp()) + 2 * sizeof(uint64_t);
+		uint64_t data_start = AlignUp(pos, PageAlign);
+
+		WritePod(out, data_start);
+		WritePod(out, data_size);
+		WritePadding(out, pos, data_start);
+
+		uint64_t at = 0;
+
+		for (auto& b : blocks)
+		{
+			auto offset = block_offsets[b.first];
+			WritePadding(out, at, offset);
+			out.write(reinterpret_cast<const char*>(b.first), b.second * sizeof(double));
+			at = offset + b.second * sizeof(double);
+		}
+
+		if (!out)
+		{
+			serr << "Error writing compiled font file " << dfxc_path << std::endl;
+			out.close();
+			std::error_code ec;
+			std::filesystem::remove(dfxc_path, ec);
+			return false;
+		}
+
+		return true;
+	}
+
+	// ////////////////////////////////////////////////////
+	// Loading
+
+	bool CompiledFont::Load(std::ostream& serr, const std::filesystem::path& dfxc_path, std::vector<std::shared_ptr<DrumKit>>& kits, double tail_floor_db)
+	{
+		std::ifstream in(dfxc_path, std::ios::binary);
+
+		if (!in)
+		{
+			return false; // Not an error, we just don't have one
+		}
+
+		// The counts and sizes read in are checked against this before
+		// anything gets allocated for them, so a corrupt file just gets
+		// rebuilt.
+
+		std::error_code ec;
+		uint64_t file_size = std::filesystem::file_size(dfxc_path, ec);
+
+		if (ec)
+		{
+			return false;
+		}
+
+		uint32_t magic, version, byte_order, format;
+		double floor_db;
+
+		bool b = ReadPod(in, magic) && ReadPod(in, version) && ReadPod(in, byte_order) && ReadPod(in, format) && ReadPod(in, floor_db);
+
+		if (!b || magic != Magic || version != Version || byte_order != ByteOrderCheck)
+		{
+			serr << "Compiled font file " << dfxc_path << " is not usable. Rebuilding." << std::endl;
+			return false;
+		}
+
+		if (format != static_cast<uint32_t>(SampleFormat::FLOAT64) || floor_db != tail_floor_db)
+		{
+			serr << "Compiled font file " << dfxc_path << " was built with different settings. Rebuilding." << std::endl;
+			return false;
+		}
+
+		uint32_t nsources;
+		if (!ReadPod(in, nsources)) return false;
+
+		for (uint32_t i = 0; i < nsources; i++)
+		{
+			CompiledSource src;
+
+			if (!(ReadStr(in, src.path) && ReadPod(in, src.size) && ReadPod(in, src.mtime) && ReadPod(in, src.hash)))
+			{
+				return false;
+			}
+
+			if (!SourceIsCurrent(src))
+			{
+				serr << "Compiled font file " << dfxc_path << " is out of date (" << src.path << " changed). Rebuilding." << std::endl;
+				return false;
+			}
+		}
+
+		// Read in the kits. The robins will get hooked up to their
+		// samples once we've read those in.
+
+		struct RobinFixup
+		{
+			Robin* robin;
+			uint64_t offset;
+		};
+
+		std::vector<std::shared_ptr<DrumKit>> new_kits;
+		std::vector<RobinFixup> fixups;
+
+		uint32_t nkits;
+		if (!ReadPod(in, nkits)) return false;
+
+		for (uint32_t k = 0; k < nkits; k++)
+		{
+			auto kit = std::make_shared<DrumKit>();
+			std::string s;
+
+			if (!ReadStr(in, kit->name)) return false;
+			if (!ReadStr(in, s)) return false;
+			kit->cumulativePath = s;
+			if (!ReadStr(in, s)) return false;
+			kit->basePath = s;
+			if (!ReadStr(in, s)) return false;
+			kit->includeBasePath = s;
+			if (!ReadStr(in, s)) return false;
+			kit->kitPath = s;
+
+			// Just the shape of the velocity curves is stored. The gains
+			// are worked out again from that.
+
+			int32_t kit_curve_type;
+			double kit_curve_param;
+
+			if (!(ReadPod(in, kit_curve_type) && ReadPod(in, kit_curve_param))) return false;
+
+			kit->velCurve.Generate(static_cast<VelocityCurveType>(kit_curve_type), kit_curve_param);
+
+			// Likewise the leveling. The robin gains come from it and the
+			// robins' peak and rms, once they're all read in.
+
+			int32_t level_by;
+
+			if (!(ReadPod(in, level_by) && ReadPod(in, kit->levelTarget))) return false;
+
+			kit->levelBy = static_cast<LevelBy>(level_by);
+
+			int32_t robin_strategy;
+
+			if (!(ReadPod(in, robin_strategy) && ReadPod(in, kit->velocityJitter))) return false;
+
+			kit->robinStrategy = static_cast<RobinStrategy>(robin_strategy);
+
+			uint32_t ndrums;
+			if (!ReadPod(in, ndrums) || ndrums > file_size) return false;
+
+			kit->drums.reserve(ndrums);
+
+			for (uint32_t d = 0; d < ndrums; d++)
+			{
+				std::string name, cumulative_path, drum_path, include_path;
+				int32_t midi_note;
+				double pan;
+				int32_t bus;
+				int32_t curve_type;
+				double curve_param;
+
+				if (!(ReadStr(in, name) && ReadStr(in, cumulative_path) && ReadStr(in, drum_path) && ReadStr(in, include_path) && ReadPod(in, midi_note) && ReadPod(in, pan) && ReadPod(in, bus) &&
+					ReadPod(in, curve_type) && ReadPod(in, curve_param)))
+				{
+					return false;
+				}
+
+				if (midi_note < 0 || midi_note > 127)
+				{
+					return false; // Corrupt. It indexes the note map.
+				}
+
+				auto drum = std::make_shared<MultiLayeredDrum>(name, "", drum_path, midi_note);
+				drum->cumulativePath = cumulative_path;
+				drum->includePath = include_path;
+				drum->pan = pan;
+				drum->bus = bus;
+				drum->velCurve.Generate(static_cast<VelocityCurveType>(curve_type), curve_param);
+
+				uint32_t nlayers;
+				if (!ReadPod(in, nlayers) || nlayers == 0 || nlayers > file_size) return false;
+
+				// Reserve up front, since we hang onto pointers to the robins
+
+				drum->velocityLayers.reserve(nlayers);
+
+				for (uint32_t l = 0; l < nlayers; l++)
+				{
+					std::string layer_cumulative_path, local_path;
+					int32_t vel_code, imin, imax;
+					double fmin, fmax;
+
+					if (!(ReadStr(in, layer_cumulative_path) && ReadStr(in, local_path) && ReadPod(in, vel_code) &&
+						ReadPod(in, imin) && ReadPod(in, imax) && ReadPod(in, fmin) && ReadPod(in, fmax)))
+					{
+						return false;
+					}
+
+					drum->velocityLayers.emplace_back(local_path, vel_code);
+
+					auto& layer = drum->velocityLayers.back();
+					layer.cumulativePath = layer_cumulative_path;
+					layer.vrange.iMinVel = imin;
+					layer.vrange.iMaxVel = imax;
+					layer.vrange.fMinVel = fmin;
+					layer.vrange.fMaxVel = fmax;
+
+					uint32_t nrobins;
+					if (!ReadPod(in, nrobins) || nrobins == 0 || nrobins > file_size) return false;
+
+					auto& robins = layer.robinMgr.robins;
+					robins.reserve(nrobins);
+
+					for (uint32_t r = 0; r < nrobins; r++)
+					{
+						std::string file_name, full_path;
+						double peak, rms, weight, data_rate;
+						uint32_t start_frame, end_frame, nframes, nchannels;
+						uint64_t offset;
+
+						if (!(ReadStr(in, file_name) && ReadStr(in, full_path) && ReadPod(in, peak) && ReadPod(in, rms) &&
+							ReadPod(in, start_frame) && ReadPod(in, end_frame) && ReadPod(in, weight) &&
+							ReadPod(in, offset) && ReadPod(in, nframes) && ReadPod(in, nchannels) && ReadPod(in, data_rate)))
+						{
+							return false;
+						}
+
+						uint64_t robin_samples = static_cast<uint64_t>(nframes) * nchannels;
+
+						if (nchannels == 0 || robin_samples > UINT32_MAX)
+						{
+							return false;
+						}
+
+						robins.emplace_back(file_name, peak, rms, start_frame, end_frame, weight);
+
+						auto& robin = robins.back();
+						robin.fullPath = full_path;
+						robin.wave.path = full_path;
+
+						auto& buff = robin.wave.buff;
+						buff.nFrames = nframes;
+						buff.nChannels = nchannels;
+						buff.nSamples = static_cast<unsigned>(robin_samples);
+						buff.dataRate = data_rate;
+
+						fixups.push_back({ &robin, offset });
+					}
+				}
+
+				kit->drums.push_back(drum);
+			}
+
+			new_kits.push_back(kit);
+		}
+
+		// Now the samples, in one go
+
+		uint64_t data_start, data_size;
+		if (!(ReadPod(in, data_start) && ReadPod(in, data_size))) return false;
+
+		if (data_start > file_size || data_size > file_size - data_start)
+		{
+			serr << "Compiled font file " << dfxc_path << " is truncated. Rebuilding." << std::endl;
+			return false;
+		}
+
+		auto nsamples = data_size / sizeof(double);
+		auto block = std::shared_ptr<double[]>(new double[nsamples > 0 ? nsamples : 1]);
+
+		in.seekg(data_start);
+		in.read(reinterpret_cast<char*>(block.get()), data_size);
+
+		if (!in)
+		{
+			serr << "Compiled font file " << dfxc_path << " is truncated. Rebuilding." << std::endl;
+			return false;
+		}
+
+		for (auto& f : fixups)
+		{
+			auto& buff = f.robin->wave.buff;
+
+			if (f.offset > data_size || buff.nSamples > (data_size - f.offset) / sizeof(double))
+			{
+				serr << "Compiled font file " << dfxc_path << " is corrupt. Rebuilding." << std::endl;
+				return false;
+			}
+
+			// Each robin aliases its stretch of the block, and they all
+			// keep the block alive between them.
+
+			buff.samples = std::shared_ptr<double[]>(block, block.get() + f.offset / sizeof(double));
+		}
+
+		for (auto& kit : new_kits)
+		{
+			for (auto& drum : kit->drums)
+			{
+				for (auto& layer : drum->velocityLayers)
+				{
+					layer.robinMgr.BuildAliasTable();
+				}
+			}
+
+			kit->FinishLevels();
+			kit->FinishRobins();
+			kit->BuildNoteMap();
+		}
+
+		kits = std::move(new_kits);
+
+		return true;
+	}
+
+} // end of namespace
@@ -0,0 +1,94 @@
+#pragma once
+
+/******************************************************************************\
+ * DFX - "Drum font exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This software helps facilitate the real-time playing of multi-layered drum
+ * samples, by implementing a language that specifies a master directory of the
+ * the sample wave files for a drum kit: where the samples are, what they are
+ * for, and a summary of their properties. The DFX format allows modifications
+ * of sample levels to achieve a unified, pleasing mix of sounds. Mechanisms
+ * such as velocity layers and round robins are supported for this purpose.
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate DFX files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <memory>
+#include <ostream>
+#include <filesystem>
+#include "DrumKit.h"
+
+namespace dfx
+{
+	// A compiled drum font (.dfxc) holds the kits of a drum font all built
+	// out, together with their samples already in the engine's storage
+	// format. Loading one skips the lexing, parsing, verifying, and building
+	// of the .dfx and .dfxi files, and the decoding of all the wave files.
+	//
+	// Layout (native byte order, since it's just a cache for this machine):
+	//
+	//   header      magic, version, byte order check, sample format, tail floor
+	//   sources     every .dfx, .dfxi and wave file the font was built from,
+	//               with its size, modification time, and content hash
+	//   kits        the kits, drums, velocity layers, and robins, each robin
+	//               pointing into the sample data by offset
+	//   samples     starting on a page boundary, each block 64 byte aligned,
+	//               so the section can be memory mapped as is
+	//
+	// The file is stale if any source has changed. We check the size and
+	// modification time first, and only hash the contents when the time
+	// differs (say after a fresh checkout), so the common case stays cheap.
+
+	struct CompiledSource
+	{
+		std::string path;
+		uint64_t size;
+		int64_t mtime;
+		uint64_t hash;
+	};
+
+	class CompiledFont {
+	public:
+
+		static constexpr uint32_t Magic = 0x43584644; // "DFXC"
+		static constexpr uint32_t Version = 7;
+		static constexpr uint32_t ByteOrderCheck = 0x01020304;
+		static constexpr uint64_t PageAlign = 4096;
+		static constexpr uint64_t BlockAlign = 64;
+
+	public:
+
+		static std::filesystem::path CompiledPath(const std::filesystem::path& font_path);
+
+		static bool MakeSource(CompiledSource& src, const std::filesystem::path& path, bool with_hash = true);
+		static bool SourceIsCurrent(const CompiledSource& src);
+		static uint64_t HashFile(const std::filesystem::path& path);
+
+		static bool Save(std::ostream& serr, const std::filesystem::path& dfxc_path, const std::vector<std::shared_ptr<DrumKit>>& kits, const std::vector<std::filesystem::path>& source_paths, double tail_floor_db);
+		static bool Load(std::ostream& serr, const std::filesystem::path& dfxc_path, std::vector<std::shared_ptr<DrumKit>>& kits, double tail_floor_db);
+	};
+
+} // end of namespace
@@ -0,0 +1,1008 @@
+/******************************************************************************\
+ * DFX - "Drum font exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This software helps facilitate the real-time playing of multi-layered drum
+ * samples, by implementing a language that specifies a master directory of the
+ * the sample wave files for a drum kit: where the samples are, what they are
+ * for, and a summary of their properties. The DFX format allows modifications
+ * of sample levels to achieve a unified, pleasing mix of sounds. Mechanisms
+ * such as velocity layers and round robins are supported for this purpose.
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate DFX files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "DfxEventBuilder.h"
+
+namespace dfx
+{
+	DfxEventBuilder::DfxEventBuilder(std::ostream& slog_, bool as_include_, std::string root_ctx_)
+	: slog(&slog_)
+	, errcnt(0)
+	, as_include(as_include_)
+	, root_ctx(std::move(root_ctx_))
+	, kits()
+	, drum()
+	, layer()
+	, robin("", 1.0, 1.0, 0, 0, 1.0)
+	, curve_type()
+	, curve_knee()
+	, curve_range()
+	, curve_errcnt(0)
+	, level_by()
+	, level_target()
+	, level_errcnt(0)
+	, choice_by()
+	, choice_jitter()
+	, choice_errcnt(0)
+	, frames()
+	, pending_name()
+	, skip_next(false)
+	{
+	}
+
+	// ///////////////////////////////////////////////////////////////
+	// The events
+
+	bool DfxEventBuilder::StartDocument(std::string_view /*moniker*/)
+	{
+		kits.clear();
+		drum = DrumSpec();
+		frames.clear();
+		pending_name.clear();
+		skip_next = false;
+		return true;
+	}
+
+	bool DfxEventBuilder::EndDocument()
+	{
+		return true;
+	}
+
+	bool DfxEventBuilder::Name(std::string_view name)
+	{
+		pending_name = name;
+		skip_next = false;
+
+		if (frames.empty()) return true;
+
+		// In a {}-list, the first of any duplicate names wins,
+		// so we skip the value of any that come after it.
+
+		auto& frame = frames.back();
+
+		switch (frame.node)
+		{
+			case NodeEnum::Velocities:
+			case NodeEnum::Robins:
+			case NodeEnum::Skip:
+			break;
+
+			default:
+			{
+				if (Seen(frame, name))
+				{
+					skip_next = true;
+				}
+				else frame.seen.emplace_back(name);
+			}
+			break;
+		}
+
+		return true;
+	}
+
+	bool DfxEventBuilder::StartCurlyList()
+	{
+		std::string name = std::move(pending_name);
+		pending_name.clear();
+
+		bool skip = skip_next;
+		skip_next = false;
+
+		if (frames.empty())
+		{
+			// The outermost {}-list. For a font, that's the kits. For an
+			// include file, it's the body of an instrument.
+
+			if (as_include)
+			{
+				drum = DrumSpec();
+				frames.emplace_back(NodeEnum::Drum, root_ctx);
+			}
+			else frames.emplace_back(NodeEnum::Root, "");
+
+			return true;
+		}
+
+		auto parent = Effective(frames.back());
+		++frames.back().nelements;
+
+		auto node = skip ? NodeEnum::Skip : StartNode(parent, name, false);
+
+		frames.emplace_back(node, name);
+
+		if (node == NodeEnum::Layer)
+		{
+			StartLayer(name, frames.back());
+		}
+
+		return true;
+	}
+
+	bool DfxEventBuilder::EndCurlyList()
+	{
+		FinishNode(frames.back());
+		frames.pop_back();
+		return true;
+	}
+
+	bool DfxEventBuilder::StartSquareList()
+	{
+		std::string name = std::move(pending_name);
+		pending_name.clear();
+
+		bool skip = skip_next;
+		skip_next = false;
+
+		if (frames.empty())
+		{
+			// Not a drum font, but the parser lets it thru in non-dfx mode
+			frames.emplace_back(NodeEnum::Skip, root_ctx);
+			return true;
+		}
+
+		auto parent = Effective(frames.back());
+		++frames.back().nelements;
+
+		auto node = skip ? NodeEnum::Skip : StartNode(parent, name, true);
+
+		frames.emplace_back(node, name);
+
+		return true;
+	}
+
+	bool DfxEventBuilder::EndSquareList()
+	{
+		FinishNode(frames.back());
+		frames.pop_back();
+		return true;
+	}
+
+	bool DfxEventBuilder::Simple(const TokenSpan& span)
+	{
+		std::string name = std::move(pending_name);
+		pending_name.clear();
+
+		bool skip = skip_next;
+		skip_next = false;
+
+		if (frames.empty() || skip) return true;
+
+		auto parent = Effective(frames.back());
+		++frames.back().nelements;
+
+		switch (parent)
+		{
+			case NodeEnum::Kit: SetKitProperty(name, span); break;
+			case NodeEnum::Drum: SetDrumProperty(name, span); break;
+			case NodeEnum::Layer: SetLayerProperty(name, span); break;
+			case NodeEnum::Robin: SetRobinProperty(name, span); break;
+			case NodeEnum::VelocityCurve: SetCurveProperty(name, span); break;
+			case NodeEnum::Leveling: SetLevelProperty(name, span); break;
+			case NodeEnum::RobinChoice: SetChoiceProperty(name, span); break;
+			case NodeEnum::Skip: break;
+			default: WrongType(parent, name); break;
+		}
+
+		return true;
+	}
+
+	// ///////////////////////////////////////////////////////////////
+	// Starting and finishing the lists we care about
+
+	DfxEventBuilder::NodeEnum DfxEventBuilder::StartNode(NodeEnum parent, const std::string& name, bool is_square)
+	{
+		// What kind of list is this, going by where it is? If it's not
+		// the kind of list that belongs there, we complain (if it's
+		// something we know about) and skip over it.
+
+		switch (parent)
+		{
+			case NodeEnum::Root:
+			{
+				if (!is_square)
+				{
+					kits.emplace_back();
+					kits.back().name = name;
+					return NodeEnum::Kit;
+				}
+			}
+			break;
+
+			case NodeEnum::Kit:
+			{
+				if (!is_square && name == "instruments") return NodeEnum::Instruments;
+				if (!is_square && name == "velocity_curve") return StartCurve();
+				if (!is_square && name == "leveling") return StartLeveling();
+				if (!is_square && name == "robin_choice") return StartRobinChoice();
+			}
+			break;
+
+			case NodeEnum::Instruments:
+			{
+				if (!is_square)
+				{
+					drum = DrumSpec();
+					drum.name = name;
+					return NodeEnum::Drum;
+				}
+			}
+			break;
+
+			case NodeEnum::Drum:
+			{
+				if (is_square && name == "velocities") return NodeEnum::Velocities;
+				if (!is_square && name == "velocity_curve") return StartCurve();
+			}
+			break;
+
+			case NodeEnum::Velocities:
+			{
+				// Each velocity layer must be a name-value pair, with
+				// a {}-list for a body
+
+				if (!is_square && !name.empty()) return NodeEnum::Layer;
+			}
+			break;
+
+			case NodeEnum::Layer:
+			{
+				if (is_square && name == "robins") return NodeEnum::Robins;
+			}
+			break;
+
+			case NodeEnum::Robins:
+			{
+				if (!is_square && !name.empty())
+				{
+					robin = Robin("", 1.0, 1.0, 0, 0, 1.0);
+					return NodeEnum::Robin;
+				}
+			}
+			break;
+
+			case NodeEnum::Robin:
+			case NodeEnum::VelocityCurve:
+			case NodeEnum::Leveling:
+			case NodeEnum::RobinChoice:
+			case NodeEnum::Skip:
+			break;
+		}
+
+		WrongType(parent, name);
+
+		return NodeEnum::Skip;
+	}
+
+	DfxEventBuilder::NodeEnum DfxEventBuilder::StartCurve()
+	{
+		curve_type.clear();
+		curve_knee = nullptr;
+		curve_range = nullptr;
+		curve_errcnt = errcnt;
+		return NodeEnum::VelocityCurve;
+	}
+
+	DfxEventBuilder::NodeEnum DfxEventBuilder::StartLeveling()
+	{
+		level_by.clear();
+		level_target = nullptr;
+		level_errcnt = errcnt;
+		return NodeEnum::Leveling;
+	}
+
+	DfxEventBuilder::NodeEnum DfxEventBuilder::StartRobinChoice()
+	{
+		choice_by.clear();
+		choice_jitter = nullptr;
+		choice_errcnt = errcnt;
+		return NodeEnum::RobinChoice;
+	}
+
+	void DfxEventBuilder::StartLayer(const std::string& code, Frame& frame)
+	{
+		// The velocity code is a "v" followed by a whole number. Or
+		// "vr" for a simplified velocity layer: one whose body is that
+		// of its one and only robin.
+
+		int vel_code;
+
+		auto result = DfxParser::MakeVelocityCode(code, vel_code, frame.layer_is_robin);
+
+		if (result != DfxResult::NoError)
+		{
+			LogError(Context(), result);
+		}
+
+		layer = VelocityLayer("", vel_code);
+
+		if (frame.layer_is_robin)
+		{
+			robin = Robin("", 1.0, 1.0, 0, 0, 1.0);
+		}
+	}
+
+	void DfxEventBuilder::FinishNode(const Frame& frame)
+	{
+		// Check for what's missing, then hand what we've built up
+		// to the next level.
+
+		switch (frame.node)
+		{
+			case NodeEnum::Kit:
+			{
+				if (!Seen(frame, "instruments"))
+				{
+					LogError(Context(), DfxResult::InstrumentsMissing);
+				}
+			}
+			break;
+
+			case NodeEnum::Drum:
+			{
+				bool is_include_body = as_include && frames.size() == 1;
+
+				if (!is_include_body && !Seen(frame, "note"))
+				{
+					LogError(Context(), DfxResult::NoteMissing);
+				}
+
+				if (!Seen(frame, "include") || is_include_body)
+				{
+					if (!Seen(frame, "velocities"))
+					{
+						LogError(Context("velocities"), DfxResult::VelocitiesMissing);
+					}
+				}
+
+				if (!is_include_body)
+				{
+					kits.back().drums.push_back(std::move(drum));
+				}
+			}
+			break;
+
+			case NodeEnum::Velocities:
+			{
+				if (frame.nelements == 0)
+				{
+					LogError(Context(), DfxResult::VelocitiesMustBeNonEmptySquareList);
+				}
+			}
+			break;
+
+			case NodeEnum::Layer:
+			{
+				if (frame.layer_is_robin)
+				{
+					if (!Seen(frame, "fname"))
+					{
+						LogError(Context("fname"), DfxResult::MustBeSpecified);
+					}
+
+					layer.robinMgr.robins.push_back(std::move(robin));
+				}
+				else if (!Seen(frame, "robins"))
+				{
+					LogError(Context(), DfxResult::RobinsMustBeNonEmptySquareList);
+				}
+
+				drum.velocityLayers.push_back(std::move(layer));
+			}
+			break;
+
+			case NodeEnum::Robins:
+			{
+				if (frame.nelements == 0)
+				{
+					LogError(Context(), DfxResult::RobinsMustBeNonEmptySquareList);
+				}
+			}
+			break;
+
+			case NodeEnum::Robin:
+			{
+				if (!Seen(frame, "fname"))
+				{
+					LogError(Context("fname"), DfxResult::MustBeSpecified);
+				}
+
+				layer.robinMgr.robins.push_back(std::move(robin));
+			}
+			break;
+
+			case NodeEnum::VelocityCurve:
+			{
+				// It goes to the kit or the drum, whichever it's in.
+				// (If its pieces were bad, we've already said so.)
+
+				if (errcnt != curve_errcnt) break;
+
+				VelocityCurve curve;
+				auto result = DfxParser::MakeVelocityCurve(curve_type, curve_knee, curve_range, curve);
+
+				if (result != DfxResult::NoError)
+				{
+					LogError(Context(), result);
+				}
+				else if (frames[frames.size() - 2].node == NodeEnum::Kit)
+				{
+					kits.back().velCurve = curve;
+				}
+				else drum.velCurve = curve;
+			}
+			break;
+
+			case NodeEnum::Leveling:
+			{
+				if (errcnt != level_errcnt) break;
+
+				auto& kit = kits.back();
+				auto result = DfxParser::MakeLeveling(level_by, level_target, kit.levelBy, kit.levelTarget);
+
+				if (result != DfxResult::NoError)
+				{
+					LogError(Context(), result);
+				}
+			}
+			break;
+
+			case NodeEnum::RobinChoice:
+			{
+				if (errcnt != choice_errcnt) break;
+
+				auto& kit = kits.back();
+				auto result = DfxParser::MakeRobinChoice(choice_by, choice_jitter, kit.robinStrategy, kit.velocityJitter);
+
+				if (result != DfxResult::NoError)
+				{
+					LogError(Context(), result);
+				}
+			}
+			break;
+
+			default:
+			break;
+		}
+	}
+
+	// ///////////////////////////////////////////////////////////////
+	// Properties
+
+	static bool IsString(const TokenSpan& span)
+	{
+		return span.type == TokenEnum::QuotedChars || span.type == TokenEnum::UnquotedChars;
+	}
+
+	static token_ptr WholeNumberOf(const TokenSpan& span)
+	{
+		if (span.type == TokenEnum::Number)
+		{
+			auto t = Lexi::ParseBryxNumber(span.text);
+
+			if (!t->IsErrorToken() && t->IsWholeNumber())
+			{
+				return t;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void DfxEventBuilder::SetKitProperty(const std::string& name, const TokenSpan& span)
+	{
+		if (name == "velocity_curve")
+		{
+			LogError(Context(name), DfxResult::VelocityCurveMustBeList);
+		}
+		else if (name == "leveling")
+		{
+			LogError(Context(name), DfxResult::LevelingMustBeList);
+		}
+		else if (name == "robin_choice")
+		{
+			LogError(Context(name), DfxResult::RobinChoiceMustBeList);
+		}
+		else if (name == "path" || name == "include_base_path")
+		{
+			if (!IsString(span))
+			{
+				LogError(Context(name), DfxResult::MustBeString);
+			}
+			else if (name == "path")
+			{
+				kits.back().path = TextOf(span);
+			}
+			else kits.back().includeBasePath = TextOf(span);
+		}
+		else WrongType(NodeEnum::Kit, name);
+	}
+
+	void DfxEventBuilder::SetDrumProperty(const std::string& name, const TokenSpan& span)
+	{
+		if (name == "note")
+		{
+			auto result = DfxParser::MakeNote(WholeNumberOf(span), drum.midiNote);
+
+			if (result != DfxResult::NoError)
+			{
+				LogError(Context(), result);
+			}
+		}
+		else if (name == "pan")
+		{
+			auto ctx = Context(name);
+			auto t = NumberOf(ctx, span, DfxResult::PanMustBeNumber);
+
+			if (t)
+			{
+				auto result = DfxParser::MakePan(t, drum.pan);
+
+				if (result != DfxResult::NoError)
+				{
+					LogError(ctx, result);
+				}
+			}
+		}
+		else if (name == "velocity_curve")
+		{
+			LogError(Context(name), DfxResult::VelocityCurveMustBeList);
+		}
+		else if (name == "bus")
+		{
+			auto result = DfxParser::MakeBus(WholeNumberOf(span), drum.bus);
+
+			if (result != DfxResult::NoError)
+			{
+				LogError(Context(), result);
+			}
+		}
+		else if (name == "path" || name == "include")
+		{
+			if (!IsString(span))
+			{
+				LogError(Context(name), DfxResult::MustBeString);
+			}
+			else if (name == "path")
+			{
+				drum.path = TextOf(span);
+			}
+			else drum.include = TextOf(span);
+		}
+		else WrongType(NodeEnum::Drum, name);
+	}
+
+	void DfxEventBuilder::SetLayerProperty(const std::string& name, const TokenSpan& span)
+	{
+		if (name == "path")
+		{
+			if (IsString(span))
+			{
+				layer.localPath = std::filesystem::path(TextOf(span)).generic_string();
+			}
+			else LogError(Context(name), DfxResult::MustBeString);
+		}
+		else WrongType(NodeEnum::Layer, name);
+	}
+
+	void DfxEventBuilder::SetRobinProperty(const std::string& name, const TokenSpan& span)
+	{
+		if (name == "fname")
+		{
+			if (IsString(span))
+			{
+				robin.fileName = TextOf(span);
+			}
+			else LogError(Context(name), DfxResult::MustBeString);
+		}
+		else if (name == "start" || name == "end")
+		{
+			auto& frame = name == "start" ? robin.start_frame : robin.end_frame;
+
+			auto result = DfxParser::MakeBound(WholeNumberOf(span), frame);
+
+			if (result != DfxResult::NoError)
+			{
+				LogError(Context(), result);
+			}
+		}
+		else if (name == "peak" || name == "rms")
+		{
+			auto ctx = Context(name);
+			auto t = NumberOf(ctx, span, name == "peak" ? DfxResult::PeakMustBeNumber : DfxResult::RmsMustBeNumber);
+
+			if (t)
+			{
+				auto result = DfxParser::MakeWaveMagnitude(t, name == "peak" ? robin.peak : robin.rms);
+
+				if (result != DfxResult::NoError)
+				{
+					LogError(ctx, result);
+				}
+			}
+		}
+		else if (name == "weight")
+		{
+			auto ctx = Context(name);
+			auto t = NumberOf(ctx, span, DfxResult::WeightMustBeNumber);
+
+			if (t)
+			{
+				auto result = DfxParser::MakeWeight(t, robin.weight);
+
+				if (result != DfxResult::NoError)
+				{
+					LogError(ctx, result);
+				}
+			}
+		}
+	}
+
+	void DfxEventBuilder::SetCurveProperty(const std::string& name, const TokenSpan& span)
+	{
+		// Just gather the pieces here. They're checked as a whole once
+		// the curve's {}-list ends.
+
+		if (name == "type")
+		{
+			if (IsString(span))
+			{
+				curve_type = TextOf(span);
+			}
+			else LogError(Context(name), DfxResult::VelocityCurveTypeInvalid);
+		}
+		else if (name == "knee" || name == "range")
+		{
+			auto t = NumberOf(Context(name), span, DfxResult::VelocityCurveParamMustBeNumber);
+
+			if (name == "knee")
+			{
+				curve_knee = t;
+			}
+			else curve_range = t;
+		}
+	}
+
+	void DfxEventBuilder::SetLevelProperty(const std::string& name, const TokenSpan& span)
+	{
+		if (name == "by")
+		{
+			if (IsString(span))
+			{
+				level_by = TextOf(span);
+			}
+			else LogError(Context(name), DfxResult::LevelByInvalid);
+		}
+		else if (name == "target")
+		{
+			level_target = NumberOf(Context(name), span, DfxResult::LevelTargetMustBeNumber);
+		}
+	}
+
+	void DfxEventBuilder::SetChoiceProperty(const std::string& name, const TokenSpan& span)
+	{
+		if (name == "by")
+		{
+			if (IsString(span))
+			{
+				choice_by = TextOf(span);
+			}
+			else LogError(Context(name), DfxResult::RobinChoiceByInvalid);
+		}
+		else if (name == "jitter")
+		{
+			choice_jitter = NumberOf(Context(name), span, DfxResult::JitterMustBeNumber);
+		}
+	}
+
+	void DfxEventBuilder::WrongType(NodeEnum parent, const std::string& name)
+	{
+		// Complain about a value that's the wrong kind of thing for
+		// where it is. Properties we don't know about are let go.
+
+		switch (parent)
+		{
+			case NodeEnum::Root:
+			{
+				LogError(Context(name), DfxResult::KitValWrongType);
+			}
+			break;
+
+			case NodeEnum::Kit:
+			{
+				if (name == "path" || name == "include_base_path")
+				{
+					LogError(Context(name), DfxResult::MustBeString);
+				}
+				else if (name == "instruments")
+				{
+					LogError(Context(), DfxResult::InstrumentsMustBeList);
+				}
+				else if (name == "velocity_curve")
+				{
+					LogError(Context(name), DfxResult::VelocityCurveMustBeList);
+				}
+				else if (name == "leveling")
+				{
+					LogError(Context(name), DfxResult::LevelingMustBeList);
+				}
+				else if (name == "robin_choice")
+				{
+					LogError(Context(name), DfxResult::RobinChoiceMustBeList);
+				}
+			}
+			break;
+
+			case NodeEnum::Instruments:
+			{
+				LogError(Context(name), DfxResult::DrumValMustBeList);
+			}
+			break;
+
+			case NodeEnum::Drum:
+			{
+				if (name == "note")
+				{
+					LogError(Context(), DfxResult::NoteMustBeWholeNumber);
+				}
+				else if (name == "pan")
+				{
+					LogError(Context(name), DfxResult::PanMustBeNumber);
+				}
+				else if (name == "bus")
+				{
+					LogError(Context(), DfxResult::BusMustBeWholeNumber);
+				}
+				else if (name == "path" || name == "include")
+				{
+					LogError(Context(name), DfxResult::MustBeString);
+				}
+				else if (name == "velocities")
+				{
+					LogError(Context(name), DfxResult::VelocitiesMustBeNonEmptySquareList);
+				}
+				else if (name == "velocity_curve")
+				{
+					LogError(Context(name), DfxResult::VelocityCurveMustBeList);
+				}
+			}
+			break;
+
+			case NodeEnum::Velocities:
+			{
+				LogError(Context(), DfxResult::VelocityMustBeNameValue);
+			}
+			break;
+
+			case NodeEnum::Layer:
+			{
+				if (name == "path")
+				{
+					LogError(Context(name), DfxResult::MustBeString);
+				}
+				else if (name == "robins")
+				{
+					LogError(Context(), DfxResult::RobinsMustBeNonEmptySquareList);
+				}
+			}
+			break;
+
+			case NodeEnum::Robins:
+			{
+				LogError(Context(), DfxResult::RobinMustBeNameValue);
+			}
+			break;
+
+			case NodeEnum::Robin:
+			{
+				if (name == "fname")
+				{
+					LogError(Context(name), DfxResult::MustBeString);
+				}
+				else if (name == "start" || name == "end")
+				{
+					LogError(Context(), DfxResult::BoundMustBeWholeNumber);
+				}
+				else if (name == "peak")
+				{
+					LogError(Context(name), DfxResult::PeakMustBeNumber);
+				}
+				else if (name == "rms")
+				{
+					LogError(Context(name), DfxResult::RmsMustBeNumber);
+				}
+				else if (name == "weight")
+				{
+					LogError(Context(name), DfxResult::WeightMustBeNumber);
+				}
+			}
+			break;
+
+			case NodeEnum::VelocityCurve:
+			{
+				if (name == "type")
+				{
+					LogError(Context(name), DfxResult::VelocityCurveTypeInvalid);
+				}
+				else if (name == "knee" || name == "range")
+				{
+					LogError(Context(name), DfxResult::VelocityCurveParamMustBeNumber);
+				}
+			}
+			break;
+
+			case NodeEnum::Leveling:
+			{
+				if (name == "by")
+				{
+					LogError(Context(name), DfxResult::LevelByInvalid);
+				}
+				else if (name == "target")
+				{
+					LogError(Context(name), DfxResult::LevelTargetMustBeNumber);
+				}
+			}
+			break;
+
+			case NodeEnum::RobinChoice:
+			{
+				if (name == "by")
+				{
+					LogError(Context(name), DfxResult::RobinChoiceByInvalid);
+				}
+				else if (name == "jitter")
+				{
+					LogError(Context(name), DfxResult::JitterMustBeNumber);
+				}
+			}
+			break;
+
+			case NodeEnum::Skip:
+			break;
+		}
+	}
+
+	// ///////////////////////////////////////////////////////////////
+	// Helpers
+
+	DfxEventBuilder::NodeEnum DfxEventBuilder::Effective(const Frame& frame)
+	{
+		// The body of a simplified velocity layer is a robin body
+
+		if (frame.node == NodeEnum::Layer && frame.layer_is_robin)
+		{
+			return NodeEnum::Robin;
+		}
+
+		return frame.node;
+	}
+
+	bool DfxEventBuilder::Seen(const Frame& frame, std::string_view name) const
+	{
+		for (auto& s : frame.seen)
+		{
+			if (s == name) return true;
+		}
+
+		return false;
+	}
+
+	std::string DfxEventBuilder::Context(const std::string& name) const
+	{
+		// Where we are, as a path of names
+
+		std::string ctx;
+
+		for (auto& f : frames)
+		{
+			if (f.name.empty()) continue;
+			if (!ctx.empty()) ctx += '/';
+			ctx += f.name;
+		}
+
+		if (!name.empty())
+		{
+			if (!ctx.empty()) ctx += '/';
+			ctx += name;
+		}
+
+		return ctx;
+	}
+
+	std::string DfxEventBuilder::TextOf(const TokenSpan& span)
+	{
+		if (span.has_escapes)
+		{
+			// The lexer has already vetted the escapes
+			std::string s;
+			Lexi::Unescape(span.text, s);
+			return s;
+		}
+
+		return std::string(span.text);
+	}
+
+	token_ptr DfxEventBuilder::NumberOf(const std::string& ctx, const TokenSpan& span, DfxResult err)
+	{
+		// Like DfxParser::ProcessAsNumber(), we let the number be in a
+		// string too. (It has to be, in Json syntax, if it has units.)
+
+		token_ptr t;
+
+		if (span.type == TokenEnum::Number)
+		{
+			t = Lexi::ParseBryxNumber(span.text);
+		}
+		else if (IsString(span))
+		{
+			t = Lexi::ParseBryxNumber(TextOf(span));
+		}
+		else
+		{
+			LogError(ctx, err);
+			return nullptr;
+		}
+
+		if (t->IsErrorToken())
+		{
+			auto err_t = std::dynamic_pointer_cast<SimpleToken>(t);
+			LogError(ctx, err, err_t->result_pkg);
+			return nullptr;
+		}
+
+		return t;
+	}
+
+	DfxResult DfxEventBuilder::LogError(const std::string ctx, DfxResult err)
+	{
+		std::ostream& sl = *slog;
+		sl << "ERROR: ";
+		sl << "Context " << ctx << ": ";
+		sl << to_string(err) << std::endl;
+		++errcnt;
+		return err;
+	}
+
+	DfxResult DfxEventBuilder::LogError(const std::string ctx, DfxResult err, LexiResultPkg& err_pkg)
+	{
+		std::ostream& sl = *slog;
+		sl << "ERROR: ";
+		sl << "Context " << ctx << ": ";
+		sl << to_string(err) << std::endl;
+		sl << "Lexical err --> " << err_pkg.msg << " near (" << err_pkg.extent.ecol << ")" << std::endl;
+		++errcnt;
+		return err;
+	}
+
+} // end of namespace
@@ -0,0 +1,196 @@
+#pragma once
+
+/******************************************************************************\
+ * DFX - "Drum font exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This software helps facilitate the real-time playing of multi-layered drum
+ * samples, by implementing a language that specifies a master directory of the
+ * the sample wave files for a drum kit: where the samples are, what they are
+ * for, and a summary of their properties. The DFX format allows modifications
+ * of sample levels to achieve a unified, pleasing mix of sounds. Mechanisms
+ * such as velocity layers and round robins are supported for this purpose.
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate DFX files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include <string>
+#include <vector>
+#include "BryxEvents.h"
+#include "DfxParser.h"
+#include "VelocityLayer.h"
+
+namespace dfx
+{
+	using namespace bryx;
+
+	// What the builder knows about an instrument. The velocity layers
+	// and their robins are built for real as they're parsed. The drum
+	// itself gets made when its kit does (see DrumFont::LoadStreamed()).
+
+	struct DrumSpec {
+		std::string name;
+		int midiNote;
+		double pan;
+		int bus;
+		VelocityCurve velCurve;
+		std::string path;
+		std::string include;   // Non-empty if the velocity layers are in an include file
+		std::vector<VelocityLayer> velocityLayers;
+
+		DrumSpec() : name(), midiNote(0), pan(0.0), bus(0), velCurve(), path(), include(), velocityLayers() { }
+	};
+
+	struct KitSpec {
+		std::string name;
+		std::string path;
+		std::string includeBasePath;
+		VelocityCurve velCurve;
+		LevelBy levelBy;
+		double levelTarget;
+		RobinStrategy robinStrategy;
+		double velocityJitter;
+		std::vector<DrumSpec> drums;
+
+		KitSpec() : name(), path(), includeBasePath(), velCurve(), levelBy(LevelBy::None), levelTarget(1.0), robinStrategy(RobinStrategy::Cycle), velocityJitter(0.0), drums() { }
+	};
+
+
+	// ////////////////////////////////////////////////////////////////////
+	//
+	// Builds a drum font in one pass, straight from the events of a
+	// bryx::EventParser. There's no parse tree, and no separate verify
+	// pass: the rules DfxParser::Verify() checks are checked here as the
+	// pieces go by, and logged the same way.
+	//
+	// As with the parse tree, if a {}-list has duplicate names, the
+	// first one wins and the rest are ignored.
+	//
+	// ////////////////////////////////////////////////////////////////////
+
+	class DfxEventBuilder : public EventHandler {
+	public:
+
+		enum class NodeEnum
+		{
+			Root,
+			Kit,
+			Instruments,
+			Drum,
+			Velocities,
+			Layer,
+			Robins,
+			Robin,
+			VelocityCurve,
+			Leveling,
+			RobinChoice,
+			Skip        // Something we don't know or care about, or that's in error
+		};
+
+		struct Frame {
+			NodeEnum node;
+			std::string name;
+			std::vector<std::string> seen; // Names of the members so far, for {}-lists
+			size_t nelements;
+			bool layer_is_robin;           // For the simplified (vr) velocity layers
+
+			Frame(NodeEnum node_, std::string name_)
+			: node(node_), name(std::move(name_)), seen(), nelements(0), layer_is_robin(false)
+			{
+			}
+		};
+
+		std::ostream* slog;
+		int errcnt;
+
+		bool as_include;   // Root is an instrument include file, rather than a font
+		std::string root_ctx;
+
+		std::vector<KitSpec> kits;   // What we've got, when not an include file
+		DrumSpec drum;               // The drum in progress, or the include file's layers
+		VelocityLayer layer;         // Ditto for the velocity layer
+		Robin robin;                 // And the robin
+
+		std::string curve_type;      // The pieces of the velocity curve in progress
+		token_ptr curve_knee;
+		token_ptr curve_range;
+		int curve_errcnt;            // Errors logged before the curve started
+
+		std::string level_by;        // Likewise for the kit's leveling
+		token_ptr level_target;
+		int level_errcnt;
+
+		std::string choice_by;       // And the kit's robin choice
+		token_ptr choice_jitter;
+		int choice_errcnt;
+
+		std::vector<Frame> frames;
+		std::string pending_name;
+		bool skip_next;              // Value belongs to a duplicate name
+
+	public:
+
+		DfxEventBuilder(std::ostream& slog_, bool as_include_, std::string root_ctx_);
+		virtual ~DfxEventBuilder() { }
+
+	public:
+
+		virtual bool StartDocument(std::string_view moniker);
+		virtual bool EndDocument();
+		virtual bool StartCurlyList();
+		virtual bool EndCurlyList();
+		virtual bool StartSquareList();
+		virtual bool EndSquareList();
+		virtual bool Name(std::string_view name);
+		virtual bool Simple(const TokenSpan& span);
+
+		DfxResult LogError(const std::string ctx, DfxResult err);
+		DfxResult LogError(const std::string ctx, DfxResult err, LexiResultPkg& err_pkg);
+
+	protected:
+
+		NodeEnum StartNode(NodeEnum parent, const std::string& name, bool is_square);
+		void FinishNode(const Frame& frame);
+
+		void StartLayer(const std::string& code, Frame& frame);
+		NodeEnum StartCurve();
+		NodeEnum StartLeveling();
+		NodeEnum StartRobinChoice();
+		void SetKitProperty(const std::string& name, const TokenSpan& span);
+		void SetDrumProperty(const std::string& name, const TokenSpan& span);
+		void SetLayerProperty(const std::string& name, const TokenSpan& span);
+		void SetRobinProperty(const std::string& name, const TokenSpan& span);
+		void SetCurveProperty(const std::string& name, const TokenSpan& span);
+		void SetLevelProperty(const std::string& name, const TokenSpan& span);
+		void SetChoiceProperty(const std::string& name, const TokenSpan& span);
+
+		void WrongType(NodeEnum parent, const std::string& name);
+
+		static NodeEnum Effective(const Frame& frame);
+		bool Seen(const Frame& frame, std::string_view name) const;
+		std::string Context(const std::string& name = "") const;
+		static std::string TextOf(const TokenSpan& span);
+		token_ptr NumberOf(const std::string& ctx, const TokenSpan& span, DfxResult err);
+	};
+
+}; // end of namespace
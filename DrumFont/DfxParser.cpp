@@ -52,6 +52,9 @@ namespace dfx
 			case DfxResult::MustBeString: s = "Must be a double quoted string"; break;
 			case DfxResult::NoteMissing: s = "Drum note missing"; break;
 			case DfxResult::NoteMustBeWholeNumber: s = "Note must be whole number"; break;
+			case DfxResult::PanMustBeNumber: s = "Pan must be whole or floating point number, with no units"; break;
+			case DfxResult::PanOutOfRange: s = "Pan must be in range -1 (hard left) <= val <= 1 (hard right)"; break;
+			case DfxResult::BusMustBeWholeNumber: s = "Bus must be a whole number, 0 or more"; break;
 			case DfxResult::KitsMissing: s = "Kits are missing"; break;
 			case DfxResult::KitValWrongType: s = "Kit value must be a {}-list type"; break;
 			case DfxResult::InstrumentIncludeDataMissing: s = "Instrument include file data is missing."; break;
@@ -60,6 +63,7 @@ namespace dfx
 			case DfxResult::DrumValMustBeList: s = "Drum info must be in a {}-list"; break;
 			case DfxResult::VelocitiesMissing: s = "Velocity layers are missing"; break;
 			case DfxResult::VelocitiesMustBeNonEmptySquareList: s = "Velocity layers must be in a non-empty array"; break;
+			case DfxResult::VelocityMustBeNameValue: s = "Velocity layer must be a name-value pair"; break;
 			case DfxResult::InvalidVelocityCode: s = "Invalid velocity code"; break;
 			case DfxResult::RobinsMissing: s = "Robins are missing"; break;
 			case DfxResult::RobinsMustBeNonEmptySquareList: s = "Robins must be in a non-empty []-list"; break;
@@ -71,6 +75,20 @@ namespace dfx
 			case DfxResult::PeakMissing: s = "peak must be specified"; break;
 			case DfxResult::RmsMustBeNumber: s = "Rms must be whole or floating point number (suffix units allowed)"; break;
 			case DfxResult::RmsMissing: s = "rms must be specified"; break;
+			case DfxResult::WeightMustBeNumber: s = "Weight must be whole or floating point number, with no units"; break;
+			case DfxResult::WeightMustNotBeNegative: s = "Weight must not be negative"; break;
+			case DfxResult::VelocityCurveMustBeList: s = "Velocity curve must be a {}-list"; break;
+			case DfxResult::VelocityCurveTypeInvalid: s = "Velocity curve type must be linear, knee, or dynrange"; break;
+			case DfxResult::VelocityCurveParamMustBeNumber: s = "Velocity curve knee and range must be whole or floating point numbers"; break;
+			case DfxResult::KneeOutOfRange: s = "Knee must be in range 0 < val < 1, with no units"; break;
+			case DfxResult::DynRangeOutOfRange: s = "Dynamic range must be more than 0 dB"; break;
+			case DfxResult::LevelingMustBeList: s = "Leveling must be a {}-list"; break;
+			case DfxResult::LevelByInvalid: s = "Leveling must be by peak or rms"; break;
+			case DfxResult::LevelTargetMustBeNumber: s = "Leveling target must be a number"; break;
+			case DfxResult::RobinChoiceMustBeList: s = "Robin choice must be a {}-list"; break;
+			case DfxResult::RobinChoiceByInvalid: s = "Robins must be chosen by cycle, random, weighted or jittered"; break;
+			case DfxResult::JitterMustBeNumber: s = "Velocity jitter must be a number"; break;
+			case DfxResult::JitterOutOfRange: s = "Velocity jitter must be in range 0 < jitter <= 1"; break;
 			case DfxResult::ValueHasWrongUnits: s = "value can only have ratio units"; break;
 			case DfxResult::ValueNotLegal: s = "value when converted to unitless number must be in range 0 < val <= 1.0"; break;
 			case DfxResult::VerifyFailed: s = "Verify failed"; break;
@@ -262,6 +280,18 @@ namespace dfx
 			must_be_specified = false;
 			VerifyIncludeBasePath(kit_name, kitmap_ptr, must_be_specified);
 
+			// And an optional velocity curve for its instruments
+
+			VerifyVelocityCurve(kit_name, kitmap_ptr, must_be_specified);
+
+			// And optional leveling of its robins
+
+			VerifyLeveling(kit_name, kitmap_ptr, must_be_specified);
+
+			// And an optional way of choosing the robins
+
+			VerifyRobinChoice(kit_name, kitmap_ptr, must_be_specified);
+
 			// Okay, on to the main show: the {}-list of instruments.
 
 			auto vp = GetPropertyValue(kitmap_ptr, "instruments");
@@ -435,6 +465,19 @@ namespace dfx
 			bool must_be_specified = true;
 			VerifyNote(new_ctx, drum_map_ptr, must_be_specified);
 
+			// It can have an optional pan position
+
+			must_be_specified = false;
+			VerifyPan(new_ctx, drum_map_ptr, must_be_specified);
+
+			// And an optional output bus to play on
+
+			VerifyBus(new_ctx, drum_map_ptr, must_be_specified);
+
+			// And an optional velocity curve (otherwise it uses the kit's)
+
+			VerifyVelocityCurve(new_ctx, drum_map_ptr, must_be_specified);
+
 			// It can have an optional relative path and at least one
 			// velocity layer. These can be inserted immediately in this
 			// file, or they can be included from an external file.
@@ -492,35 +535,154 @@ namespace dfx
 			// Ie. a whole number?
 
 			auto svp = AsSimpleValue(vp);
+			int note;
 
-			if (svp)
+			auto result = MakeNote(svp ? svp->tkn : nullptr, note);
+
+			if (result != DfxResult::NoError)
 			{
-				// Okay, it's a simple value. Is it a whole number?
+				LogError(ctx, result);
+			}
+		}
+		else
+		{
+			if (must_be_specified)
+			{
+				LogError(ctx, DfxResult::NoteMissing);
+			}
+		}
 
-				if (svp->tkn->IsWholeNumber())
-				{
-				}
-				else
+		return errcnt == save_errcnt;
+	}
+
+	DfxResult DfxParser::MakeNote(const token_ptr& tkn, int& note)
+	{
+		// Checks a note token, and if it's good, gives its value. The
+		// token is null if the note wasn't a simple value. This and the
+		// other Make functions below are shared by the tree and event
+		// loaders, so they agree.
+
+		if (!tkn || !tkn->IsWholeNumber())
+		{
+			return DfxResult::NoteMustBeWholeNumber;
+		}
+
+		note = static_cast<int>(std::dynamic_pointer_cast<NumberToken>(tkn)->X());
+
+		return DfxResult::NoError;
+	}
+
+	bool DfxParser::VerifyPan(const std::string ctx, const curly_list_type* parent_map, bool must_be_specified)
+	{
+		int save_errcnt = errcnt;
+
+		// Check for a possibly optional pan position. It's a plain number,
+		// from -1 (hard left) through 0 (center) to 1 (hard right).
+
+		auto new_ctx = ctx + '/' + "pan";
+
+		auto vp = GetPropertyValue(parent_map, "pan");
+
+		if (vp)
+		{
+			auto num_tkn_ptr = ProcessAsNumber(new_ctx, vp, DfxResult::PanMustBeNumber);
+
+			if (num_tkn_ptr)
+			{
+				double pan;
+
+				auto result = MakePan(num_tkn_ptr, pan);
+
+				if (result != DfxResult::NoError)
 				{
-					LogError(ctx, DfxResult::NoteMustBeWholeNumber);
+					LogError(new_ctx, result);
 				}
 			}
-			else
+		}
+		else
+		{
+			if (must_be_specified)
 			{
-				LogError(ctx, DfxResult::NoteMustBeWholeNumber);
+				LogError(ctx, DfxResult::MustBeSpecified);
+			}
+		}
+
+		return errcnt == save_errcnt;
+	}
+
+	DfxResult DfxParser::MakePan(const token_ptr& tkn, double& pan)
+	{
+		// Here, we know it's a number.
+
+		auto nt = std::dynamic_pointer_cast<NumberToken>(tkn);
+
+		if (nt->units != UnitEnum::None)
+		{
+			return DfxResult::PanMustBeNumber;
+		}
+
+		if (nt->X() < -1.0 || nt->X() > 1.0)
+		{
+			return DfxResult::PanOutOfRange;
+		}
+
+		pan = nt->X();
+
+		return DfxResult::NoError;
+	}
+
+	bool DfxParser::VerifyBus(const std::string ctx, const curly_list_type* parent_map, bool must_be_specified)
+	{
+		int save_errcnt = errcnt;
+
+		// Check for a possibly optional output bus. It's a whole number.
+		// Bus 0 is the main one. We don't know here how many buses there
+		// will be. (The drummer plays drums on buses it doesn't have on 0.)
+
+		auto vp = GetPropertyValue(parent_map, "bus");
+
+		if (vp)
+		{
+			auto svp = AsSimpleValue(vp);
+			int bus;
+
+			auto result = MakeBus(svp ? svp->tkn : nullptr, bus);
+
+			if (result != DfxResult::NoError)
+			{
+				LogError(ctx, result);
 			}
 		}
 		else
 		{
 			if (must_be_specified)
 			{
-				LogError(ctx, DfxResult::NoteMissing);
+				LogError(ctx, DfxResult::MustBeSpecified);
 			}
 		}
 
 		return errcnt == save_errcnt;
 	}
 
+	DfxResult DfxParser::MakeBus(const token_ptr& tkn, int& bus)
+	{
+		if (!tkn || !tkn->IsWholeNumber())
+		{
+			return DfxResult::BusMustBeWholeNumber;
+		}
+
+		auto nt = std::dynamic_pointer_cast<NumberToken>(tkn);
+
+		if (nt->X() < 0.0)
+		{
+			return DfxResult::BusMustBeWholeNumber;
+		}
+
+		bus = static_cast<int>(nt->X());
+
+		return DfxResult::NoError;
+	}
+
 	bool DfxParser::VerifyVelocityLayers(const std::string ctx, const curly_list_type* parent_map)
 	{
 		int save_errcnt = errcnt;
@@ -566,7 +728,7 @@ namespace dfx
 		return errcnt == save_errcnt;
 	}
 
-	bool DfxParser::VerifyVelocityLayer(const std::string ctx, std::shared_ptr<Value>& vlayer_sh_ptr)
+	bool DfxParser::VerifyVelocityLayer(const std::string ctx, value_ptr vlayer_sh_ptr)
 	{
 		int save_errcnt = errcnt;
 
@@ -579,38 +741,14 @@ namespace dfx
 
 			// vel_code must start with a "v" or "vr"
 
-			bool simplified_robin = false;
-			const char* p = nullptr;
+			int vel_code;
+			bool simplified_robin;
 
-			if (vel_code_str.find("vr", 0) == 0)
-			{
-				simplified_robin = true;
-				p = vel_code_str.c_str();
-				p += 2; // past the vr
-			}
-			else if (vel_code_str.find("v", 0) == 0)
-			{
-				p = vel_code_str.c_str();
-				++p; // past the v
-			}
-
-			if (p)
-			{
-				// The rest of the characters must be digits between 0-9
+			auto result = MakeVelocityCode(vel_code_str, vel_code, simplified_robin);
 
-				while (*p)
-				{
-					if (!Lexi::IsDigit(*p))
-					{
-						LogError(ctx, DfxResult::InvalidVelocityCode);
-						break;
-					}
-					++p;
-				}
-			}
-			else
+			if (result != DfxResult::NoError)
 			{
-				LogError(ctx + vel_code_str, DfxResult::InvalidVelocityCode);
+				LogError(ctx + vel_code_str, result);
 			}
 
 			// Okay, regardless of whether we have a valid velocity code,
@@ -655,6 +793,55 @@ namespace dfx
 		return errcnt == save_errcnt;
 	}
 
+	DfxResult DfxParser::MakeVelocityCode(const std::string& code, int& vel_code, bool& is_robin)
+	{
+		// A velocity code is a "v" followed by a whole number 0-127. Or
+		// "vr" for a simplified velocity layer: one whose body is that
+		// of its one and only robin. is_robin is set even if the rest
+		// of the code is bad, so the body can still be checked.
+
+		size_t n = 0;
+
+		is_robin = false;
+		vel_code = 0;
+
+		if (code.find("vr", 0) == 0)
+		{
+			is_robin = true;
+			n = 2;
+		}
+		else if (code.find("v", 0) == 0)
+		{
+			n = 1;
+		}
+
+		if (n == 0 || n == code.size())
+		{
+			return DfxResult::InvalidVelocityCode;
+		}
+
+		int v = 0;
+
+		for (size_t i = n; i < code.size(); i++)
+		{
+			if (!Lexi::IsDigit(code[i]))
+			{
+				return DfxResult::InvalidVelocityCode;
+			}
+
+			v = v * 10 + (code[i] - '0');
+
+			if (v > 127)
+			{
+				return DfxResult::InvalidVelocityCode;
+			}
+		}
+
+		vel_code = v;
+
+		return DfxResult::NoError;
+	}
+
 	bool DfxParser::VerifyRobins(const std::string ctx, const curly_list_type* parent_map_ptr)
 	{
 		int save_errcnt = errcnt;
@@ -696,7 +883,7 @@ namespace dfx
 		return errcnt == save_errcnt;
 	}
 
-	bool DfxParser::VerifyRobin(const std::string ctx, std::shared_ptr<NameValue> &robin_nv_ptr)
+	bool DfxParser::VerifyRobin(const std::string ctx, NameValue* robin_nv_ptr)
 	{
 		int save_errcnt = errcnt;
 
@@ -743,6 +930,7 @@ namespace dfx
 
 		VerifyPeak(ctx, robin_body_map_ptr, must_be_specified);
 		VerifyRMS(ctx, robin_body_map_ptr, must_be_specified);
+		VerifyWeight(ctx, robin_body_map_ptr, must_be_specified);
 
 		return errcnt == save_errcnt;
 	}
@@ -775,7 +963,7 @@ namespace dfx
 	}
 
 
-	bool DfxParser::VerifyFname(const std::string ctx, std::shared_ptr<Value> &vp)
+	bool DfxParser::VerifyFname(const std::string ctx, value_ptr vp)
 	{
 		int save_errcnt = errcnt;
 
@@ -820,22 +1008,13 @@ namespace dfx
 			// Is it a whole number?
 
 			auto svp = AsSimpleValue(vp);
+			unsigned frame;
 
-			if (svp)
-			{
-				// Okay, it's a simple value. Is it a whole number?
+			auto result = MakeBound(svp ? svp->tkn : nullptr, frame);
 
-				if (svp->tkn->IsWholeNumber())
-				{
-				}
-				else
-				{
-					LogError(ctx, DfxResult::BoundMustBeWholeNumber);
-				}
-			}
-			else
+			if (result != DfxResult::NoError)
 			{
-				LogError(ctx, DfxResult::BoundMustBeWholeNumber);
+				LogError(ctx, result);
 			}
 		}
 		else
@@ -864,22 +1043,13 @@ namespace dfx
 			// Is it a whole number?
 
 			auto svp = AsSimpleValue(vp);
+			unsigned frame;
 
-			if (svp)
-			{
-				// Okay, it's a simple value. Is it a whole number?
+			auto result = MakeBound(svp ? svp->tkn : nullptr, frame);
 
-				if (svp->tkn->IsWholeNumber())
-				{
-				}
-				else
-				{
-					LogError(ctx, DfxResult::BoundMustBeWholeNumber);
-				}
-			}
-			else
+			if (result != DfxResult::NoError)
 			{
-				LogError(ctx, DfxResult::BoundMustBeWholeNumber);
+				LogError(ctx, result);
 			}
 		}
 		else
@@ -893,6 +1063,18 @@ namespace dfx
 		return errcnt == save_errcnt;
 	}
 
+	DfxResult DfxParser::MakeBound(const token_ptr& tkn, unsigned& frame)
+	{
+		if (!tkn || !tkn->IsWholeNumber())
+		{
+			return DfxResult::BoundMustBeWholeNumber;
+		}
+
+		frame = static_cast<unsigned>(std::dynamic_pointer_cast<NumberToken>(tkn)->X());
+
+		return DfxResult::NoError;
+	}
+
 	bool DfxParser::VerifyPeak(const std::string ctx, const curly_list_type* parent_map, bool must_be_specified)
 	{
 		int save_errcnt = errcnt;
@@ -910,17 +1092,13 @@ namespace dfx
 		{
 			// We found the property. Is it a number with the right range?
 
-			auto num_tkn_ptr = ProcessAsNumber(new_ctx, vp);
+			auto num_tkn_ptr = ProcessAsNumber(new_ctx, vp, DfxResult::PeakMustBeNumber);
 
 			if (num_tkn_ptr)
 			{
 				// We've got a number. Is it in the right range?
 				VerifyWaveMagnitude(new_ctx, num_tkn_ptr);
 			}
-			else
-			{
-				LogError(ctx, DfxResult::RmsMustBeNumber);
-			}
 		}
 		else
 		{
@@ -950,31 +1128,493 @@ namespace dfx
 		{
 			// We found the property. Is it a number with the right range?
 
-			auto num_tkn_ptr = ProcessAsNumber(new_ctx, vp);
+			auto num_tkn_ptr = ProcessAsNumber(new_ctx, vp, DfxResult::RmsMustBeNumber);
 
 			if (num_tkn_ptr)
 			{
 				// We've got a number. Is it in the right range?
 				VerifyWaveMagnitude(new_ctx, num_tkn_ptr);
 			}
+		}
+		else
+		{
+			if (must_be_specified)
+			{
+				LogError(ctx, DfxResult::RmsMissing);
+			}
+		}
+
+		return errcnt == save_errcnt;
+	}
+
+	bool DfxParser::VerifyWeight(const std::string ctx, const curly_list_type* parent_map, bool must_be_specified)
+	{
+		int save_errcnt = errcnt;
+
+		// Check for a possibly optional weight specification. Used when
+		// choosing robins by weighted random selection. It's a plain number,
+		// relative to the weights of the other robins in the layer.
+
+		auto new_ctx = ctx + '/' + "weight";
+
+		auto vp = GetPropertyValue(parent_map, "weight");
+
+		if (vp)
+		{
+			auto num_tkn_ptr = ProcessAsNumber(new_ctx, vp, DfxResult::WeightMustBeNumber);
+
+			if (num_tkn_ptr)
+			{
+				double weight;
+
+				auto result = MakeWeight(num_tkn_ptr, weight);
+
+				if (result != DfxResult::NoError)
+				{
+					LogError(new_ctx, result);
+				}
+			}
+		}
+		else
+		{
+			if (must_be_specified)
+			{
+				LogError(ctx, DfxResult::MustBeSpecified);
+			}
+		}
+
+		return errcnt == save_errcnt;
+	}
+
+	DfxResult DfxParser::MakeWeight(const token_ptr& tkn, double& weight)
+	{
+		// Here, we know it's a number.
+
+		auto nt = std::dynamic_pointer_cast<NumberToken>(tkn);
+
+		if (nt->units != UnitEnum::None)
+		{
+			return DfxResult::WeightMustBeNumber;
+		}
+
+		if (nt->X() < 0.0)
+		{
+			return DfxResult::WeightMustNotBeNegative;
+		}
+
+		weight = nt->X();
+
+		return DfxResult::NoError;
+	}
+
+	bool DfxParser::VerifyVelocityCurve(const std::string ctx, const curly_list_type* parent_map, bool must_be_specified)
+	{
+		int save_errcnt = errcnt;
+
+		// Check for a possibly optional velocity curve. It's a {}-list,
+		// such as { type = knee, knee = 0.6 } or { type = dynrange,
+		// range = 40dB } or { type = linear }. The old velcurve property
+		// found in some fonts was never acted on, and still isn't. It's
+		// let go like any other property we don't know about.
+
+		auto new_ctx = ctx + '/' + "velocity_curve";
+
+		auto vp = GetPropertyValue(parent_map, "velocity_curve");
+
+		if (vp)
+		{
+			auto curve_map_ptr = AsCurlyList(vp);
+
+			if (curve_map_ptr)
+			{
+				VelocityCurve curve;
+				ProcessVelocityCurve(new_ctx, curve_map_ptr, curve);
+			}
 			else
 			{
-				LogError(ctx, DfxResult::RmsMustBeNumber);
+				LogError(new_ctx, DfxResult::VelocityCurveMustBeList);
 			}
 		}
 		else
 		{
 			if (must_be_specified)
 			{
-				LogError(ctx, DfxResult::RmsMissing);
+				LogError(new_ctx, DfxResult::MustBeSpecified);
+			}
+		}
+
+		return errcnt == save_errcnt;
+	}
+
+	bool DfxParser::ProcessVelocityCurve(const std::string ctx, const curly_list_type* curve_map_ptr, VelocityCurve& curve)
+	{
+		int save_errcnt = errcnt;
+
+		// Gathers up the pieces of a velocity curve from the parse tree,
+		// and makes the curve if they're good.
+
+		std::string type;
+		token_ptr knee;
+		token_ptr range;
+
+		auto type_vp = GetPropertyValue(curve_map_ptr, "type");
+
+		if (type_vp)
+		{
+			auto svp = AsSimpleValue(type_vp);
+
+			if (svp && (svp->tkn->type == TokenEnum::QuotedChars || svp->tkn->type == TokenEnum::UnquotedChars))
+			{
+				type = svp->tkn->to_string();
 			}
+			else
+			{
+				LogError(ctx + "/type", DfxResult::VelocityCurveTypeInvalid);
+				return false;
+			}
+		}
+
+		auto knee_vp = GetPropertyValue(curve_map_ptr, "knee");
+
+		if (knee_vp)
+		{
+			knee = ProcessAsNumber(ctx + "/knee", knee_vp, DfxResult::VelocityCurveParamMustBeNumber);
+			if (!knee) return false;
+		}
+
+		auto range_vp = GetPropertyValue(curve_map_ptr, "range");
+
+		if (range_vp)
+		{
+			range = ProcessAsNumber(ctx + "/range", range_vp, DfxResult::VelocityCurveParamMustBeNumber);
+			if (!range) return false;
+		}
+
+		auto result = MakeVelocityCurve(type, knee, range, curve);
+
+		if (result != DfxResult::NoError)
+		{
+			LogError(ctx, result);
 		}
 
 		return errcnt == save_errcnt;
 	}
 
-	token_ptr DfxParser::ProcessAsNumber(const std::string ctx, std::shared_ptr<Value> &vp)
+	DfxResult DfxParser::MakeVelocityCurve(const std::string& type, const token_ptr& knee, const token_ptr& range, VelocityCurve& curve)
 	{
+		// Checks the pieces of a velocity curve, and if they're good, makes
+		// the curve. The knee and range tokens are null if not given.
+		// Shared by the tree and event loaders, so they agree.
+
+		if (type.empty())
+		{
+			return DfxResult::MustBeSpecified;
+		}
+
+		if (type == "linear")
+		{
+			curve.Generate(VelocityCurveType::Linear, 0.0);
+		}
+		else if (type == "knee")
+		{
+			if (!knee)
+			{
+				return DfxResult::MustBeSpecified;
+			}
+
+			auto nt = std::dynamic_pointer_cast<NumberToken>(knee);
+
+			if (nt->units != UnitEnum::None || nt->X() <= 0.0 || nt->X() >= 1.0)
+			{
+				return DfxResult::KneeOutOfRange;
+			}
+
+			curve.Generate(VelocityCurveType::Knee, nt->X());
+		}
+		else if (type == "dynrange")
+		{
+			if (!range)
+			{
+				return DfxResult::MustBeSpecified;
+			}
+
+			// The range is in dB, whether or not it says so
+
+			auto nt = std::dynamic_pointer_cast<NumberToken>(range);
+
+			if ((nt->units != UnitEnum::None && nt->units != UnitEnum::DB) || nt->RawX() <= 0.0)
+			{
+				return DfxResult::DynRangeOutOfRange;
+			}
+
+			curve.Generate(VelocityCurveType::DynRange, nt->RawX());
+		}
+		else
+		{
+			return DfxResult::VelocityCurveTypeInvalid;
+		}
+
+		return DfxResult::NoError;
+	}
+
+	bool DfxParser::VerifyLeveling(const std::string ctx, const curly_list_type* parent_map, bool must_be_specified)
+	{
+		int save_errcnt = errcnt;
+
+		// Check for a possibly optional leveling of the kit's robins.
+		// It's a {}-list, such as { by = rms, target = -18dB }.
+
+		auto new_ctx = ctx + '/' + "leveling";
+
+		auto vp = GetPropertyValue(parent_map, "leveling");
+
+		if (vp)
+		{
+			auto level_map_ptr = AsCurlyList(vp);
+
+			if (level_map_ptr)
+			{
+				LevelBy by;
+				double target;
+				ProcessLeveling(new_ctx, level_map_ptr, by, target);
+			}
+			else
+			{
+				LogError(new_ctx, DfxResult::LevelingMustBeList);
+			}
+		}
+		else
+		{
+			if (must_be_specified)
+			{
+				LogError(new_ctx, DfxResult::MustBeSpecified);
+			}
+		}
+
+		return errcnt == save_errcnt;
+	}
+
+	bool DfxParser::ProcessLeveling(const std::string ctx, const curly_list_type* level_map_ptr, LevelBy& by, double& target)
+	{
+		int save_errcnt = errcnt;
+
+		std::string by_name;
+		token_ptr target_tkn;
+
+		auto by_vp = GetPropertyValue(level_map_ptr, "by");
+
+		if (by_vp)
+		{
+			auto svp = AsSimpleValue(by_vp);
+
+			if (svp && (svp->tkn->type == TokenEnum::QuotedChars || svp->tkn->type == TokenEnum::UnquotedChars))
+			{
+				by_name = svp->tkn->to_string();
+			}
+			else
+			{
+				LogError(ctx + "/by", DfxResult::LevelByInvalid);
+				return false;
+			}
+		}
+
+		auto target_vp = GetPropertyValue(level_map_ptr, "target");
+
+		if (target_vp)
+		{
+			target_tkn = ProcessAsNumber(ctx + "/target", target_vp, DfxResult::LevelTargetMustBeNumber);
+			if (!target_tkn) return false;
+		}
+
+		auto result = MakeLeveling(by_name, target_tkn, by, target);
+
+		if (result != DfxResult::NoError)
+		{
+			LogError(ctx, result);
+		}
+
+		return errcnt == save_errcnt;
+	}
+
+	DfxResult DfxParser::MakeLeveling(const std::string& by_name, const token_ptr& target_tkn, LevelBy& by, double& target)
+	{
+		// Checks the pieces of a kit's leveling. The target is a level,
+		// like a robin's peak or rms, so it follows the same rules.
+		// Shared by the tree and event loaders.
+
+		if (by_name.empty() || !target_tkn)
+		{
+			return DfxResult::MustBeSpecified;
+		}
+
+		if (by_name == "peak")
+		{
+			by = LevelBy::Peak;
+		}
+		else if (by_name == "rms")
+		{
+			by = LevelBy::Rms;
+		}
+		else
+		{
+			return DfxResult::LevelByInvalid;
+		}
+
+		auto result = CheckWaveMagnitude(target_tkn);
+
+		if (result != DfxResult::NoError)
+		{
+			return result;
+		}
+
+		target = std::dynamic_pointer_cast<NumberToken>(target_tkn)->X();
+
+		if (target <= 0.0)
+		{
+			return DfxResult::ValueNotLegal;
+		}
+
+		return DfxResult::NoError;
+	}
+
+	bool DfxParser::VerifyRobinChoice(const std::string ctx, const curly_list_type* parent_map, bool must_be_specified)
+	{
+		int save_errcnt = errcnt;
+
+		// Check for a possibly optional way of choosing the kit's
+		// robins. It's a {}-list, such as { by = jittered, jitter = 0.05 }.
+
+		auto new_ctx = ctx + '/' + "robin_choice";
+
+		auto vp = GetPropertyValue(parent_map, "robin_choice");
+
+		if (vp)
+		{
+			auto choice_map_ptr = AsCurlyList(vp);
+
+			if (choice_map_ptr)
+			{
+				RobinStrategy strategy;
+				double jitter;
+				ProcessRobinChoice(new_ctx, choice_map_ptr, strategy, jitter);
+			}
+			else
+			{
+				LogError(new_ctx, DfxResult::RobinChoiceMustBeList);
+			}
+		}
+		else
+		{
+			if (must_be_specified)
+			{
+				LogError(new_ctx, DfxResult::MustBeSpecified);
+			}
+		}
+
+		return errcnt == save_errcnt;
+	}
+
+	bool DfxParser::ProcessRobinChoice(const std::string ctx, const curly_list_type* choice_map_ptr, RobinStrategy& strategy, double& jitter)
+	{
+		int save_errcnt = errcnt;
+
+		std::string by_name;
+		token_ptr jitter_tkn;
+
+		auto by_vp = GetPropertyValue(choice_map_ptr, "by");
+
+		if (by_vp)
+		{
+			auto svp = AsSimpleValue(by_vp);
+
+			if (svp && (svp->tkn->type == TokenEnum::QuotedChars || svp->tkn->type == TokenEnum::UnquotedChars))
+			{
+				by_name = svp->tkn->to_string();
+			}
+			else
+			{
+				LogError(ctx + "/by", DfxResult::RobinChoiceByInvalid);
+				return false;
+			}
+		}
+
+		auto jitter_vp = GetPropertyValue(choice_map_ptr, "jitter");
+
+		if (jitter_vp)
+		{
+			jitter_tkn = ProcessAsNumber(ctx + "/jitter", jitter_vp, DfxResult::JitterMustBeNumber);
+			if (!jitter_tkn) return false;
+		}
+
+		auto result = MakeRobinChoice(by_name, jitter_tkn, strategy, jitter);
+
+		if (result != DfxResult::NoError)
+		{
+			LogError(ctx, result);
+		}
+
+		return errcnt == save_errcnt;
+	}
+
+	DfxResult DfxParser::MakeRobinChoice(const std::string& by_name, const token_ptr& jitter_tkn, RobinStrategy& strategy, double& jitter)
+	{
+		// Checks the pieces of a kit's robin choice. The jitter is how
+		// far (+/-, on a 0 - 1 scale) the velocity gets nudged, and is
+		// needed just when jittering. Shared by the tree and event loaders.
+
+		if (by_name.empty())
+		{
+			return DfxResult::MustBeSpecified;
+		}
+
+		if (by_name == "cycle")
+		{
+			strategy = RobinStrategy::Cycle;
+		}
+		else if (by_name == "random")
+		{
+			strategy = RobinStrategy::RandomNoRepeat;
+		}
+		else if (by_name == "weighted")
+		{
+			strategy = RobinStrategy::Weighted;
+		}
+		else if (by_name == "jittered")
+		{
+			strategy = RobinStrategy::VelocityJittered;
+		}
+		else
+		{
+			return DfxResult::RobinChoiceByInvalid;
+		}
+
+		jitter = 0.0;
+
+		if (strategy != RobinStrategy::VelocityJittered)
+		{
+			return DfxResult::NoError;
+		}
+
+		if (!jitter_tkn)
+		{
+			return DfxResult::MustBeSpecified;
+		}
+
+		jitter = std::dynamic_pointer_cast<NumberToken>(jitter_tkn)->X();
+
+		if (jitter <= 0.0 || jitter > 1.0)
+		{
+			return DfxResult::JitterOutOfRange;
+		}
+
+		return DfxResult::NoError;
+	}
+
+	token_ptr DfxParser::ProcessAsNumber(const std::string ctx, value_ptr vp, DfxResult err)
+	{
+		// Logs err if the value isn't a number, or a string that converts
+		// to one, and returns null.
+
 		auto svp = AsSimpleValue(vp);
 
 		if (svp)
@@ -1010,14 +1650,14 @@ namespace dfx
 					// t is actually an error token with further info
 					auto err_t = std::dynamic_pointer_cast<SimpleToken>(t);
 					auto& err_pkg = err_t->result_pkg;
-					LogError(ctx, DfxResult::RmsMustBeNumber, err_pkg);
+					LogError(ctx, err, err_pkg);
 					return nullptr;
 				}
 			}
 		}
 		else
 		{
-			LogError(ctx, DfxResult::RmsMustBeNumber);
+			LogError(ctx, err);
 			return nullptr;
 		}
 
@@ -1026,6 +1666,20 @@ namespace dfx
 	}
 
 	bool DfxParser::VerifyWaveMagnitude(const std::string ctx, const token_ptr& tkn)
+	{
+		int save_errcnt = errcnt;
+
+		auto result = CheckWaveMagnitude(tkn);
+
+		if (result != DfxResult::NoError)
+		{
+			LogError(ctx, result);
+		}
+
+		return save_errcnt == errcnt;
+	}
+
+	DfxResult DfxParser::CheckWaveMagnitude(const token_ptr& tkn)
 	{
 		// Here, we know it's a number. But is it a properly formed number
 		// that would serve as a wave file's peak or rms value? In these
@@ -1036,50 +1690,57 @@ namespace dfx
 		// NOTE: When building kit for real, we anticipate using the EngrNum
 		// class, which preserves the mantissa for round tripping.
 
-		int save_errcnt = errcnt;
-
 		auto froglegs = std::dynamic_pointer_cast<NumberToken>(tkn);
 		auto& traits = froglegs->number_traits;
-		auto& engr_num = froglegs->engr_num;
 
 		if (traits.HasExponent() || traits.HasMetricPrefix())
 		{
-			LogError(ctx, DfxResult::ValueNotLegal);
+			return DfxResult::ValueNotLegal;
 		}
-		else
+
+		if (IsCat<UnitCatEnum::Ratio>(froglegs->units))
 		{
-			if (IsCat<UnitCatEnum::Ratio>(engr_num.units))
-			{
-				// Okay, we have ratio units. There are some constraints
-				// we put on the number, specifically, it must not be 
-				// negative or greater than 1.0
+			// Okay, we have ratio units. There are some constraints
+			// we put on the number, specifically, it must not be 
+			// negative or greater than 1.0
 
-				auto num = engr_num.X(); // First, get the value, apply any scale too
+			auto num = froglegs->X(); // First, get the value, apply any scale too
 
-				if (num < 0.0 || num > 1.0)
-				{
-					LogError(ctx, DfxResult::ValueNotLegal);
-				}
-			}
-			else if (engr_num.units == UnitEnum::None)
+			if (num < 0.0 || num > 1.0)
 			{
-				// No units given, so the number must not be negative
-				// and must be <= 1.0;
+				return DfxResult::ValueNotLegal;
+			}
+		}
+		else if (froglegs->units == UnitEnum::None)
+		{
+			// No units given, so the number must not be negative
+			// and must be <= 1.0;
 
-				auto num = engr_num.RawX();
+			auto num = froglegs->RawX();
 
-				if (num < 0.0 || num > 1.0)
-				{
-					LogError(ctx, DfxResult::ValueNotLegal);
-				}
-			}
-			else
+			if (num < 0.0 || num > 1.0)
 			{
-				LogError(ctx, DfxResult::ValueHasWrongUnits);
+				return DfxResult::ValueNotLegal;
 			}
 		}
+		else
+		{
+			return DfxResult::ValueHasWrongUnits;
+		}
 
-		return save_errcnt == errcnt;
+		return DfxResult::NoError;
+	}
+
+	DfxResult DfxParser::MakeWaveMagnitude(const token_ptr& tkn, double& mag)
+	{
+		auto result = CheckWaveMagnitude(tkn);
+
+		if (result == DfxResult::NoError)
+		{
+			mag = std::dynamic_pointer_cast<NumberToken>(tkn)->X();
+		}
+
+		return result;
 	}
 
 	/////////////////////////////////////////////////////////////////////
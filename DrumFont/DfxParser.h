@@ -37,6 +37,8 @@
 //#include <fstream>
 #include <filesystem>
 #include "BryxParser.h"
+#include "VelocityCurves.h"
+#include "DrumKit.h"
 
 namespace dfx
 {
@@ -53,6 +55,9 @@ namespace dfx
 		MustBeString,
 		NoteMissing,
 		NoteMustBeWholeNumber,
+		PanMustBeNumber,
+		PanOutOfRange,            // Must be -1 (hard left) to 1 (hard right)
+		BusMustBeWholeNumber,     // And not negative
 		KitsMissing,
 		KitValWrongType,
 		InstrumentIncludeDataMissing,
@@ -73,6 +78,20 @@ namespace dfx
 		PeakMissing, // We put this here in case we decide it's not optional
 		RmsMustBeNumber,
 		RmsMissing, // We put this here in case we decide it's not optional
+		WeightMustBeNumber,
+		WeightMustNotBeNegative,
+		VelocityCurveMustBeList,
+		VelocityCurveTypeInvalid, // Must be linear, knee, or dynrange
+		VelocityCurveParamMustBeNumber,
+		KneeOutOfRange,           // Must be 0 < knee < 1
+		DynRangeOutOfRange,       // Must be more than 0 dB
+		LevelingMustBeList,
+		LevelByInvalid,           // Must be peak or rms
+		LevelTargetMustBeNumber,
+		RobinChoiceMustBeList,
+		RobinChoiceByInvalid,     // Must be cycle, random, weighted or jittered
+		JitterMustBeNumber,
+		JitterOutOfRange,         // Must be 0 < jitter <= 1
 		ValueHasWrongUnits,
 		ValueNotLegal,
 		VerifyFailed,
@@ -160,19 +179,39 @@ namespace dfx
 		bool VerifyInstruments(const std::string ctx, const curly_list_type* instrument_map_ptr);
 		bool VerifyInstrument(const std::string ctx, const nv_type& drum_nv);
 		bool VerifyNote(const std::string ctx, const curly_list_type* parent_map, bool note_must_be_specified);
+		static DfxResult MakeNote(const token_ptr& tkn, int& note);
+		bool VerifyPan(const std::string ctx, const curly_list_type* parent_map, bool pan_must_be_specified);
+		static DfxResult MakePan(const token_ptr& tkn, double& pan);
+		bool VerifyBus(const std::string ctx, const curly_list_type* parent_map, bool bus_must_be_specified);
+		static DfxResult MakeBus(const token_ptr& tkn, int& bus);
 		bool VerifyVelocityLayers(const std::string ctx, const curly_list_type* parent_map);
-		bool VerifyVelocityLayer(const std::string ctx, std::shared_ptr<Value>& vlayer_sh_ptr);
+		bool VerifyVelocityLayer(const std::string ctx, value_ptr vlayer_sh_ptr);
+		static DfxResult MakeVelocityCode(const std::string& code, int& vel_code, bool& is_robin);
 		bool VerifyRobins(const std::string ctx, const curly_list_type* parent_map_ptr);
-		bool VerifyRobin(const std::string ctx, std::shared_ptr<NameValue>& robin_nv_ptr);
+		bool VerifyRobin(const std::string ctx, NameValue* robin_nv_ptr);
 		bool VerifyRobinBody(const std::string ctx, const curly_list_type* robin_body_map_ptr);
 		bool VerifyFname(const std::string ctx, const curly_list_type* parent_map, bool must_be_specified);
-		bool VerifyFname(const std::string ctx, std::shared_ptr<Value>& vp);
+		bool VerifyFname(const std::string ctx, value_ptr vp);
 		bool VerifyStart(const std::string ctx, const curly_list_type* parent_map, bool start_must_be_specified);
 		bool VerifyEnd(const std::string ctx, const curly_list_type* parent_map, bool end_must_be_specified);
+		static DfxResult MakeBound(const token_ptr& tkn, unsigned& frame);
 		bool VerifyPeak(const std::string ctx, const curly_list_type* parent_map, bool peak_must_be_specified);
 		bool VerifyRMS(const std::string ctx, const curly_list_type* parent_map, bool rms_must_be_specified);
+		bool VerifyWeight(const std::string ctx, const curly_list_type* parent_map, bool weight_must_be_specified);
+		static DfxResult MakeWeight(const token_ptr& tkn, double& weight);
+		bool VerifyVelocityCurve(const std::string ctx, const curly_list_type* parent_map, bool curve_must_be_specified);
+		bool ProcessVelocityCurve(const std::string ctx, const curly_list_type* curve_map_ptr, VelocityCurve& curve);
+		static DfxResult MakeVelocityCurve(const std::string& type, const token_ptr& knee, const token_ptr& range, VelocityCurve& curve);
+		bool VerifyLeveling(const std::string ctx, const curly_list_type* parent_map, bool leveling_must_be_specified);
+		bool ProcessLeveling(const std::string ctx, const curly_list_type* level_map_ptr, LevelBy& by, double& target);
+		static DfxResult MakeLeveling(const std::string& by_name, const token_ptr& target_tkn, LevelBy& by, double& target);
+		bool VerifyRobinChoice(const std::string ctx, const curly_list_type* parent_map, bool choice_must_be_specified);
+		bool ProcessRobinChoice(const std::string ctx, const curly_list_type* choice_map_ptr, RobinStrategy& strategy, double& jitter);
+		static DfxResult MakeRobinChoice(const std::string& by_name, const token_ptr& jitter_tkn, RobinStrategy& strategy, double& jitter);
 		bool VerifyWaveMagnitude(const std::string ctx, const token_ptr& tkn);
-		token_ptr ProcessAsNumber(const std::string ctx, std::shared_ptr<Value>& svp);
+		static DfxResult CheckWaveMagnitude(const token_ptr& tkn);
+		static DfxResult MakeWaveMagnitude(const token_ptr& tkn, double& mag);
+		token_ptr ProcessAsNumber(const std::string ctx, value_ptr svp, DfxResult err);
 
 	public:
 
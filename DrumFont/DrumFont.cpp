@@ -1,4 +1,8 @@
 #include "DrumFont.h"
+#include "CompiledFont.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 /******************************************************************************\
  * DFX - "Drum font exchange format" - source code
@@ -40,19 +44,72 @@ namespace dfx
 
 	DrumFont::DrumFont()
 	: drumKits{}
+	, sourceFiles{}
+	, pendingIncludes{}
+	, maxIncludeThreads(0)
 	{
 	}
 
+	DfxResult DrumFont::LoadCompiled(std::ostream& sout, std::string_view &fname, double tail_floor_db)
+	{
+		// Loads the kits, waves and all, from the compiled version of the
+		// font (.dfxc) if there is one and it's up to date. Otherwise, we
+		// load the font the long way, and then write out the compiled
+		// version for next time.
+
+		auto dfxc_path = CompiledFont::CompiledPath(fname);
+
+		if (CompiledFont::Load(sout, dfxc_path, drumKits, tail_floor_db))
+		{
+			sound_font_path = std::filesystem::path(fname).generic_string();
+			return DfxResult::NoError;
+		}
+
+		drumKits.clear();
+
+		auto rv = LoadFile(sout, fname);
+
+		if (rv != DfxResult::NoError)
+		{
+			return rv;
+		}
+
+		int wave_errcnt = 0;
+
+		for (auto& kit : drumKits)
+		{
+			wave_errcnt += kit->LoadWaves(sout, tail_floor_db);
+		}
+
+		if (wave_errcnt > 0)
+		{
+			sout << wave_errcnt << " Errors encountered loading the wave files" << std::endl;
+			return DfxResult::FileOpenError;
+		}
+
+		if (!CompiledFont::Save(sout, dfxc_path, drumKits, sourceFiles, tail_floor_db))
+		{
+			// Not fatal. We just won't start up faster next time.
+			sout << "Warning: couldn't write compiled font file " << dfxc_path << std::endl;
+		}
+
+		return DfxResult::NoError;
+	}
+
 	DfxResult DrumFont::LoadFile(std::ostream& sout, std::string_view &fname)
 	{
 		auto rv = DfxResult::NoError;
 
 		StartLog(sout);
 
+		sourceFiles.clear();
+
 		auto rvp = DfxParser::LoadFile(sout, fname);
 
 		if (rvp == ParserResult::NoError)
 		{
+			sourceFiles.push_back(sound_font_path);
+
 			auto zebra = Verify();
 			if (!zebra)
 			{
@@ -97,6 +154,74 @@ namespace dfx
 		return rv;
 	}
 
+	DfxResult DrumFont::LoadStreamed(std::ostream& sout, std::string_view &fname)
+	{
+		// Like LoadFile(), but builds the kits in one pass as the file is
+		// parsed, with no parse tree and no separate verify pass. Include
+		// files get the same treatment. Good for big fonts. What you don't
+		// get is the parse tree, so WriteDfx() and friends are out.
+
+		auto rv = DfxResult::NoError;
+
+		StartLog(sout);
+
+		sourceFiles.clear();
+
+		EventParser ep;
+		DfxEventBuilder builder(sout, false, "");
+
+		auto rvp = ep.LoadFile(fname, builder);
+
+		if (rvp == ParserResult::NoError)
+		{
+			sound_font_path = fname;
+			sound_font_path = sound_font_path.generic_string();
+			sourceFiles.push_back(sound_font_path);
+
+			if (builder.errcnt > 0)
+			{
+				errcnt += builder.errcnt;
+				rv = DfxResult::VerifyFailed;
+			}
+			else
+			{
+				BuildFont(builder.kits);
+			}
+		}
+		else
+		{
+			sout << "Parsing drum font file failed:" << std::endl;
+			if (rvp == ParserResult::FileOpenError)
+			{
+				sout << "failed to open file: " << fname << std::endl;
+			}
+			else if (rvp == ParserResult::CannotDetermineSyntaxMode)
+			{
+				sout << "cannot determine syntax mode: " << fname << std::endl;
+			}
+			else
+			{
+				ep.PrintError(sout, fname);
+			}
+
+			rv = DfxResult::UnspecifiedError;
+		}
+
+		EndLog();
+
+		if (rv == DfxResult::NoError)
+		{
+			// But we might have had problems with the include files
+			if (errcnt > 0)
+			{
+				sout << errcnt << " Errors encountered building the font" << std::endl;
+				rv = DfxResult::UnspecifiedError;
+			}
+		}
+
+		return rv;
+	}
+
 	void DrumFont::BuildFont()
 	{
 		auto base_path = sound_font_path;
@@ -106,16 +231,208 @@ namespace dfx
 
 		const kits_map* kits = GetKitsMapPtr();
 
+		// Instruments with include files are left as empty slots in
+		// their kits until all the includes have been loaded.
+
+		size_t first_new_kit = drumKits.size();
+
 		for (auto nvkit : *kits)
 		{
 			auto kit_ptr = BuildKit(base_path, nvkit);
+			drumKits.push_back(kit_ptr);
+		}
+
+		LoadPendingIncludes();
+		FinishKits(first_new_kit);
+	}
+
+	void DrumFont::BuildFont(std::vector<KitSpec>& kits)
+	{
+		// Same as above, but from what the event builder made. Like the
+		// parse tree does, we keep the kits and instruments sorted by
+		// name, so both ways build the same font.
+
+		auto base_path = sound_font_path;
+		base_path.remove_filename();
+
+		auto by_name = [](const auto& a, const auto& b) { return a.name < b.name; };
+
+		std::stable_sort(kits.begin(), kits.end(), by_name);
+
+		size_t first_new_kit = drumKits.size();
+
+		for (auto& kit_spec : kits)
+		{
+			auto kit = std::make_shared<DrumKit>(kit_spec.name, base_path, kit_spec.includeBasePath, kit_spec.path);
+			kit->velCurve = kit_spec.velCurve;
+			kit->levelBy = kit_spec.levelBy;
+			kit->levelTarget = kit_spec.levelTarget;
+			kit->robinStrategy = kit_spec.robinStrategy;
+			kit->velocityJitter = kit_spec.velocityJitter;
+
+			std::stable_sort(kit_spec.drums.begin(), kit_spec.drums.end(), by_name);
+			kit->drums.reserve(kit_spec.drums.size());
+
+			for (auto& spec : kit_spec.drums)
+			{
+				if (spec.include.empty())
+				{
+					auto drum = std::make_shared<MultiLayeredDrum>(spec.name, kit->cumulativePath, spec.path, spec.midiNote);
+					drum->pan = spec.pan;
+					drum->bus = spec.bus;
+					drum->velCurve = spec.velCurve;
+					drum->velocityLayers = std::move(spec.velocityLayers);
+					kit->drums.push_back(std::move(drum));
+				}
+				else
+				{
+					auto dpath = spec.path;
+
+					auto job = std::make_unique<PendingInclude>();
+					job->fullPath = IncludeFilePath(*kit, spec.include, dpath);
+					job->kit = kit;
+					job->drumSlot = kit->drums.size();
+					job->drumName = spec.name;
+					job->drumPath = dpath;
+					job->midiNote = spec.midiNote;
+					job->pan = spec.pan;
+					job->bus = spec.bus;
+					job->velCurve = spec.velCurve;
+					job->streamed = true;
+					pendingIncludes.push_back(std::move(job));
+
+					kit->drums.push_back(nullptr);
+				}
+			}
+
+			drumKits.push_back(kit);
+		}
+
+		LoadPendingIncludes();
+		FinishKits(first_new_kit);
+	}
+
+	void DrumFont::FinishKits(size_t first_new_kit)
+	{
+		for (size_t i = first_new_kit; i < drumKits.size(); i++)
+		{
+			auto& kit_ptr = drumKits[i];
+			auto& drums = kit_ptr->drums;
+			drums.erase(std::remove(drums.begin(), drums.end(), nullptr), drums.end()); // the ones that failed
 			kit_ptr->FinishPaths(sound_font_path);
+			kit_ptr->FinishCurves();
+			kit_ptr->FinishLevels();
+			kit_ptr->FinishRobins();
 			kit_ptr->BuildNoteMap();
-			drumKits.push_back(kit_ptr);
-			int i = 42;
 		}
 	}
 
+	void DrumFont::LoadPendingIncludes()
+	{
+		// The include files are independent of each other, so each
+		// one is parsed and verified by its own DfxParser, on however
+		// many threads we're allowed. The main thread pitches in too.
+
+		size_t njobs = pendingIncludes.size();
+		if (njobs == 0) return;
+
+		size_t nthreads = maxIncludeThreads ? maxIncludeThreads : std::thread::hardware_concurrency();
+		if (nthreads == 0) nthreads = 1;
+		if (nthreads > njobs) nthreads = njobs;
+
+		std::atomic<size_t> next_job{ 0 };
+
+		auto worker = [this, &next_job, njobs]()
+		{
+			for (size_t i = next_job++; i < njobs; i = next_job++)
+			{
+				auto& job = *pendingIncludes[i];
+				auto psview = std::string_view(job.fullPath);
+
+				if (job.streamed)
+				{
+					static constexpr bool as_include = true;
+					EventParser ep;
+					DfxEventBuilder builder(job.log, as_include, job.fullPath);
+
+					auto rvp = ep.LoadFile(psview, builder);
+
+					if (rvp != ParserResult::NoError)
+					{
+						job.log << "Parsing error encountered:\n";
+						ep.PrintError(job.log, psview);
+						builder.LogError("opening file", DfxResult::ParsingError);
+					}
+
+					job.result = builder.errcnt == 0 ? DfxResult::NoError : DfxResult::VerifyFailed;
+					job.errcnt = builder.errcnt;
+					job.velocityLayers = std::move(builder.drum.velocityLayers);
+				}
+				else
+				{
+					static constexpr bool as_include = true;
+					job.parser = std::make_unique<DfxParser>();
+					job.result = job.parser->LoadAndVerify(job.log, psview, as_include);
+					job.errcnt = job.parser->errcnt;
+				}
+			}
+		};
+
+		std::vector<std::thread> helpers;
+		helpers.reserve(nthreads - 1);
+
+		for (size_t t = 1; t < nthreads; t++)
+		{
+			helpers.emplace_back(worker);
+		}
+
+		worker();
+
+		for (auto& h : helpers)
+		{
+			h.join();
+		}
+
+		// Now merge the results back in, in the same order a serial
+		// load would have produced them.
+
+		for (auto& jp : pendingIncludes)
+		{
+			auto& job = *jp;
+
+			*slog << job.log.str();
+			sourceFiles.push_back(job.fullPath);
+
+			if (job.result != DfxResult::NoError)
+			{
+				// add errcnt from included parsing to main count
+				errcnt += job.errcnt;
+			}
+			else if (job.streamed)
+			{
+				auto drum = std::make_shared<MultiLayeredDrum>(job.drumName, job.kit->cumulativePath, job.drumPath, job.midiNote);
+				drum->velocityLayers = std::move(job.velocityLayers);
+				drum->pan = job.pan;
+				drum->bus = job.bus;
+				drum->velCurve = job.velCurve;
+				drum->includePath = job.fullPath;
+				job.kit->drums[job.drumSlot] = std::move(drum);
+			}
+			else
+			{
+				auto dmp = job.parser->GetInstrumentIncludeMapPtr();
+				auto drum = MakeInstrument(job.drumName, job.kit->cumulativePath, job.drumPath, job.midiNote, dmp);
+				drum->pan = job.pan;
+				drum->bus = job.bus;
+				drum->velCurve = job.velCurve;
+				drum->includePath = job.fullPath;
+				job.kit->drums[job.drumSlot] = std::move(drum);
+			}
+		}
+
+		pendingIncludes.clear();
+	}
+
 	void DrumFont::DumpRobins(std::ostream& sout)
 	{
 		for (auto& kit : drumKits)
@@ -157,6 +474,27 @@ namespace dfx
 
 		auto dk = std::make_shared<DrumKit>(kit_name, base_path, *include_base_path_opt, *kit_path_opt);
 
+		auto curve_vp = GetPropertyValue(kitmap_ptr, "velocity_curve");
+
+		if (curve_vp)
+		{
+			ProcessVelocityCurve(kit_name, AsCurlyList(curve_vp), dk->velCurve);
+		}
+
+		auto level_vp = GetPropertyValue(kitmap_ptr, "leveling");
+
+		if (level_vp)
+		{
+			ProcessLeveling(kit_name, AsCurlyList(level_vp), dk->levelBy, dk->levelTarget);
+		}
+
+		auto choice_vp = GetPropertyValue(kitmap_ptr, "robin_choice");
+
+		if (choice_vp)
+		{
+			ProcessRobinChoice(kit_name, AsCurlyList(choice_vp), dk->robinStrategy, dk->velocityJitter);
+		}
+
 		auto instrument_map_ptr = GetInstrumentMapPtr(kitmap_ptr);
 
 		BuildInstruments(dk, instrument_map_ptr);
@@ -187,16 +525,45 @@ namespace dfx
 
 		auto nt = std::dynamic_pointer_cast<NumberToken>(svp->tkn);
 
-		int midi_note = static_cast<int>(nt->engr_num.X());
+		int midi_note = static_cast<int>(nt->X());
+
+		auto pan_vp = GetPropertyValue(drum_map_ptr, "pan");
+		double pan;
+
+		if (pan_vp)
+		{
+			auto t = ProcessAsNumber("BuildInstrument", pan_vp, DfxResult::PanMustBeNumber);
+			auto pt = std::dynamic_pointer_cast<NumberToken>(t);
+			pan = pt->X();
+		}
+		else
+		{
+			// Use default
+			pan = 0.0;
+		}
+
+		auto bus_vp = GetPropertyValue(drum_map_ptr, "bus");
+		int bus = 0;
+
+		if (bus_vp)
+		{
+			auto bt = std::dynamic_pointer_cast<NumberToken>(AsSimpleValue(bus_vp)->tkn);
+			bus = static_cast<int>(bt->X());
+		}
+
+		auto curve_vp = GetPropertyValue(drum_map_ptr, "velocity_curve");
+		VelocityCurve vel_curve;
+
+		if (curve_vp)
+		{
+			ProcessVelocityCurve(drum_name, AsCurlyList(curve_vp), vel_curve);
+		}
 
 		// Update the cumulative path to include this drum's directory
 
 		auto drum_path_opt = GetSimpleProperty(drum_map_ptr, "path");  // @@ TODO: Someday simplify this stuff
 		std::string dpath = drum_path_opt ? *drum_path_opt : "";
 
-		std::filesystem::path cumulativePath = kit->cumulativePath;
-		cumulativePath /= dpath;
-
 		// See if the drum velocity layers are in an include file instead
 		// of being immediate.
 
@@ -217,115 +584,127 @@ namespace dfx
 			// make them relative to the sound font path.
 
 			auto valptr = AsSimpleValue(ip);
-			auto rel_include_path = valptr->tkn->to_string();
+			auto full_path_to_include_file = IncludeFilePath(*kit, valptr->tkn->to_string(), dpath);
+
+			// The include gets loaded later, along with all the
+			// others (see LoadPendingIncludes). Hold its place.
+
+			auto job = std::make_unique<PendingInclude>();
+			job->kit = kit;
+			job->drumSlot = kit->drums.size();
+			job->drumName = drum_name;
+			job->drumPath = dpath;
+			job->midiNote = midi_note;
+			job->pan = pan;
+			job->bus = bus;
+			job->velCurve = vel_curve;
+			job->fullPath = full_path_to_include_file;
+			pendingIncludes.push_back(std::move(job));
+
+			kit->drums.push_back(nullptr);
+		}
+		else
+		{
+			// Velocity layer stuff is embedded in main file. So easy peasy.
+			auto drum = MakeInstrument(drum_name, kit->cumulativePath, dpath, midi_note, drum_map_ptr);
+			drum->pan = pan;
+			drum->bus = bus;
+			drum->velCurve = vel_curve;
+			kit->drums.push_back(std::move(drum));
+		}
+	}
+
+	std::string DrumFont::IncludeFilePath(const DrumKit& kit, std::string rel_include_path, std::string& dpath) const
+	{
+		// Works out where an instrument's include file is. Might fix
+		// up the instrument's path (dpath) along the way.
 
-			std::filesystem::path full_path_to_include_file;
+		std::filesystem::path cumulativePath = kit.cumulativePath;
+		cumulativePath /= dpath;
+
+		std::filesystem::path full_path_to_include_file;
+
+		if (rel_include_path.find("$fontbase/") == 0)
+		{
+			// local override of include base path
+			full_path_to_include_file = sound_font_path;
+			full_path_to_include_file.remove_filename();
+			full_path_to_include_file /= rel_include_path.erase(0, 10); // minus the "$fontbase/"
+		}
+		else if (!kit.includeBasePath.empty())
+		{
+			// We have a file-wide include file base path specified.
+			// See if its one of our path vars. (Right now, that's only
+			// "$fontbase"
 
-			if (rel_include_path.find("$fontbase/") == 0)
+			if (kit.includeBasePath == "$fontbase")
 			{
-				// local override of include base path
+				// So we should use the sound font path as the
+				// include path for this instrument file
+
 				full_path_to_include_file = sound_font_path;
 				full_path_to_include_file.remove_filename();
-				full_path_to_include_file /= rel_include_path.erase(0, 10); // minus the "$fontbase/"
-			}
-			else if (!kit->includeBasePath.empty())
-			{
-				// We have a file-wide include file base path specified.
-				// See if its one of our path vars. (Right now, that's only
-				// "$fontbase"
-
-				if (kit->includeBasePath == "$fontbase")
-				{
-					// So we should use the sound font path as the
-					// include path for this instrument file
-
-					full_path_to_include_file = sound_font_path;
-					full_path_to_include_file.remove_filename();
-					full_path_to_include_file /= rel_include_path;
-				}
-				else
-				{
-					// So we presume here that the include path is
-					// relative to the cumulative path so far (or its
-					// a complete path specification.) Both are covered
-					// by the /= operator, I believe
-
-					full_path_to_include_file = cumulativePath; // NOT kit->cumulativePath;
-					full_path_to_include_file /= kit->includeBasePath;
-					full_path_to_include_file /= rel_include_path;
-				}
+				full_path_to_include_file /= rel_include_path;
 			}
 			else
 			{
-				// If there is no includeBasePath specified, then the
-				// the include path defaults to the current cumulative path,
-				// which is the path to the drum instrument's directory.
-				// When then add the rel_path as specified by the include
-				// directive.
-
-				// @@ TOOD: BUG. At the moment, you MUST specify the path for the drum
-				// if the include file is not in the same directory as the sound fount.
+				// So we presume here that the include path is
+				// relative to the cumulative path so far (or its
+				// a complete path specification.) Both are covered
+				// by the /= operator, I believe
 
-				// For example, the following works:
-
-				//conga_11A =
-				//{
-				//	note = 96,
-				//  path = "Conga_11_ARobins";
-				//	include = "Conga_11_A.dfxi"
-				//},
+				full_path_to_include_file = cumulativePath; // NOT kit.cumulativePath;
+				full_path_to_include_file /= kit.includeBasePath;
+				full_path_to_include_file /= rel_include_path;
+			}
+		}
+		else
+		{
+			// If there is no includeBasePath specified, then the
+			// the include path defaults to the current cumulative path,
+			// which is the path to the drum instrument's directory.
+			// When then add the rel_path as specified by the include
+			// directive.
 
-				// But not the following:
+			// @@ TOOD: BUG. At the moment, you MUST specify the path for the drum
+			// if the include file is not in the same directory as the sound fount.
 
-				//conga_11A =
-				//{
-				//	note = 96,
-				//	include = "Conga_11_ARobins/Conga_11_A.dfxi"
-				//},
+			// For example, the following works:
 
-				// In the latter, cumulativePath below is right, but
-				// kit->cumulative_path + dpath as used in the make_instrument]
-				// call below does not mention Conga_11_ARobins anywhere.
+			//conga_11A =
+			//{
+			//	note = 96,
+			//  path = "Conga_11_ARobins";
+			//	include = "Conga_11_A.dfxi"
+			//},
 
-				full_path_to_include_file = cumulativePath; // NO!: kit->cumulativePath;
-				full_path_to_include_file /= rel_include_path;
+			// But not the following:
 
-				// @@ TODO: Perhaps: fix dpath so that it has all of the directories in
-				// rel_include_path. It would be empty below otherise and thus wrong
-				// here.
+			//conga_11A =
+			//{
+			//	note = 96,
+			//	include = "Conga_11_ARobins/Conga_11_A.dfxi"
+			//},
 
-				std::filesystem::path rip = dpath;
-				rip /= rel_include_path;
-				rip.remove_filename();
+			// In the latter, cumulativePath below is right, but
+			// kit.cumulative_path + dpath as used in the make_instrument]
+			// call below does not mention Conga_11_ARobins anywhere.
 
-				dpath = rip.generic_string();
-			}
+			full_path_to_include_file = cumulativePath; // NO!: kit.cumulativePath;
+			full_path_to_include_file /= rel_include_path;
 
-			auto pstring = full_path_to_include_file.generic_string();
-			auto psview = std::string_view(pstring.c_str());
+			// @@ TODO: Perhaps: fix dpath so that it has all of the directories in
+			// rel_include_path. It would be empty below otherise and thus wrong
+			// here.
 
-			auto dp = std::make_unique<DfxParser>();
-			static constexpr bool as_include = true;
-			auto rv = dp->LoadAndVerify(*slog, psview, as_include);
+			std::filesystem::path rip = dpath;
+			rip /= rel_include_path;
+			rip.remove_filename();
 
-			if (rv == DfxResult::NoError)
-			{
-				auto dmp = dp->GetInstrumentIncludeMapPtr();
-				auto drum = MakeInstrument(drum_name, kit->cumulativePath, dpath, midi_note, dmp);
-				kit->drums.push_back(std::move(drum));
-			}
-			else
-			{
-				// add errcnt from included parsing to main count
-				errcnt += dp->errcnt;
-			}
-		}
-		else
-		{
-			// Velocity layer stuff is embedded in main file. So easy peasy.
-			auto drum = MakeInstrument(drum_name, kit->cumulativePath, dpath, midi_note, drum_map_ptr);
-			kit->drums.push_back(std::move(drum));
+			dpath = rip.generic_string();
 		}
+
+		return full_path_to_include_file.generic_string();
 	}
 
 	drum_ptr DrumFont::MakeInstrument(const std::string &drum_name, std::filesystem::path cumulativePath, std::filesystem::path drumPath, int midi_note, const curly_list_type *drum_map_ptr)
@@ -352,33 +731,19 @@ namespace dfx
 		return drum;
 	}
 
-	void DrumFont::BuildVelocityLayer(std::vector<VelocityLayer>& vlayers, std::shared_ptr<Value>& vlayer_sh_ptr)
+	void DrumFont::BuildVelocityLayer(std::vector<VelocityLayer>& vlayers, value_ptr vlayer_sh_ptr)
 	{
-		auto nvp = dynamic_cast<NameValue*>(vlayer_sh_ptr.get());
+		auto nvp = AsNameValue(vlayer_sh_ptr);
 
 		auto& vel_code_str = nvp->pair.first;
 		auto& vlayer_body = nvp->pair.second;
 
 		// vel_code starts with either a "v", or "vr"
 
-		int vel_code = 0;
-
-		bool simplified_robin = false;
-		const char* p = nullptr;
+		int vel_code;
+		bool simplified_robin;
 
-		if (vel_code_str.find("vr", 0) == 0)
-		{
-			simplified_robin = true;
-			vel_code = std::stoi(vel_code_str.substr(2));
-			p = vel_code_str.c_str();
-			p += 2; // past the vr
-		}
-		else if (vel_code_str.find("v", 0) == 0)
-		{
-			vel_code = std::stoi(vel_code_str.substr(1));
-			p = vel_code_str.c_str();
-			++p; // past the v
-		}
+		MakeVelocityCode(vel_code_str, vel_code, simplified_robin);
 
 		auto vlayer_body_map_ptr = AsCurlyList(vlayer_body);
 
@@ -391,7 +756,7 @@ namespace dfx
 			VelocityLayer vlayer("", vel_code);
 			vlayer.robinMgr.robins.reserve(1);
 
-			//auto robin_nv_ptr = dynamic_cast<NameValue*>(vlayer_sh_ptr.get());
+			//auto robin_nv_ptr = AsNameValue(vlayer_sh_ptr);
 			BuildRobin(vlayer.robinMgr.robins, nvp);
 
 			vlayers.emplace_back(std::move(vlayer));
@@ -418,7 +783,7 @@ namespace dfx
 
 			for (auto robin_sh_ptr : *robins_arr_ptr)
 			{
-				auto robin_nv_ptr = dynamic_cast<NameValue*>(robin_sh_ptr.get());
+				auto robin_nv_ptr = AsNameValue(robin_sh_ptr);
 				BuildRobin(vlayer.robinMgr.robins, robin_nv_ptr);
 			}
 
@@ -444,9 +809,9 @@ namespace dfx
 
 		if (start_vp)
 		{
-			auto t = ProcessAsNumber("BuildRobin", start_vp);
+			auto t = ProcessAsNumber("BuildRobin", start_vp, DfxResult::BoundMustBeWholeNumber);
 			auto nt = std::dynamic_pointer_cast<NumberToken>(t);
-			start = static_cast<int>(nt->engr_num.X());
+			start = static_cast<int>(nt->X());
 		}
 		else
 		{
@@ -460,9 +825,9 @@ namespace dfx
 
 		if (end_vp)
 		{
-			auto t = ProcessAsNumber("BuildRobin", end_vp);
+			auto t = ProcessAsNumber("BuildRobin", end_vp, DfxResult::BoundMustBeWholeNumber);
 			auto nt = std::dynamic_pointer_cast<NumberToken>(t);
-			end = static_cast<int>(nt->engr_num.X());
+			end = static_cast<int>(nt->X());
 		}
 		else
 		{
@@ -475,9 +840,9 @@ namespace dfx
 
 		if (peak_vp)
 		{
-			auto t = ProcessAsNumber("BuildRobin", peak_vp);
+			auto t = ProcessAsNumber("BuildRobin", peak_vp, DfxResult::PeakMustBeNumber);
 			auto nt = std::dynamic_pointer_cast<NumberToken>(t);
-			peak = nt->engr_num.X();
+			peak = nt->X();
 		}
 		else
 		{
@@ -490,9 +855,9 @@ namespace dfx
 
 		if (rms_vp)
 		{
-			auto t = ProcessAsNumber("BuildRobin", rms_vp);
+			auto t = ProcessAsNumber("BuildRobin", rms_vp, DfxResult::RmsMustBeNumber);
 			auto nt = std::dynamic_pointer_cast<NumberToken>(t);
-			rms = nt->engr_num.X();
+			rms = nt->X();
 		}
 		else
 		{
@@ -500,13 +865,29 @@ namespace dfx
 			rms = 1.0;
 		}
 
+		auto weight_vp = GetPropertyValue(robin_body_map_ptr, "weight");
+		double weight;
+
+		if (weight_vp)
+		{
+			auto t = ProcessAsNumber("BuildRobin", weight_vp, DfxResult::WeightMustBeNumber);
+			auto nt = std::dynamic_pointer_cast<NumberToken>(t);
+			weight = nt->X();
+		}
+		else
+		{
+			// Use default
+			weight = 1.0;
+		}
+
 		std::cout << "      robin " << '"' << *fname_opt << '"' << std::endl;
 		std::cout << "        start " << start << std::endl;
 		std::cout << "        end " << end << std::endl;
 		std::cout << "        peak " << peak << std::endl;
 		std::cout << "        rms " << rms << std::endl;
+		std::cout << "        weight " << weight << std::endl;
 
-		Robin robin(*fname_opt, peak, rms, start, end);
+		Robin robin(*fname_opt, peak, rms, start, end, weight);
 
 		robins.emplace_back(std::move(robin));
 	}
@@ -35,17 +35,50 @@
 \******************************************************************************/
 
 #include "DfxParser.h"
+#include "DfxEventBuilder.h"
 #include "DrumKit.h"
+#include <sstream>
 #include <string>
 
 namespace dfx
 {
 	using namespace bryx;
 
+	// An instrument whose velocity layers are in an include file. These get
+	// gathered up while building the kits, then parsed and verified on
+	// worker threads. Each job logs to its own stream, and the logs and
+	// instruments are merged back in the order the includes were found.
+	// Streamed includes (see LoadStreamed()) skip the parse tree, and
+	// hand back just the velocity layers.
+
+	struct PendingInclude {
+		std::shared_ptr<DrumKit> kit;
+		size_t drumSlot;                   // Where the instrument goes in kit->drums
+		std::string drumName;
+		std::filesystem::path drumPath;
+		int midiNote;
+		double pan;
+		int bus;
+		VelocityCurve velCurve;
+		std::string fullPath;
+		bool streamed;
+		std::unique_ptr<DfxParser> parser;
+		std::vector<VelocityLayer> velocityLayers; // When streamed
+		std::ostringstream log;
+		DfxResult result;
+		int errcnt;
+
+		PendingInclude() : kit(), drumSlot(0), drumName(), drumPath(), midiNote(0), pan(0.0), bus(0), velCurve(), fullPath(), streamed(false), parser(), velocityLayers(), log(), result(DfxResult::NoError), errcnt(0) { }
+	};
+
 	class DrumFont : public DfxParser {
 	public:
 
 		std::vector<std::shared_ptr<DrumKit>> drumKits;
+		std::vector<std::filesystem::path> sourceFiles; // The font file and all its includes
+
+		std::vector<std::unique_ptr<PendingInclude>> pendingIncludes;
+		unsigned maxIncludeThreads; // 0 means one per hardware thread
 
 		DrumFont();
 		virtual ~DrumFont() { }
@@ -53,6 +86,8 @@ namespace dfx
 	public:
 
 		DfxResult LoadFile(std::ostream& slog, std::string_view &fname);
+		DfxResult LoadStreamed(std::ostream& slog, std::string_view &fname);
+		DfxResult LoadCompiled(std::ostream& slog, std::string_view &fname, double tail_floor_db = DefaultTailFloor_dB);
 		void DumpRobins(std::ostream& sout); // For testing purposes
 
 
@@ -65,13 +100,17 @@ namespace dfx
 		// likely exceptions will be thrown.
 
 		void BuildFont();
+		void BuildFont(std::vector<KitSpec>& kits); // For LoadStreamed()
+		void FinishKits(size_t first_new_kit);
+		std::string IncludeFilePath(const DrumKit& kit, std::string rel_include_path, std::string& dpath) const;
 
 		std::shared_ptr<DrumKit> BuildKit(std::filesystem::path base_path, const nv_type& kit);
 		void BuildInstruments(std::shared_ptr<DrumKit>& kit, const curly_list_type* instrument_map_ptr);
 		//void BuildInstrument(std::vector<drum_ptr>& drums, std::filesystem::path cumulativePath, const nv_type& drum_nv);
 		void BuildInstrument(std::shared_ptr<DrumKit>& kit, const nv_type& drum_nv);
+		void LoadPendingIncludes();
 		drum_ptr MakeInstrument(const std::string &drum_name, std::filesystem::path cumulativePath, std::filesystem::path drumPath, int midiNote, const curly_list_type* drum_map_ptr);
-		void BuildVelocityLayer(std::vector<VelocityLayer>& layers, std::shared_ptr<Value>& layer_sh_ptr);
+		void BuildVelocityLayer(std::vector<VelocityLayer>& layers, value_ptr layer_sh_ptr);
 		void BuildRobin(std::vector<Robin>& robins, NameValue* robin_nv_ptr);
 	};
 
@@ -34,12 +34,18 @@
 
 #include <iostream>
 #include "DrumKit.h"
+#include "RealTime.h"
 
 namespace dfx
 {
 
 	DrumKit::DrumKit()
-	: noteMap{ 128 }
+	: levelBy(LevelBy::None)
+	, levelTarget(1.0)
+	, robinStrategy(RobinStrategy::Cycle)
+	, velocityJitter(0.0)
+	, rngSeed(XorShiftRng::DefaultSeed)
+	, noteMap{ 128 }
 	{
 		//std::cout << "DrumKit default ctor called" << std::endl;
 	}
@@ -50,6 +56,12 @@ namespace dfx
 	, includeBasePath(includeBasePath_)
 	, kitPath(kitPath_) // @@ TODO: May not be necessary to store this
 	, name(name_)
+	, velCurve()
+	, levelBy(LevelBy::None)
+	, levelTarget(1.0)
+	, robinStrategy(RobinStrategy::Cycle)
+	, velocityJitter(0.0)
+	, rngSeed(XorShiftRng::DefaultSeed)
 	, drums()
 	, noteMap{ 128 }
 	{
@@ -64,6 +76,12 @@ namespace dfx
 	, includeBasePath(other.includeBasePath)
 	, kitPath(other.kitPath)
 	, name(other.name)
+	, velCurve(other.velCurve)
+	, levelBy(other.levelBy)
+	, levelTarget(other.levelTarget)
+	, robinStrategy(other.robinStrategy)
+	, velocityJitter(other.velocityJitter)
+	, rngSeed(other.rngSeed)
 	, drums(other.drums)
 	, noteMap{ 128 }
 	{
@@ -76,6 +94,12 @@ namespace dfx
 	, includeBasePath(std::move(other.includeBasePath))
 	, kitPath(std::move(other.kitPath))
 	, name(std::move(other.name))
+	, velCurve(other.velCurve)
+	, levelBy(other.levelBy)
+	, levelTarget(other.levelTarget)
+	, robinStrategy(other.robinStrategy)
+	, velocityJitter(other.velocityJitter)
+	, rngSeed(other.rngSeed)
 	, drums(std::move(other.drums))
 	, noteMap(std::move(other.noteMap))
 	{
@@ -98,6 +122,12 @@ namespace dfx
 			includeBasePath = other.includeBasePath;
 			kitPath = other.kitPath;
 			name = other.name;
+			velCurve = other.velCurve;
+			levelBy = other.levelBy;
+			levelTarget = other.levelTarget;
+			robinStrategy = other.robinStrategy;
+			velocityJitter = other.velocityJitter;
+			rngSeed = other.rngSeed;
 			drums = other.drums;
 			noteMap = other.noteMap;
 		}
@@ -114,6 +144,12 @@ namespace dfx
 			includeBasePath = std::move(other.includeBasePath);
 			kitPath = std::move(other.kitPath);
 			name = std::move(other.name);
+			velCurve = other.velCurve;
+			levelBy = other.levelBy;
+			levelTarget = other.levelTarget;
+			robinStrategy = other.robinStrategy;
+			velocityJitter = other.velocityJitter;
+			rngSeed = other.rngSeed;
 			drums = std::move(other.drums);
 			noteMap = std::move(other.noteMap);
 		}
@@ -130,17 +166,97 @@ namespace dfx
 
 	void DrumKit::FinishPaths(std::filesystem::path& soundFontPath_)
 	{
-		// We sor the velocity layers of all the drums and then
+		// We sort the velocity layers of all the drums and then
 		// finish instantiating the paths of the individual 
 		// sound files.
 
 		for (auto& d : drums)
 		{
-			d->SortLayers();
+			d->FinishPaths();
+		}
+	}
+
+	void DrumKit::FinishCurves()
+	{
+		// Drums that didn't give their own velocity curve get the kit's
+
+		for (auto& d : drums)
+		{
+			if (!d->velCurve.IsSpecified())
+			{
+				d->velCurve = velCurve;
+			}
+		}
+	}
+
+	void DrumKit::FinishRobins()
+	{
+		// The drums choose their robins the way the kit says, each
+		// with its own freshly seeded random number generator.
+
+		SetRobinStrategy(robinStrategy, velocityJitter);
+		SeedRngs(rngSeed);
+	}
+
+	void DrumKit::FinishLevels()
+	{
+		// Works out a gain for each robin from the peak or rms numbers in
+		// the drum font. No samples are looked at. The robins of a layer
+		// are evened out to the layer's average, then the whole drum is
+		// scaled so its loudest layer comes out at the target. The softer
+		// layers keep their place below that, so the layers still step up
+		// in loudness the way they were recorded. A robin that doesn't
+		// give its peak or rms counts as full scale, that being the default.
+
+		for (auto& d : drums)
+		{
+			LevelDrum(*d);
+		}
+	}
+
+	void DrumKit::LevelDrum(MultiLayeredDrum& d) const
+	{
+		// See FinishLevels(). Just the one drum, as for one whose
+		// include file was reloaded.
+
+		double loudest = 0.0;
+
+		for (auto& layer : d.velocityLayers)
+		{
+			double sum = 0.0;
+			size_t n = 0;
+
+			for (auto& robin : layer.robinMgr.robins)
+			{
+				double m = levelBy == LevelBy::Peak ? robin.peak : robin.rms;
+
+				if (m > 0.0)
+				{
+					sum += m;
+					++n;
+				}
+			}
+
+			double avg = n > 0 ? sum / n : 0.0;
+			if (avg > loudest) loudest = avg;
+
+			for (auto& robin : layer.robinMgr.robins)
+			{
+				double m = levelBy == LevelBy::Peak ? robin.peak : robin.rms;
+				robin.gain = levelBy != LevelBy::None && m > 0.0 ? avg / m : 1.0;
+			}
+		}
+
+		if (levelBy != LevelBy::None && loudest > 0.0)
+		{
+			double drum_scale = levelTarget / loudest;
 
-			for (auto &layer : d->velocityLayers)
+			for (auto& layer : d.velocityLayers)
 			{
-				layer.FinishPaths(d->cumulativePath);
+				for (auto& robin : layer.robinMgr.robins)
+				{
+					robin.gain *= drum_scale;
+				}
 			}
 		}
 	}
@@ -164,15 +280,64 @@ namespace dfx
 		}
 	}
 
-	int DrumKit::LoadWaves(std::ostream &serr)
+	int DrumKit::LoadWaves(std::ostream &serr, double tail_floor_db)
 	{
 		int errcnt = 0;
 		for (auto& d : drums)
 		{
-			int local_errcnt = d->LoadWaves(serr);
+			int local_errcnt = d->LoadWaves(serr, tail_floor_db);
 			errcnt += local_errcnt;
 		}
 		return errcnt;
 	}
 
+	size_t DrumKit::PrefaultWaves(bool lock)
+	{
+		// Touches (and maybe locks) every page of the loaded samples, so
+		// the first hit of each robin doesn't page fault on the audio
+		// thread. Returns the number of pages touched.
+
+		size_t nPages = 0;
+
+		for (auto& d : drums)
+		{
+			for (auto& layer : d->velocityLayers)
+			{
+				for (auto& robin : layer.robinMgr.robins)
+				{
+					auto& buff = robin.wave.buff;
+					nPages += Prefault(buff.samples.get(), buff.nSamples * sizeof(double), lock);
+				}
+			}
+		}
+
+		return nPages;
+	}
+
+	void DrumKit::SetRobinStrategy(RobinStrategy strategy_, double velocityJitter_)
+	{
+		for (auto& d : drums)
+		{
+			d->SetRobinStrategy(strategy_, velocityJitter_);
+		}
+	}
+
+	void DrumKit::SeedRngs(uint64_t seed_)
+	{
+		// Each drum gets its own seed, derived from the one given, so
+		// that a render can be repeated exactly.
+
+		rngSeed = seed_;
+
+		for (size_t i = 0; i < drums.size(); i++)
+		{
+			drums[i]->SeedRng(DrumSeed(i));
+		}
+	}
+
+	uint64_t DrumKit::DrumSeed(size_t drum_idx) const
+	{
+		return rngSeed + 0x9E3779B97F4A7C15ull * (drum_idx + 1);
+	}
+
 } // end of namespace
\ No newline at end of file
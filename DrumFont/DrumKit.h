@@ -41,6 +41,16 @@ namespace dfx
 {
 	using drum_ptr = std::shared_ptr<MultiLayeredDrum>;
 
+	// What a kit's robins are leveled by, going by the peak and rms
+	// numbers given in the drum font (see DrumKit::FinishLevels()).
+
+	enum class LevelBy
+	{
+		None,
+		Peak,
+		Rms
+	};
+
 	class DrumKit {
 	public:
 
@@ -49,6 +59,12 @@ namespace dfx
 		std::filesystem::path includeBasePath;  // Usually equal to sound font location
 		std::filesystem::path kitPath;          // Relative to sound font location
 		std::string name;
+		VelocityCurve velCurve;                 // For the drums that don't have their own
+		LevelBy levelBy;
+		double levelTarget;                     // Linear, 0 < target <= 1
+		RobinStrategy robinStrategy;            // For all the drums of the kit
+		double velocityJitter;                  // Ditto
+		uint64_t rngSeed;                       // The drums' seeds are derived from this
 
 		std::vector<drum_ptr> drums;
 		std::vector<drum_ptr> noteMap;
@@ -69,8 +85,17 @@ namespace dfx
 
 		void ClearNotes();
 		void FinishPaths(std::filesystem::path& soundFontPath_);
+		void FinishCurves();
+		void FinishLevels();
+		void FinishRobins();
+		void LevelDrum(MultiLayeredDrum& d) const;
 		void BuildNoteMap();
-		int LoadWaves(std::ostream &serr);
+		int LoadWaves(std::ostream &serr, double tail_floor_db = DefaultTailFloor_dB);
+		size_t PrefaultWaves(bool lock);
+
+		void SetRobinStrategy(RobinStrategy strategy_, double velocityJitter_ = 0.0);
+		void SeedRngs(uint64_t seed_);
+		uint64_t DrumSeed(size_t drum_idx) const;
 
 	};
 
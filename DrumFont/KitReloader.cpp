@@ -0,0 +1,543 @@
+/******************************************************************************\
+ * DFX - "Drum font exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This software helps facilitate the real-time playing of multi-layered drum
+ * samples, by implementing a language that specifies a master directory of the
+ * the sample wave files for a drum kit: where the samples are, what they are
+ * for, and a summary of their properties. The DFX format allows modifications
+ * of sample levels to achieve a unified, pleasing mix of sounds. Mechanisms
+ * such as velocity layers and round robins are supported for this purpose.
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate DFX files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include <algorithm>
+#include "KitReloader.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace dfx
+{
+	// ////////////////////////////////////////////////////////////////////
+
+	FileWatcher::FileWatcher()
+	: files{}
+	, stamps{}
+	, fileWatches{}
+	, inotifyFd(-1)
+	, pollInterval(250)
+	, lastPoll()
+	{
+	}
+
+	FileWatcher::~FileWatcher()
+	{
+		Clear();
+	}
+
+	void FileWatcher::Clear()
+	{
+#ifdef __linux__
+		if (inotifyFd >= 0)
+		{
+			close(inotifyFd); // Takes the watches with it
+		}
+#endif
+		inotifyFd = -1;
+		files.clear();
+		stamps.clear();
+		fileWatches.clear();
+	}
+
+	void FileWatcher::Watch(const std::vector<std::filesystem::path>& files_)
+	{
+		Clear();
+
+		files = files_;
+
+		for (auto& f : files)
+		{
+			std::error_code ec;
+			stamps.push_back(std::filesystem::last_write_time(f, ec));
+		}
+
+		fileWatches.assign(files.size(), -1);
+
+#ifdef __linux__
+		inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+		if (inotifyFd >= 0)
+		{
+			for (size_t i = 0; i < files.size(); i++)
+			{
+				auto dir = files[i].parent_path();
+				if (dir.empty()) dir = ".";
+
+				// Adding the same directory again hands back the same watch
+
+				fileWatches[i] = inotify_add_watch(inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+			}
+		}
+#endif
+	}
+
+	std::vector<std::filesystem::path> FileWatcher::Changed()
+	{
+		return inotifyFd >= 0 ? ChangedNotified() : ChangedPolled();
+	}
+
+	std::vector<std::filesystem::path> FileWatcher::ChangedNotified()
+	{
+		std::vector<std::filesystem::path> changed;
+
+#ifdef __linux__
+		alignas(inotify_event) char buf[4096];
+
+		for (;;)
+		{
+			auto n = read(inotifyFd, buf, sizeof(buf));
+			if (n <= 0) break; // EAGAIN: nothing more for now
+
+			for (char* p = buf; p < buf + n; )
+			{
+				auto ev = reinterpret_cast<inotify_event*>(p);
+				p += sizeof(inotify_event) + ev->len;
+
+				if (ev->len == 0) continue;
+
+				std::filesystem::path name(ev->name);
+
+				for (size_t i = 0; i < files.size(); i++)
+				{
+					if (fileWatches[i] == ev->wd && files[i].filename() == name)
+					{
+						if (std::find(changed.begin(), changed.end(), files[i]) == changed.end())
+						{
+							changed.push_back(files[i]);
+						}
+					}
+				}
+			}
+		}
+#endif
+
+		return changed;
+	}
+
+	std::vector<std::filesystem::path> FileWatcher::ChangedPolled()
+	{
+		std::vector<std::filesystem::path> changed;
+
+		auto now = std::chrono::steady_clock::now();
+
+		if (now - lastPoll < pollInterval)
+		{
+			return changed;
+		}
+
+		lastPoll = now;
+
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			std::error_code ec;
+			auto stamp = std::filesystem::last_write_time(files[i], ec);
+
+			if (!ec && stamp != stamps[i])
+			{
+				stamps[i] = stamp;
+				changed.push_back(files[i]);
+			}
+		}
+
+		return changed;
+	}
+
+	// ////////////////////////////////////////////////////////////////////
+
+	std::ostream& operator<<(std::ostream& sout, const KitDiff& diff)
+	{
+		sout << diff.drumsKept << " drums kept, " << diff.drumsChanged << " changed, ";
+		sout << diff.drumsAdded << " added, " << diff.drumsRemoved << " removed; ";
+		sout << diff.robinsReused << " robins reused, " << diff.robinsLoaded << " loaded";
+		return sout;
+	}
+
+	// ////////////////////////////////////////////////////////////////////
+
+	KitReloader::KitReloader(std::shared_ptr<PolyDrummer> drummer_, std::string_view fontPath_, const std::vector<std::shared_ptr<DrumKit>>& kits_, double tailFloor_dB_)
+	: fontPath(std::filesystem::path(fontPath_).generic_string())
+	, liveKits(kits_)
+	, drummer(drummer_)
+	, watcher()
+	, tailFloor_dB(tailFloor_dB_)
+	{
+		if (liveKits.size() > MAX_KITS)
+		{
+			liveKits.resize(MAX_KITS);
+		}
+
+		WatchSources();
+	}
+
+	void KitReloader::WatchSources()
+	{
+		// The font file, and every include file the live kits were built from
+
+		std::vector<std::filesystem::path> sources{ fontPath };
+
+		for (auto& kit : liveKits)
+		{
+			for (auto& d : kit->drums)
+			{
+				if (!d->includePath.empty() && std::find(sources.begin(), sources.end(), d->includePath) == sources.end())
+				{
+					sources.push_back(d->includePath);
+				}
+			}
+		}
+
+		watcher.Watch(sources);
+	}
+
+	int KitReloader::Poll(std::ostream& serr)
+	{
+		auto changed = watcher.Changed();
+
+		if (changed.empty())
+		{
+			return 0;
+		}
+
+		return Reload(serr, changed);
+	}
+
+	int KitReloader::Reload(std::ostream& serr, const std::vector<std::filesystem::path>& changed)
+	{
+		for (auto& f : changed)
+		{
+			serr << "Reloading " << f << std::endl;
+		}
+
+		std::vector<std::shared_ptr<DrumKit>> new_kits;
+
+		bool font_changed = std::find(changed.begin(), changed.end(), fontPath) != changed.end();
+
+		bool b = font_changed ? ReparseFont(serr, new_kits) : ReparseIncludes(serr, changed, new_kits);
+
+		if (!b)
+		{
+			serr << "Reload abandoned. The kits playing now stay put." << std::endl;
+			return 0;
+		}
+
+		int nswapped = 0;
+
+		for (auto& new_kit : new_kits)
+		{
+			auto it = std::find_if(liveKits.begin(), liveKits.end(),
+				[&new_kit](const std::shared_ptr<DrumKit>& k)
+				{
+					return k->name == new_kit->name;
+				});
+
+			if (it == liveKits.end())
+			{
+				serr << "Kit " << new_kit->name << " is new. Restart the player to use it." << std::endl;
+				continue;
+			}
+
+			int kitSlot = static_cast<int>(std::distance(liveKits.begin(), it));
+
+			KitDiff diff;
+
+			int errcnt = MergeKit(serr, *new_kit, **it, diff);
+
+			if (errcnt > 0)
+			{
+				serr << "Kit " << new_kit->name << " not swapped in due to " << errcnt << " file loading error(s)." << std::endl;
+				continue;
+			}
+
+			if (!diff.Changed())
+			{
+				continue;
+			}
+
+			new_kit->BuildNoteMap();
+
+			drummer->QueueKit(new_kit, kitSlot);
+			liveKits[kitSlot] = new_kit;
+			++nswapped;
+
+			serr << "Kit " << new_kit->name << " swapped in: " << diff << std::endl;
+		}
+
+		// The set of include files might have changed too
+
+		WatchSources();
+
+		return nswapped;
+	}
+
+	bool KitReloader::ReparseFont(std::ostream& serr, std::vector<std::shared_ptr<DrumKit>>& new_kits)
+	{
+		// The whole font, but just the parse and build. No waves yet.
+
+		auto df = std::make_unique<DrumFont>();
+
+		auto fname = fontPath.generic_string();
+		auto fview = std::string_view(fname);
+
+		auto rv = df->LoadStreamed(serr, fview);
+
+		if (rv != DfxResult::NoError)
+		{
+			return false;
+		}
+
+		new_kits = std::move(df->drumKits);
+
+		return true;
+	}
+
+	bool KitReloader::ReparseIncludes(std::ostream& serr, const std::vector<std::filesystem::path>& changed, std::vector<std::shared_ptr<DrumKit>>& new_kits)
+	{
+		// Only the drums from the changed include files get rebuilt. The
+		// new kits start out sharing all the other drums with the live ones.
+
+		for (auto& live_kit : liveKits)
+		{
+			std::shared_ptr<DrumKit> new_kit;
+
+			for (size_t i = 0; i < live_kit->drums.size(); i++)
+			{
+				auto& d = live_kit->drums[i];
+
+				if (d->includePath.empty() || std::find(changed.begin(), changed.end(), d->includePath) == changed.end())
+				{
+					continue;
+				}
+
+				if (!new_kit)
+				{
+					new_kit = std::make_shared<DrumKit>(*live_kit);
+				}
+
+				auto new_drum = ReparseInclude(serr, *live_kit, *d);
+
+				if (!new_drum)
+				{
+					return false;
+				}
+
+				new_kit->drums[i] = new_drum;
+			}
+
+			if (new_kit)
+			{
+				new_kits.push_back(new_kit);
+			}
+		}
+
+		return true;
+	}
+
+	drum_ptr KitReloader::ReparseInclude(std::ostream& serr, const DrumKit& kit, const MultiLayeredDrum& old_drum)
+	{
+		static constexpr bool as_include = true;
+
+		auto fname = old_drum.includePath.generic_string();
+		auto fview = std::string_view(fname);
+
+		EventParser ep;
+		DfxEventBuilder builder(serr, as_include, fname);
+
+		auto rvp = ep.LoadFile(fview, builder);
+
+		if (rvp != ParserResult::NoError)
+		{
+			serr << "Parsing error encountered:\n";
+			ep.PrintError(serr, fview);
+			return nullptr;
+		}
+
+		if (builder.errcnt > 0)
+		{
+			return nullptr;
+		}
+
+		auto drum = std::make_shared<MultiLayeredDrum>(old_drum.name, kit.cumulativePath, old_drum.drumPath, old_drum.midiNote);
+		drum->pan = old_drum.pan;
+		drum->bus = old_drum.bus;
+		drum->velCurve = old_drum.velCurve;
+		drum->velocityLayers = std::move(builder.drum.velocityLayers);
+		drum->includePath = old_drum.includePath;
+		drum->FinishPaths();
+
+		// Leveled, and choosing its robins, as the loaders would have
+		// it, so it compares fairly with the live one (see SameDrum()).
+
+		kit.LevelDrum(*drum);
+		drum->SetRobinStrategy(kit.robinStrategy, kit.velocityJitter);
+
+		return drum;
+	}
+
+	int KitReloader::MergeKit(std::ostream& serr, DrumKit& new_kit, DrumKit& live_kit, KitDiff& diff)
+	{
+		// Fills in the samples of the new kit, taking what we can from the
+		// live kit. Returns the number of waves that failed to load.
+
+		int errcnt = 0;
+
+		for (size_t i = 0; i < new_kit.drums.size(); i++)
+		{
+			auto& d = new_kit.drums[i];
+
+			auto it = std::find_if(live_kit.drums.begin(), live_kit.drums.end(),
+				[&d](const drum_ptr& x)
+				{
+					return x->name == d->name;
+				});
+
+			drum_ptr live = it != live_kit.drums.end() ? *it : nullptr;
+
+			if (live && SameDrum(*d, *live))
+			{
+				// The drum is only ever played from the audio thread, so
+				// the old kit and the new one can share it.
+				d = live;
+				++diff.drumsKept;
+				continue;
+			}
+
+			// A fresh rng, seeded as the loaders do. (Not a copy of the
+			// live drum's, which the audio thread may be advancing.)
+
+			d->SeedRng(new_kit.DrumSeed(i));
+
+			if (live)
+			{
+				++diff.drumsChanged;
+			}
+			else ++diff.drumsAdded;
+
+			for (auto& layer : d->velocityLayers)
+			{
+				for (auto& r : layer.robinMgr.robins)
+				{
+					auto live_robin = live ? FindRobin(*live, r) : nullptr;
+
+					if (live_robin)
+					{
+						r.wave.AliasSamples(live_robin->wave);
+						r.wave.path = live_robin->wave.path;
+						++diff.robinsReused;
+					}
+					else
+					{
+						if (!r.LoadWave(serr, tailFloor_dB)) ++errcnt;
+						++diff.robinsLoaded;
+					}
+				}
+
+				layer.robinMgr.BuildAliasTable();
+			}
+		}
+
+		for (auto& live : live_kit.drums)
+		{
+			auto it = std::find_if(new_kit.drums.begin(), new_kit.drums.end(),
+				[&live](const drum_ptr& x)
+				{
+					return x->name == live->name;
+				});
+
+			if (it == new_kit.drums.end()) ++diff.drumsRemoved;
+		}
+
+		return errcnt;
+	}
+
+	bool KitReloader::SameRobin(const Robin& a, const Robin& b)
+	{
+		// Same samples in memory, that is
+
+		return a.fullPath == b.fullPath && a.start_frame == b.start_frame && a.end_frame == b.end_frame && a.peak == b.peak;
+	}
+
+	bool KitReloader::SameDrum(const MultiLayeredDrum& a, const MultiLayeredDrum& b)
+	{
+		if (a.midiNote != b.midiNote || a.pan != b.pan || a.bus != b.bus || !a.velCurve.SameAs(b.velCurve) || a.robinStrategy != b.robinStrategy || a.velocityJitter != b.velocityJitter || a.velocityLayers.size() != b.velocityLayers.size())
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < a.velocityLayers.size(); i++)
+		{
+			auto& la = a.velocityLayers[i];
+			auto& lb = b.velocityLayers[i];
+
+			if (la.vrange.iMinVel != lb.vrange.iMinVel || la.vrange.iMaxVel != lb.vrange.iMaxVel)
+			{
+				return false;
+			}
+
+			auto& ra = la.robinMgr.robins;
+			auto& rb = lb.robinMgr.robins;
+
+			if (ra.size() != rb.size())
+			{
+				return false;
+			}
+
+			for (size_t j = 0; j < ra.size(); j++)
+			{
+				if (!SameRobin(ra[j], rb[j]) || ra[j].rms != rb[j].rms || ra[j].weight != rb[j].weight || ra[j].gain != rb[j].gain)
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	Robin* KitReloader::FindRobin(MultiLayeredDrum& drum, const Robin& r)
+	{
+		for (auto& layer : drum.velocityLayers)
+		{
+			for (auto& x : layer.robinMgr.robins)
+			{
+				if (SameRobin(x, r)) return &x;
+			}
+		}
+
+		return nullptr;
+	}
+
+} // end of namespace
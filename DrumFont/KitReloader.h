@@ -0,0 +1,154 @@
+#pragma once
+
+/******************************************************************************\
+ * DFX - "Drum font exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This software helps facilitate the real-time playing of multi-layered drum
+ * samples, by implementing a language that specifies a master directory of the
+ * the sample wave files for a drum kit: where the samples are, what they are
+ * for, and a summary of their properties. The DFX format allows modifications
+ * of sample levels to achieve a unified, pleasing mix of sounds. Mechanisms
+ * such as velocity layers and round robins are supported for this purpose.
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate DFX files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <chrono>
+#include <ostream>
+#include <filesystem>
+#include "DrumFont.h"
+#include "PolyDrummer.h"
+
+namespace dfx
+{
+	// Keeps an eye on a set of files. On Linux we use inotify, watching the
+	// directories the files are in, since a lot of editors save by writing a
+	// new file and renaming it over the old one. Elsewhere, we poll the
+	// modification times, at most once per poll interval.
+
+	class FileWatcher {
+	public:
+
+		std::vector<std::filesystem::path> files;
+		std::vector<std::filesystem::file_time_type> stamps;
+		std::vector<int> fileWatches;  // inotify watch descriptor of each file's directory
+
+		int inotifyFd;                 // -1 if we're polling
+
+		std::chrono::milliseconds pollInterval;
+		std::chrono::steady_clock::time_point lastPoll;
+
+	public:
+
+		FileWatcher();
+		virtual ~FileWatcher();
+
+		FileWatcher(const FileWatcher&) = delete;
+		void operator=(const FileWatcher&) = delete;
+
+		void Watch(const std::vector<std::filesystem::path>& files_);
+		void Clear();
+
+		std::vector<std::filesystem::path> Changed(); // Doesn't block
+
+	protected:
+
+		std::vector<std::filesystem::path> ChangedNotified();
+		std::vector<std::filesystem::path> ChangedPolled();
+	};
+
+	// The tally of what a reload did to a kit
+
+	struct KitDiff
+	{
+		int drumsKept{ 0 };
+		int drumsChanged{ 0 };
+		int drumsAdded{ 0 };
+		int drumsRemoved{ 0 };
+		int robinsReused{ 0 };
+		int robinsLoaded{ 0 };
+
+		bool Changed() const { return drumsChanged + drumsAdded + drumsRemoved > 0; }
+	};
+
+	std::ostream& operator<<(std::ostream& sout, const KitDiff& diff);
+
+	// Hot reloading of a drum font while it plays. When the font file or
+	// one of its include files changes, we re-parse just that file. If it's
+	// an include file, only the drums that use it get rebuilt. Then each new
+	// kit is diffed against the live one:
+	//
+	//   - Drums that didn't change at all are carried over as is.
+	//   - Robins whose file, extent, and scale didn't change share the
+	//     samples of the live robin. Only the rest get loaded.
+	//
+	// The new kit is then queued up on the drummer, which swaps it in at
+	// the top of an audio block. Voices already sounding play on with the
+	// old kit until they're done (see PolyDrummer::ReapRetiredKits()).
+	//
+	// Kits are matched with the drummer's kit slots by name. Changes to the
+	// wave files themselves aren't picked up.
+
+	class KitReloader {
+	public:
+
+		std::filesystem::path fontPath;
+		std::vector<std::shared_ptr<DrumKit>> liveKits; // Index is the kit slot
+		std::shared_ptr<PolyDrummer> drummer;
+		FileWatcher watcher;
+		double tailFloor_dB;
+
+	public:
+
+		// The kits must be the ones given to the drummer, in kit slot order
+
+		KitReloader(std::shared_ptr<PolyDrummer> drummer_, std::string_view fontPath_, const std::vector<std::shared_ptr<DrumKit>>& kits_, double tailFloor_dB_ = DefaultTailFloor_dB);
+		virtual ~KitReloader() { }
+
+		// Call these from any thread but the audio thread. They return how
+		// many kits were swapped in.
+
+		int Poll(std::ostream& serr);
+		int Reload(std::ostream& serr, const std::vector<std::filesystem::path>& changed);
+
+	protected:
+
+		void WatchSources();
+
+		bool ReparseFont(std::ostream& serr, std::vector<std::shared_ptr<DrumKit>>& new_kits);
+		bool ReparseIncludes(std::ostream& serr, const std::vector<std::filesystem::path>& changed, std::vector<std::shared_ptr<DrumKit>>& new_kits);
+		drum_ptr ReparseInclude(std::ostream& serr, const DrumKit& kit, const MultiLayeredDrum& old_drum);
+
+		int MergeKit(std::ostream& serr, DrumKit& new_kit, DrumKit& live_kit, KitDiff& diff);
+
+		static bool SameRobin(const Robin& a, const Robin& b);
+		static bool SameDrum(const MultiLayeredDrum& a, const MultiLayeredDrum& b);
+		static Robin* FindRobin(MultiLayeredDrum& drum, const Robin& r);
+	};
+
+} // end of namespace
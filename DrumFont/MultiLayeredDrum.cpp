@@ -33,6 +33,7 @@
 \******************************************************************************/
 
 #include <algorithm>
+#include <cmath>
 #include "MultiLayeredDrum.h"
 
 namespace dfx
@@ -40,9 +41,16 @@ namespace dfx
 	MultiLayeredDrum::MultiLayeredDrum(const std::string& name_, std::filesystem::path cumulativePath_, std::filesystem::path drumPath_, int midiNote_)
 	: cumulativePath(cumulativePath_)
 	, drumPath(drumPath_)
+	, includePath()
 	, name(name_)
 	, velocityLayers()
 	, midiNote(midiNote_)
+	, pan(0.0)
+	, bus(0)
+	, velCurve()
+	, robinStrategy(RobinStrategy::Cycle)
+	, velocityJitter(0.0)
+	, rng()
 	{
 		cumulativePath /= drumPath;
 		cumulativePath = cumulativePath.generic_string();
@@ -51,9 +59,16 @@ namespace dfx
 	MultiLayeredDrum::MultiLayeredDrum(const MultiLayeredDrum& other)
 	: cumulativePath(other.cumulativePath)
 	, drumPath(other.drumPath)
+	, includePath(other.includePath)
 	, name(other.name)
 	, velocityLayers(other.velocityLayers)
 	, midiNote(other.midiNote)
+	, pan(other.pan)
+	, bus(other.bus)
+	, velCurve(other.velCurve)
+	, robinStrategy(other.robinStrategy)
+	, velocityJitter(other.velocityJitter)
+	, rng(other.rng)
 	{
 		// Copy constructor
 	}
@@ -62,12 +77,22 @@ namespace dfx
 	MultiLayeredDrum::MultiLayeredDrum(MultiLayeredDrum&& other) noexcept
 	: cumulativePath(std::move(other.cumulativePath))
 	, drumPath(std::move(other.drumPath))
+	, includePath(std::move(other.includePath))
 	, name(std::move(other.name))
 	, velocityLayers(std::move(other.velocityLayers))
 	, midiNote(other.midiNote)
+	, pan(other.pan)
+	, bus(other.bus)
+	, velCurve(other.velCurve)
+	, robinStrategy(other.robinStrategy)
+	, velocityJitter(other.velocityJitter)
+	, rng(other.rng)
 	{
 		// Move constructor
 		other.midiNote = 0; // just keeping move pedantics :)
+		other.pan = 0.0;
+		other.bus = 0;
+		other.velocityJitter = 0.0;
 	}
 
 	void MultiLayeredDrum::operator=(const MultiLayeredDrum& other)
@@ -78,10 +103,16 @@ namespace dfx
 		{
 			cumulativePath = other.cumulativePath;
 			drumPath = other.drumPath;
+			includePath = other.includePath;
 			name = other.name;
 			velocityLayers = other.velocityLayers;
 			midiNote = other.midiNote;
-
+			pan = other.pan;
+			bus = other.bus;
+			velCurve = other.velCurve;
+			robinStrategy = other.robinStrategy;
+			velocityJitter = other.velocityJitter;
+			rng = other.rng;
 		}
 	}
 
@@ -93,14 +124,35 @@ namespace dfx
 		{
 			cumulativePath = std::move(other.cumulativePath);
 			drumPath = std::move(other.drumPath);
+			includePath = std::move(other.includePath);
 			name = std::move(other.name);
 			velocityLayers = std::move(other.velocityLayers);
 			midiNote = other.midiNote;
+			pan = other.pan;
+			bus = other.bus;
+			velCurve = other.velCurve;
+			robinStrategy = other.robinStrategy;
+			velocityJitter = other.velocityJitter;
+			rng = other.rng;
 			other.midiNote = 0; // just keeping move pedantics :)
+			other.pan = 0.0;
+			other.bus = 0;
+			other.velocityJitter = 0.0;
 		}
 	}
 
 
+	void MultiLayeredDrum::SetRobinStrategy(RobinStrategy strategy_, double velocityJitter_)
+	{
+		robinStrategy = strategy_;
+		velocityJitter = velocityJitter_;
+	}
+
+	void MultiLayeredDrum::SeedRng(uint64_t seed_)
+	{
+		rng.Seed(seed_);
+	}
+
 	void MultiLayeredDrum::SortLayers()
 	{
 		// First, take all the velocity codes (aka min velocity values) from
@@ -166,51 +218,54 @@ namespace dfx
 		// Whew! We're done!
 	}
 
-	int MultiLayeredDrum::FindVelocityLayer(int vel)         // Mostly for debugging
+	void MultiLayeredDrum::FinishPaths()
 	{
-		int idx = -1;
+		// Sort the velocity layers, and then finish instantiating
+		// the paths of the individual sound files.
+
+		SortLayers();
 
-		if (vel < 0 || vel > 127)
+		for (auto& layer : velocityLayers)
 		{
-			//oStream_ << "MultiLayeredDrum::SelectVelocityLayer(): Velocity " << vel << " out of range.\n";
-			//handleError(FUNCTION_ARGUMENT);
+			layer.FinishPaths(cumulativePath);
 		}
+	}
+
+	int MultiLayeredDrum::FindVelocityLayer(int vel)         // Mostly for debugging
+	{
+		// The layers are sorted, so the one we want is the last one
+		// starting at or below vel. Anything below the first layer,
+		// (eg. velocity 0), gets the first layer. So this never fails.
+
+		int idx = 0;
 
 		int n = static_cast<int>(velocityLayers.size());
 
-		for (int i = 0; i < n; i++)
+		for (int i = 1; i < n; i++)
 		{
-			const auto& e = velocityLayers[i].vrange;
-			if ((vel >= e.iMinVel) && (vel <= e.iMaxVel)) return i; //  velocityLayers[i].vrange.robinsIdx;
+			if (vel < velocityLayers[i].vrange.iMinVel) break;
+			idx = i;
 		}
 
-		//oStream_ << "MultiLayeredDrum::SelectVelocityLayer(): Couldn't find a range for velocity " << vel << "\n";
-		//handleError(UNSPECIFIED);
-
 		return idx;
 	}
 
 	int MultiLayeredDrum::FindVelocityLayer(double vel)
 	{
-		int idx = -1;
+		// As above. The ranges of the layers have gaps between them when
+		// scaled, (eg. 63/127 to 64/127), so we don't look at fMaxVel.
+		// Velocities in a gap go with the layer below.
 
-		if (vel < 0.0 || vel > 1.0)
-		{
-			//oStream_ << "MultiLayeredDrum::SelectVelocityLayer(): Velocity " << vel << " out of range.\n";
-			//handleError(FUNCTION_ARGUMENT);
-		}
+		int idx = 0;
 
 		int n = static_cast<int>(velocityLayers.size());
 
-		for (int i = 0; i < n; i++)
+		for (int i = 1; i < n; i++)
 		{
-			const auto& e = velocityLayers[i].vrange;
-			if ((vel >= e.fMinVel) && (vel <= e.fMaxVel)) return i; //  velocityLayers[i].vrange.robinsIdx;
+			if (vel < velocityLayers[i].vrange.fMinVel) break;
+			idx = i;
 		}
 
-		//oStream_ << "MultiLayeredDrum::SelectVelocityLayer(): Couldn't find a range for velocity " << vel << "\n";
-		//handleError(UNSPECIFIED);
-
 		return idx;
 	}
 
@@ -236,17 +291,35 @@ namespace dfx
 
 	MemWave& MultiLayeredDrum::ChooseWave(double vel)
 	{
+		return ChooseRobin(vel).wave;
+	}
+
+	Robin& MultiLayeredDrum::ChooseRobin(double vel)
+	{
+		if (robinStrategy == RobinStrategy::VelocityJittered && velocityJitter > 0.0)
+		{
+			// Nudge the velocity a bit so that hits near a layer boundary
+			// sometimes come from the neighboring layer. We do it in terms
+			// of velocity codes, so we land on a code some layer covers.
+
+			double v = vel * 127.0 + velocityJitter * 127.0 * (2.0 * rng.Uniform() - 1.0);
+			int vel_code = static_cast<int>(std::lround(v));
+			vel_code = std::clamp(vel_code, 1, 127);
+
+			auto& rmgr = SelectVelocityLayer(vel_code);
+			return rmgr.ChooseRobin(robinStrategy, rng);
+		}
+
 		auto& rmgr = SelectVelocityLayer(vel);
-		auto& mw = rmgr.ChooseWave();
-		return mw;
+		return rmgr.ChooseRobin(robinStrategy, rng);
 	}
 
-	int MultiLayeredDrum::LoadWaves(std::ostream &serr)
+	int MultiLayeredDrum::LoadWaves(std::ostream &serr, double tail_floor_db)
 	{
 		int errcnt = 0;
 		for (auto& lp : velocityLayers)
 		{
-			int local_errcnt = lp.LoadWaves(serr);
+			int local_errcnt = lp.LoadWaves(serr, tail_floor_db);
 			errcnt += local_errcnt;
 		}
 		return errcnt;
@@ -37,6 +37,7 @@
 #include <memory>
 #include <filesystem>
 #include "VelocityLayer.h"
+#include "VelocityCurves.h"
 
 namespace dfx
 {
@@ -45,11 +46,19 @@ namespace dfx
 
 		std::filesystem::path cumulativePath;  // For ease of recursing down
 		std::filesystem::path drumPath;        // Relative to kit location
+		std::filesystem::path includePath;     // The include file the drum came from, if any
 		std::string name;
 
 		std::vector<VelocityLayer> velocityLayers;
 
 		int midiNote; // 0 - 127
+		double pan;   // -1 (hard left) to 1 (hard right). 0 is center.
+		int bus;      // Which output bus the drum plays on. 0 is the main one.
+		VelocityCurve velCurve; // Gain for each velocity. If unspecified, the kit's.
+
+		RobinStrategy robinStrategy;
+		double velocityJitter; // +/- amount, for RobinStrategy::VelocityJittered. 0 - 1 scale.
+		XorShiftRng rng;       // Each drum has its own, so no sharing across threads or drums
 
 	public:
 
@@ -62,6 +71,7 @@ namespace dfx
 		void operator=(MultiLayeredDrum&& other) noexcept;
 
 		void SortLayers();
+		void FinishPaths();
 
 		int FindVelocityLayer(int vel);         // Mostly for debugging
 		int FindVelocityLayer(double vel);
@@ -69,12 +79,16 @@ namespace dfx
 		RobinMgr& SelectVelocityLayer(int vel);  // Mostly for debugging
 		RobinMgr& SelectVelocityLayer(double vel);
 
+		void SetRobinStrategy(RobinStrategy strategy_, double velocityJitter_ = 0.0);
+		void SeedRng(uint64_t seed_);
+
 	public:
 
-		int LoadWaves(std::ostream &serr);
+		int LoadWaves(std::ostream &serr, double tail_floor_db = DefaultTailFloor_dB);
 
 		MemWave& ChooseWave(int vel);    // Mostly for debugging
 		MemWave& ChooseWave(double vel);
+		Robin& ChooseRobin(double vel);  // When the robin's gain is wanted too
 	};
 
 } // end of namespace
\ No newline at end of file
@@ -34,6 +34,8 @@
 
 #include "PolyDrummer.h"
 #include "VelocityCurves.h"
+#include "SampleCache.h"
+#include "RealTime.h"
 
 namespace dfx
 {
@@ -61,19 +63,322 @@ namespace dfx
 
 	PolyDrummer::PolyDrummer(int polyPhony)
 	: polyTable(polyPhony)
+	, kitGeneration(0)
+	, routes{}
+	, oldestLiveGeneration(0)
 	, interrupt_same_note(false)  // @@ We don't really like the interrupt scheme. And it might be buggy anyway.
+	, nBuses(1)
+	, masterGain(1.0)
+	, workers()
+	, voicesPerWorker(16)
+	, voiceList(polyPhony)
+	, workerMix{}
+	, nextVoice(0)
+	, renderOut(nullptr)
+	, renderFrames(0)
+	, nRenderVoices(0)
+	, realTime(false)
+	, rtPriority(0)
+	, rtCpu(-1)
+	, rtThreadPending(false)
 	{
 	}
 
 	PolyDrummer::~PolyDrummer()
 	{
+		// Audio stream is presumed stopped by now
+
+		for (auto& k : kits)
+		{
+			delete k.pending.exchange(nullptr);
+		}
+
+		for (auto& r : retiredKits)
+		{
+			delete r.kit.exchange(nullptr);
+		}
 	}
 
-	void PolyDrummer::UseKit(std::shared_ptr<DrumKit> &kit_, double systemSampleRate_)
+	bool PolyDrummer::UseKit(std::shared_ptr<DrumKit> &kit_, double systemSampleRate_, int kitSlot)
 	{
-		drumKit = kit_;
+		if (!IsKitSlot(kitSlot))
+		{
+			return false;
+		}
+
+		kits[kitSlot].kit = kit_;
+
 		polyTable.SetupEmptyTable();
+
+		for (auto& k : kits)
+		{
+			k.activeVoices = 0;
+		}
+
 		SetSampleRate(systemSampleRate_);
+
+		return true;
+	}
+
+	bool PolyDrummer::SetKitPolyphony(int kitSlot, int maxVoices)
+	{
+		if (!IsKitSlot(kitSlot))
+		{
+			return false;
+		}
+
+		kits[kitSlot].maxVoices = maxVoices;
+
+		return true;
+	}
+
+	bool PolyDrummer::SetMicGain(int kitSlot, unsigned mic, double left, double right)
+	{
+		// Safe to call while playing. Zero for both turns the mic off.
+
+		if (!IsKitSlot(kitSlot) || mic >= MAX_MICS)
+		{
+			return false;
+		}
+
+		auto& mixer = kits[kitSlot].mics;
+		mixer.left[mic].store(left, std::memory_order_relaxed);
+		mixer.right[mic].store(right, std::memory_order_relaxed);
+
+		return true;
+	}
+
+	bool PolyDrummer::AddRoute(int channel, int kitSlot, int loNote, int hiNote)
+	{
+		if (!IsKitSlot(kitSlot))
+		{
+			return false;
+		}
+
+		routes.push_back({ channel, loNote, hiNote, kitSlot });
+
+		return true;
+	}
+
+	void PolyDrummer::ClearRoutes()
+	{
+		routes.clear();
+	}
+
+	int PolyDrummer::RouteNote(int channel, int noteNumber) const
+	{
+		// Returns the kit slot to use, or -1 if no route matches
+
+		if (routes.empty())
+		{
+			return 0;
+		}
+
+		for (auto& r : routes)
+		{
+			if ((r.channel == 0 || r.channel == channel) && noteNumber >= r.loNote && noteNumber <= r.hiNote)
+			{
+				return r.kitSlot;
+			}
+		}
+
+		return -1;
+	}
+
+	bool PolyDrummer::QueueKit(std::shared_ptr<DrumKit> kit_, int kitSlot)
+	{
+		// Called from any thread but the audio thread. The kit should have
+		// its waves loaded already. If an earlier kit is still waiting to
+		// be picked up, it's superseded, and we let it go here.
+
+		if (!IsKitSlot(kitSlot))
+		{
+			return false;
+		}
+
+		if (realTime)
+		{
+			kit_->PrefaultWaves(true);
+		}
+
+		auto p = new std::shared_ptr<DrumKit>(std::move(kit_));
+		auto old = kits[kitSlot].pending.exchange(p, std::memory_order_acq_rel);
+		delete old;
+
+		return true;
+	}
+
+	std::thread PolyDrummer::LoadKitAsync(std::shared_ptr<DrumKit> kit_, std::ostream& serr, int kitSlot)
+	{
+		// Loads the waves of the kit on a background thread, then queues
+		// the kit up for the audio thread. Caller joins the thread.
+
+		return std::thread([this, kit_, &serr, kitSlot]()
+		{
+			int errcnt = kit_->LoadWaves(serr);
+
+			if (errcnt == 0)
+			{
+				QueueKit(kit_, kitSlot);
+			}
+			else
+			{
+				serr << "Kit " << kit_->name << " not swapped in due to " << errcnt << " file loading error(s)." << std::endl;
+			}
+		});
+	}
+
+	int PolyDrummer::ReapRetiredKits()
+	{
+		// Called from any thread but the audio thread. Lets go of retired
+		// kits that no voice is playing anymore. Returns how many.
+
+		int n = 0;
+
+		auto oldestLive = oldestLiveGeneration.load(std::memory_order_acquire);
+
+		for (auto& r : retiredKits)
+		{
+			auto p = r.kit.load(std::memory_order_acquire);
+
+			if (p && r.generation.load(std::memory_order_relaxed) < oldestLive)
+			{
+				r.kit.store(nullptr, std::memory_order_release);
+				delete p; // The kit itself goes when the last claim on it does
+				++n;
+			}
+		}
+
+		if (n > 0)
+		{
+			// The sample cache might be the last one holding onto those
+			// samples, so have it let go of them too.
+			SampleCache::Instance().Purge();
+		}
+
+		return n;
+	}
+
+	void PolyDrummer::BeginBlock()
+	{
+		// Audio thread only. If a new kit is waiting, swap it in. We need a
+		// free retired slot to park the old kit in first. If there isn't one,
+		// we'll try again next block.
+
+		if (rtThreadPending.load(std::memory_order_relaxed))
+		{
+			// The first block on this thread (in real time mode)
+
+			MakeThreadRealTime(rtPriority, rtCpu);
+			rtThreadPending.store(false, std::memory_order_relaxed);
+		}
+
+		for (auto& k : kits)
+		{
+			if (k.pending.load(std::memory_order_relaxed) == nullptr)
+			{
+				continue;
+			}
+
+			RetiredKit* slot = nullptr;
+
+			for (auto& r : retiredKits)
+			{
+				if (r.kit.load(std::memory_order_acquire) == nullptr)
+				{
+					slot = &r;
+					break;
+				}
+			}
+
+			if (slot == nullptr)
+			{
+				break;
+			}
+
+			auto p = k.pending.exchange(nullptr, std::memory_order_acq_rel);
+
+			if (p)
+			{
+				// No allocating or freeing here. The holder we were
+				// handed now holds the old kit instead.
+
+				std::swap(k.kit, *p);
+				slot->generation.store(kitGeneration, std::memory_order_relaxed);
+				slot->kit.store(p, std::memory_order_release);
+				++kitGeneration;
+			}
+		}
+
+		PublishOldestLiveGeneration();
+	}
+
+	void PolyDrummer::RetireVoice(int slot)
+	{
+		// Let go of the samples now, while their kit is sure to
+		// still be around. That way, we never free them here.
+
+		auto& e = polyTable.elems[slot];
+		e.wave.ReleaseSamples();
+		--kits[e.kitSlot].activeVoices;
+		polyTable.Deactivate(slot);
+	}
+
+	void PolyDrummer::VoiceMix(const PolyTableElem& e, MicMix& mix) const
+	{
+		// How a voice's wave goes into the output this block. That's the
+		// gain and pan of the voice, and for a multi-mic wave, the kit's
+		// mic mixer too. Mics turned off there are left out.
+
+		double left = e.panGain.left * e.gain;
+		double right = e.panGain.right * e.gain;
+		auto nChannels = e.wave.buff.nChannels;
+
+		if (nChannels <= 2)
+		{
+			mix.nMics = nChannels <= 1 ? 1 : 2;
+			mix.mic[0] = 0;
+			mix.mic[1] = 1;
+			mix.gain[0] = { left, right };
+			mix.gain[1] = { left, right };
+			return;
+		}
+
+		auto& mixer = kits[e.kitSlot].mics;
+		unsigned nMics = nChannels < MAX_MICS ? nChannels : MAX_MICS;
+
+		mix.nMics = 0;
+
+		for (unsigned m = 0; m < nMics; m++)
+		{
+			double l = mixer.left[m].load(std::memory_order_relaxed) * left;
+			double r = mixer.right[m].load(std::memory_order_relaxed) * right;
+
+			if (l != 0.0 || r != 0.0)
+			{
+				mix.mic[mix.nMics] = m;
+				mix.gain[mix.nMics] = { l, r };
+				++mix.nMics;
+			}
+		}
+	}
+
+	void PolyDrummer::PublishOldestLiveGeneration()
+	{
+		// Let the reaper know the oldest kit still being played
+
+		unsigned oldest = kitGeneration;
+
+		int i = polyTable.aHead;
+
+		while (i != -1)
+		{
+			auto& e = polyTable.elems[i];
+			if (e.kitGeneration < oldest) oldest = e.kitGeneration;
+			i = e.older;
+		}
+
+		oldestLiveGeneration.store(oldest, std::memory_order_release);
 	}
 
 	bool PolyDrummer::HasSoundsToPlay()
@@ -82,11 +387,22 @@ namespace dfx
 		return i != -1;
 	}
 
-	// @@ TOTAL EXPERIMENT
-	//DynRangeCurve vel_curve(50.0, 127);
-	//KneeCurve vel_curve(127, double outputOffset_, double outputFullScale_, double kneePos_);
+	void PolyDrummer::noteOnDirect(int noteNumber, int velCode)
+	{
+		noteOnKit(0, noteNumber, velCode);
+	}
+
+	void PolyDrummer::noteOn(int channel, int noteNumber, int velCode)
+	{
+		int kitSlot = RouteNote(channel, noteNumber);
+
+		if (IsKitSlot(kitSlot))
+		{
+			noteOnKit(kitSlot, noteNumber, velCode);
+		}
+	}
 
-	void PolyDrummer::noteOnDirect(int noteNumber, int velCode) // double amplitude)
+	void PolyDrummer::noteOnKit(int kitSlot, int noteNumber, int velCode) // double amplitude)
 	{
 		double amplitude = velCode / 127.0;
 
@@ -97,8 +413,21 @@ namespace dfx
 		}
 #endif
 
+		if (!IsKitSlot(kitSlot))
+		{
+			return;
+		}
+
 		// Select a drum. If no mapping for the note to a drum, then we're outta here!
 
+		auto& k = kits[kitSlot];
+		auto& drumKit = k.kit;
+
+		if (!drumKit)
+		{
+			return; // No kit in this slot (yet)
+		}
+
 #if PIANO_KEY
 
 		int mapped_note = pianoKeyToDrumMap[noteNumber]; // temporary kludge
@@ -127,7 +456,7 @@ namespace dfx
 
 			while (slot != -1)
 			{
-				if (e[slot].soundNumber == noteNumber)
+				if (e[slot].soundNumber == noteNumber && e[slot].kitSlot == kitSlot)
 				{
 					e[slot].wave.Reset();
 					break;
@@ -142,21 +471,39 @@ namespace dfx
 			// Look first for an unused wave or preempt the
 			// oldest if already at maximum polyphony.
 
+			if (k.maxVoices > 0 && k.activeVoices >= k.maxVoices)
+			{
+				// This kit is at its own polyphony cap, so turn off its
+				// oldest voice, rather than steal from the other kits.
+
+				int i = polyTable.aOldest;
+
+				while (i != -1 && polyTable.elems[i].kitSlot != kitSlot)
+				{
+					i = polyTable.elems[i].younger;
+				}
+
+				if (i != -1)
+				{
+					RetireVoice(i);
+				}
+			}
+
 			if (polyTable.IsFull())
 			{
 				// Turn off oldest since we're going to be using its slot. 
-				// @@ UPDATE: Actually, don't need to do anything here.
+				RetireVoice(polyTable.aOldest);
 			}
 
 			// grab a slot to use and place on active list
-			// if table is full, we reuse the oldest slot
 
 			slot = polyTable.ActivateSlot(noteNumber);
 
 			// Point to the proper sound wave to use
 
 			auto& e = polyTable.elems[slot];
-			auto& mw = drum->ChooseWave(amplitude);
+			auto& robin = drum->ChooseRobin(amplitude);
+			auto& mw = robin.wave;
 
 			// Let the appropriate slot in the poly table
 			// alias the wave sample we're going to play.
@@ -165,10 +512,20 @@ namespace dfx
 			// and data rate don't match.)
 
 			e.wave.AliasSamples(mw);
+			e.render = ChooseStereoRenderer(e.wave);
+			e.panGain = PanGains(drum->pan, e.wave.buff.nChannels);
+			e.bus = drum->bus >= 0 && static_cast<unsigned>(drum->bus) < nBuses ? drum->bus : 0;
+			e.kitGeneration = kitGeneration;
+			e.kitSlot = kitSlot;
+			e.level = robin.gain * masterGain;
+			++k.activeVoices;
 		}
 
+		// The velocity picks the layer (above), and the drum's velocity
+		// curve gives the gain, on top of the robin's level.
+
 		auto& e = polyTable.elems[slot];
-		//e.gain = vel_curve.pts[velCode - 1];
+		e.gain = drum->velCurve.Gain(velCode) * e.level;
 
 #if 0
 		e.filter.setPole(0.999 - (amplitude * 0.6));
@@ -204,37 +561,192 @@ namespace dfx
 	// @@ TODO: Someday MonoTick()
 
 
-	StereoFrame<double> PolyDrummer::StereoTick()
+	void PolyDrummer::SetBusCount(unsigned nBuses_)
+	{
+		if (nBuses_ < 1) nBuses_ = 1;
+		else if (nBuses_ > MAX_BUSES) nBuses_ = MAX_BUSES;
+		nBuses = nBuses_;
+	}
+
+	bool PolyDrummer::StartWorkers(unsigned nWorkers, bool pin)
 	{
-		// We advance to the next frame of each active drum.
-		// If a drum is finished playing, deactivate that drum
-		// in the table.
+		workers.Stop();
 
-		double left = 0.0;
-		double right = 0.0;
+		if (nWorkers > MAX_WORKERS) nWorkers = MAX_WORKERS;
 
-		int i = polyTable.aHead;
+		// Each worker gets buffers for a block's worth of every bus, so
+		// nothing gets allocated while rendering.
 
-		while (i != -1)
+		for (unsigned w = 1; w <= MAX_WORKERS; w++)
 		{
-			int nxt = polyTable.elems[i].older;
+			workerMix[w].assign(w <= nWorkers ? MAX_BLOCK_FRAMES * MAX_BUSES : 0, StereoFrame<engine_t>());
+		}
+
+		return workers.Start(nWorkers, pin, realTime ? rtPriority - 1 : 0);
+	}
+
+	bool PolyDrummer::EnableRealTime(std::ostream& serr, int priority, int cpu)
+	{
+		realTime = true;
+		rtPriority = priority;
+		rtCpu = cpu;
+		rtThreadPending = true;
 
-			if (polyTable.elems[i].wave.IsFinished())
+		bool locked = LockAllMemory(serr);
+
+		size_t nPages = 0;
+
+		for (auto& k : kits)
+		{
+			if (k.kit)
 			{
-				polyTable.Deactivate(i);
+				nPages += k.kit->PrefaultWaves(!locked);
 			}
-			else
+		}
+
+		serr << "Real time mode: " << nPages << " sample pages prefaulted" << (locked ? ", all memory locked." : ".") << std::endl;
+
+		// Workers already going pick up the priority by starting over
+
+		if (workers.Size() > 0)
+		{
+			StartWorkers(workers.Size());
+		}
+
+		return locked;
+	}
+
+	void PolyDrummer::StopWorkers()
+	{
+		workers.Stop();
+	}
+
+	StereoFrame<engine_t> PolyDrummer::StereoTick()
+	{
+		StereoFrame<engine_t> frames[MAX_BUSES];
+		StereoRender(frames, 1);
+
+		StereoFrame<engine_t> frame = frames[0];
+
+		for (unsigned b = 1; b < nBuses; b++)
+		{
+			frame.left += frames[b].left;
+			frame.right += frames[b].right;
+		}
+
+		return frame;
+	}
+
+	void PolyDrummer::StereoRender(StereoFrame<engine_t>* out, unsigned nFrames)
+	{
+		// We render the block one active drum at a time, each with the
+		// inner loop picked for it at note on (see VoiceRender.h.) Each
+		// drum goes into the block of the bus it plays on. If there are
+		// enough drums playing, the workers help out.
+
+		for (unsigned f = 0; f < nFrames * nBuses; f++)
+		{
+			out[f].left = 0.0;
+			out[f].right = 0.0;
+		}
+
+		unsigned nVoices = 0;
+
+		for (int i = polyTable.aHead; i != -1; i = polyTable.elems[i].older)
+		{
+			voiceList[nVoices++] = i;
+		}
+
+		// One thread for each voicesPerWorker voices. We're one of them.
+
+		unsigned nHelpers = 0;
+
+		if (workers.Size() > 0 && nFrames <= MAX_BLOCK_FRAMES && nVoices >= 2 * voicesPerWorker)
+		{
+			nHelpers = nVoices / voicesPerWorker - 1;
+			if (nHelpers > workers.Size()) nHelpers = workers.Size();
+		}
+
+		renderOut = out;
+		renderFrames = nFrames;
+		nRenderVoices = nVoices;
+		nextVoice.store(0, std::memory_order_relaxed);
+
+		if (nHelpers > 0)
+		{
+			workers.Dispatch(RenderShare, this, nHelpers);
+		}
+
+		RenderVoices(0);
+
+		if (nHelpers > 0)
+		{
+			workers.Wait();
+
+			// Sum up what the workers mixed. Done over the plain samples,
+			// which the compiler can vectorize.
+
+			auto dest = &out[0].left;
+			unsigned nSamples = 2 * nFrames * nBuses;
+
+			for (unsigned w = 1; w <= nHelpers; w++)
+			{
+				auto src = &workerMix[w][0].left;
+
+				for (unsigned s = 0; s < nSamples; s++)
+				{
+					dest[s] += src[s];
+				}
+			}
+		}
+
+		// If a drum finished playing, deactivate it in the table. (Only
+		// the audio thread touches the table.)
+
+		for (unsigned k = 0; k < nVoices; k++)
+		{
+			if (polyTable.elems[voiceList[k]].wave.IsFinished())
 			{
-				auto& e = polyTable.elems[i];
-				auto rv = e.wave.StereoTick();
-				left += rv.left * e.gain;   // @@ TODO: l * e.gain?
-				right += rv.right * e.gain;  // @@ TODO: r * e.gain?
+				RetireVoice(voiceList[k]);
 			}
+		}
+	}
+
+	void PolyDrummer::RenderVoices(unsigned worker)
+	{
+		// Render voices off the list till there are none left. The audio
+		// thread (worker 0) mixes right into the output. The others mix
+		// into their own buffers.
+
+		unsigned nFrames = renderFrames;
+		auto dest = renderOut;
+
+		if (worker > 0)
+		{
+			dest = workerMix[worker].data();
+
+			for (unsigned f = 0; f < nFrames * nBuses; f++)
+			{
+				dest[f].left = 0.0;
+				dest[f].right = 0.0;
+			}
+		}
+
+		unsigned k;
 
-			i = nxt;
+		while ((k = nextVoice.fetch_add(1, std::memory_order_relaxed)) < nRenderVoices)
+		{
+			auto& e = polyTable.elems[voiceList[k]];
+
+			MicMix mix;
+			VoiceMix(e, mix);
+			e.render(e.wave, mix, dest + e.bus * nFrames, nFrames);
 		}
+	}
 
-		return { left, right };
+	void PolyDrummer::RenderShare(void* ctx, unsigned worker)
+	{
+		static_cast<PolyDrummer*>(ctx)->RenderVoices(worker);
 	}
 
 }
\ No newline at end of file
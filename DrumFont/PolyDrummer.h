@@ -34,8 +34,11 @@
  *
 \******************************************************************************/
 
+#include <atomic>
+#include <thread>
 #include "PolyTable.h"
 #include "DrumKit.h"
+#include "WorkerPool.h"
 
 namespace dfx
 {
@@ -46,22 +49,151 @@ namespace dfx
 	};
 
 	constexpr int DRUM_POLYPHONY = 16;
+	constexpr int MAX_KITS = 16;  // One per midi channel seems plenty
+	constexpr unsigned MAX_BUSES = 16;  // Stereo output buses
+	constexpr unsigned MAX_BLOCK_FRAMES = 512; // Longest block the render workers help with
+
+	// Kits we've swapped out, but whose voices might still be sounding.
+	// Filled in by the audio thread, emptied by ReapRetiredKits().
+
+	constexpr int MAX_RETIRED_KITS = 4;
+
+	struct RetiredKit
+	{
+		std::atomic<std::shared_ptr<DrumKit>*> kit{ nullptr };
+		std::atomic<unsigned> generation{ 0 };
+	};
+
+	// A kit's mic mixer, for its multi-mic waves: the left and right gains
+	// for each mic (channel) of the waves. Can be changed from any thread
+	// while playing. The audio thread picks up the changes at the next block.
+	// By default, mic 0 goes left, mic 1 goes right, and the rest are off.
+
+	struct MicMixer
+	{
+		std::atomic<double> left[MAX_MICS];
+		std::atomic<double> right[MAX_MICS];
+
+		MicMixer()
+		{
+			for (unsigned m = 0; m < MAX_MICS; m++)
+			{
+				left[m] = m == 0 ? 1.0 : 0.0;
+				right[m] = m == 1 ? 1.0 : 0.0;
+			}
+		}
+	};
+
+	// The kits loaded into the drummer. All kits share the one voice pool,
+	// but each can be capped to a maximum number of voices of its own.
+
+	struct KitSlot
+	{
+		std::shared_ptr<DrumKit> kit;  // Once playing, only the audio thread touches this
+		std::atomic<std::shared_ptr<DrumKit>*> pending{ nullptr };
+		int maxVoices{ 0 };            // 0 means no cap other than the pool size
+		int activeVoices{ 0 };         // Audio thread only
+		MicMixer mics;                 // Stays put when the kit is swapped
+	};
+
+	// Maps a midi channel (1-16, or 0 for any channel), and a range of notes,
+	// to a kit slot. The first route that matches wins.
+
+	struct KitRoute
+	{
+		int channel;
+		int loNote;
+		int hiNote;
+		int kitSlot;
+	};
 
 	class PolyDrummer {
 	public:
 
 		PolyTable polyTable;
-		std::shared_ptr<DrumKit> drumKit;
+		KitSlot kits[MAX_KITS];
+		unsigned kitGeneration;  // Bumped each time we swap in a new kit
+
+		// NOTE: Set up the routes before the audio stream starts. If there
+		// aren't any, everything goes to kit slot 0.
+
+		std::vector<KitRoute> routes;
+
+		// Kit hot swapping. A kit is loaded on some other thread and handed
+		// over through the pending pointer of its slot. The audio thread picks
+		// it up at the top of a block (see BeginBlock()), and the old kit goes
+		// to the retired list. Voices still playing the old kit play on. Once
+		// none are left (oldestLiveGeneration moves past it), ReapRetiredKits()
+		// lets it go, off the audio thread.
+
+		RetiredKit retiredKits[MAX_RETIRED_KITS];
+		std::atomic<unsigned> oldestLiveGeneration;
 
 		bool interrupt_same_note; // If true, only one playback of each note active at a time.
 
+		// The number of stereo output buses rendered. Drums play on the bus
+		// given in the drum font. Those asking for a bus we don't have play
+		// on bus 0, the main one.
+
+		unsigned nBuses;
+
+		// Gain for everything the drummer plays. Like the robins' leveling
+		// gains, it's folded into a voice's gain at note on, so changes
+		// are heard from the next note on.
+
+		double masterGain;
+
+		// Rendering can be shared out to a pool of worker threads. Each block,
+		// the active voices go on a list. The audio thread and the workers
+		// take voices off the list till there are none left, each mixing into
+		// its own buffers. Then the audio thread sums the buffers up. With only
+		// a few voices playing, fewer workers (or none) are woken up.
+
+		WorkerPool workers;
+		unsigned voicesPerWorker;  // Fewest voices worth another worker
+		std::vector<int> voiceList;
+		std::vector<StereoFrame<engine_t>> workerMix[MAX_WORKERS + 1];
+		std::atomic<unsigned> nextVoice;
+		StereoFrame<engine_t>* renderOut;
+		unsigned renderFrames;
+		unsigned nRenderVoices;
+
+		// Real time safety mode. (See EnableRealTime().)
+
+		bool realTime;
+		int rtPriority;
+		int rtCpu;
+		std::atomic<bool> rtThreadPending; // Audio thread goes real time at its next block
+
 	public:
 
 		PolyDrummer(int polyPhony = DRUM_POLYPHONY);
 
 		virtual ~PolyDrummer();
 
-		void UseKit(std::shared_ptr<DrumKit>& drumKit, double systemSampleRate_);;
+		// NOTE: Not thread safe. Use this only before the audio stream starts.
+		// Afterwards, use QueueKit() or LoadKitAsync().
+		// These all return false, and do nothing, if the kit slot is out of range.
+
+		bool UseKit(std::shared_ptr<DrumKit>& drumKit, double systemSampleRate_, int kitSlot = 0);
+
+		bool SetKitPolyphony(int kitSlot, int maxVoices);
+		bool SetMicGain(int kitSlot, unsigned mic, double left, double right);
+		bool AddRoute(int channel, int kitSlot, int loNote = 0, int hiNote = 127);
+		void ClearRoutes();
+		int RouteNote(int channel, int noteNumber) const;
+
+		static bool IsKitSlot(int kitSlot)
+		{
+			return kitSlot >= 0 && kitSlot < MAX_KITS;
+		}
+
+		bool QueueKit(std::shared_ptr<DrumKit> kit_, int kitSlot = 0);
+		std::thread LoadKitAsync(std::shared_ptr<DrumKit> kit_, std::ostream& serr, int kitSlot = 0);
+		int ReapRetiredKits();
+
+		//! Call from the audio thread at the top of each block.
+		void BeginBlock();
 
 		void SetSampleRate(double systemSampleRate_)
 		{
@@ -73,12 +205,33 @@ namespace dfx
 			interrupt_same_note = reuse_flag;
 		}
 
+		// NOTE: Not thread safe. Use this only before the audio stream starts.
+		void SetBusCount(unsigned nBuses_);
+
+		// NOTE: Not thread safe. Use these only when the audio stream isn't running.
+		// The workers are pinned to their own cpus if pin is set. (See WorkerPool.)
+		bool StartWorkers(unsigned nWorkers, bool pin = true);
+		void StopWorkers();
+
+		// NOTE: Not thread safe. Use this only before the audio stream starts.
+		// Locks memory, and prefaults the samples of the kits, now and queued
+		// later. The audio thread (at its first block) and the workers run at
+		// the given real time priority. If cpu isn't -1, the audio thread is
+		// pinned to it. (See RealTime.h)
+		bool EnableRealTime(std::ostream& serr, int priority = 80, int cpu = -1);
+
 		bool HasSoundsToPlay();
 
 		//! Start a note with the given drum type and amplitude.
 
 		void noteOnDirect(int number, int velCode); 
 
+		//! Start a note, with the kit chosen by midi channel and note number.
+		void noteOn(int channel, int number, int velCode);
+
+		//! Start a note from the given kit slot.
+		void noteOnKit(int kitSlot, int number, int velCode);
+
 		//! Start a note with the given drum type and amplitude.
 		//void noteOn(double instrument, double amplitude);
 
@@ -88,7 +241,20 @@ namespace dfx
 		//! Compute and return one output sample.
 		//double tick(unsigned int channel = 0);
 
-		StereoFrame<double> StereoTick();
+		//! Compute one output frame, with all the buses mixed down.
+		StereoFrame<engine_t> StereoTick();
+
+		//! Compute a block of output frames, for each bus. Faster than ticking a frame at a time.
+		//! The buses are one after the other in out, nFrames apiece, so out must hold nFrames * nBuses.
+		void StereoRender(StereoFrame<engine_t>* out, unsigned nFrames);
+
+	protected:
+
+		void RetireVoice(int slot);
+		void VoiceMix(const PolyTableElem& e, MicMix& mix) const;
+		void RenderVoices(unsigned worker);
+		static void RenderShare(void* ctx, unsigned worker);
+		void PublishOldestLiveGeneration();
 
 		//! Fill a channel of the Frame object with computed outputs.
 		//Frame& tick(Frame& frame, unsigned int channel = 0);
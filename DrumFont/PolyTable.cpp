@@ -41,8 +41,14 @@ namespace dfx
 
 	PolyTableElem::PolyTableElem()
 	: wave()
+	, render(ChooseStereoRenderer(wave))
 	//, filter()
 	, gain(1.0)
+	, level(1.0)
+	, panGain(1.0, 1.0)
+	, bus(0)
+	, kitGeneration(0)
+	, kitSlot(0)
 	, soundNumber(0)
 	, younger(-1)
 	, older(-1)
@@ -68,14 +74,17 @@ namespace dfx
 		unsigned nsoundings = static_cast<unsigned>(elems.size());
 
 		// Set up inactive linked list to take up entire table.
-		// Also clear out any resident wave data.
+		// Also let go of any resident wave data. (We don't clear it,
+		// since it's aliased from the robins of a drum kit.)
 
 		for (unsigned i = 0; i < nsoundings; i++)
 		{
 			elems[i].younger = -1;  // Only for active list, which starts out empty
 			elems[i].older = i + 1;
 			elems[i].soundNumber = -1;
-			elems[i].wave.Clear();
+			elems[i].kitGeneration = 0;
+			elems[i].kitSlot = 0;
+			elems[i].wave.ReleaseSamples();
 		}
 
 		// Fixup last inactive older pointer
@@ -207,6 +216,7 @@ namespace dfx
 		for (auto& e : elems)
 		{
 			e.wave.SetRate(sampleRate_);
+			e.render = ChooseStereoRenderer(e.wave);
 		}
 	}
 
@@ -37,6 +37,7 @@
 #include <vector>
 #include <ostream>
 #include "MemWave.h"
+#include "VoiceRender.h"
 //#include "OnePole.h"
 
 namespace dfx
@@ -45,9 +46,16 @@ namespace dfx
 	public:
 
 		MemWave wave;      // resident wave storage
+		StereoRenderFn<engine_t> render; // How to play the wave (chosen at note on)
 		//OnePole filter;  // optional filter 
 
-		double gain;
+		double gain;       // Velocity curve gain, times level
+		double level;      // The robin's leveling gain, times the drummer's master gain
+		StereoFrame<double> panGain; // Left and right, from the drum's pan
+		unsigned bus;                // Which output bus it plays on
+
+		unsigned kitGeneration; // Which kit (see PolyDrummer) the wave came from
+		int kitSlot;            // And which of the PolyDrummer's kit slots
 
 		int soundNumber;  // Used if wanting to reset active wave of same note as new one.
 		int younger;      // (younger) for doubly linked active list
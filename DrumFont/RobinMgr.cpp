@@ -39,7 +39,7 @@ namespace dfx
 {
 	// ////////////////////////////////////////////////////
 
-	Robin::Robin(std::string fileName_, double peak_, double rms_, unsigned start_frame_, unsigned end_frame_)
+	Robin::Robin(std::string fileName_, double peak_, double rms_, unsigned start_frame_, unsigned end_frame_, double weight_)
 	: wave()
 	, fullPath()
 	, fileName(fileName_)
@@ -47,6 +47,8 @@ namespace dfx
 	, rms(rms_)
 	, start_frame(start_frame_)
 	, end_frame(end_frame_)
+	, weight(weight_)
+	, gain(1.0)
 	{
 
 	}
@@ -59,6 +61,8 @@ namespace dfx
 	, rms(other.rms)
 	, start_frame(other.start_frame)
 	, end_frame(other.end_frame)
+	, weight(other.weight)
+	, gain(other.gain)
 	{
 
 	}
@@ -71,12 +75,15 @@ namespace dfx
 	, rms(other.rms)
 	, start_frame(other.start_frame)
 	, end_frame(other.end_frame)
+	, weight(other.weight)
+	, gain(other.gain)
 	{
 		// Just keeping move pedantics :)
 		other.peak = 0;
 		other.rms = 0;
 		other.start_frame = 0;
 		other.end_frame = 0;
+		other.weight = 0;
 	}
 
 
@@ -91,6 +98,8 @@ namespace dfx
 			rms = other.rms;
 			start_frame = other.start_frame;
 			end_frame = other.end_frame;
+			weight = other.weight;
+			gain = other.gain;
 		}
 
 		return *this;
@@ -107,12 +116,15 @@ namespace dfx
 			rms = other.rms;
 			start_frame = other.start_frame;
 			end_frame = other.end_frame;
+			weight = other.weight;
+			gain = other.gain;
 
 			// Just keeping move pedantics :)
 			other.peak = 0;
 			other.rms = 0;
 			other.start_frame = 0;
 			other.end_frame = 0;
+			other.weight = 0;
 		}
 
 		return *this;
@@ -125,7 +137,7 @@ namespace dfx
 		fullPath = fullPath.generic_string();
 	}
 
-	bool Robin::LoadWave(std::ostream &serr)
+	bool Robin::LoadWave(std::ostream &serr, double tail_floor_db)
 	{
 		// NOTE: My jungle drums already have their dynamics tuned
 		// just right. And the robin files are already scaled with
@@ -146,7 +158,11 @@ namespace dfx
 		bool au_naturale = true;  // @@ for now!
 		double scale_factor_code = au_naturale ? 1.0 : 1.0 / peak;
 
-		bool b = wave.Load(fullPath, start_frame, end_frame, scale_factor_code);
+		// The near silent tail gets dropped too. No sense keeping it in memory,
+		// nor mixing it in sample by sample till the voice finishes. The samples
+		// are shared with any other robins using the same wave.
+
+		bool b = wave.LoadShared(fullPath, start_frame, end_frame, scale_factor_code, tail_floor_db);
 		if (!b)
 		{
 			serr << "Error loading file: " << fullPath << std::endl;
@@ -159,7 +175,9 @@ namespace dfx
 
 	RobinMgr::RobinMgr()
 	: robins{}
-	, lastRobinChosen{ 0 }
+	, lastRobinChosen{ NoneChosen }
+	, aliasProb{}
+	, aliasIdx{}
 	{
 	}
 
@@ -167,13 +185,17 @@ namespace dfx
 	{
 		robins = other.robins;
 		lastRobinChosen = other.lastRobinChosen;
+		aliasProb = other.aliasProb;
+		aliasIdx = other.aliasIdx;
 	}
 
 	RobinMgr::RobinMgr(RobinMgr&& other) noexcept
 	{
 		robins = std::move(other.robins);
 		lastRobinChosen = other.lastRobinChosen;
-		other.lastRobinChosen = 0;
+		aliasProb = std::move(other.aliasProb);
+		aliasIdx = std::move(other.aliasIdx);
+		other.lastRobinChosen = NoneChosen;
 	}
 
 	RobinMgr::~RobinMgr()
@@ -186,6 +208,8 @@ namespace dfx
 		{
 			robins = other.robins;
 			lastRobinChosen = other.lastRobinChosen;
+			aliasProb = other.aliasProb;
+			aliasIdx = other.aliasIdx;
 		}
 
 		return *this;
@@ -197,7 +221,9 @@ namespace dfx
 		{
 			robins = std::move(other.robins);
 			lastRobinChosen = other.lastRobinChosen;
-			other.lastRobinChosen = 0;
+			aliasProb = std::move(other.aliasProb);
+			aliasIdx = std::move(other.aliasIdx);
+			other.lastRobinChosen = NoneChosen;
 		}
 
 		return *this;
@@ -211,27 +237,92 @@ namespace dfx
 		}
 	}
 
-	int RobinMgr::LoadWaves(std::ostream &serr)
+	int RobinMgr::LoadWaves(std::ostream &serr, double tail_floor_db)
 	{
 		int errcnt = 0;
 
 		for (auto& r : robins)
 		{
-			bool b = r.LoadWave(serr);
+			bool b = r.LoadWave(serr, tail_floor_db);
 			if (!b)
 			{
 				++errcnt;
 			}
 		}
 
+		// Now's a good time to do this, since we're not on the audio thread
+
+		BuildAliasTable();
+
 		return errcnt;
 	}
 
+	void RobinMgr::BuildAliasTable()
+	{
+		// Vose's alias method. Each slot i holds a probability of keeping i,
+		// and otherwise an alias to hand out instead. A weighted pick is then
+		// just one random slot and one coin flip, no matter how many robins.
+
+		const size_t n = robins.size();
+
+		double total = 0.0;
+
+		for (size_t i = 0; i < n; i++)
+		{
+			if (robins[i].weight > 0.0) total += robins[i].weight;
+		}
+
+		if (total <= 0.0)
+		{
+			// Treat everybody the same (see PickWeighted())
+			aliasProb.clear();
+			aliasIdx.clear();
+			return;
+		}
+
+		aliasProb.assign(n, 1.0);
+		aliasIdx.resize(n);
+
+		for (size_t i = 0; i < n; i++)
+		{
+			aliasIdx[i] = i;
+		}
+
+		std::vector<double> scaled(n);
+		std::vector<size_t> small;
+		std::vector<size_t> large;
+
+		for (size_t i = 0; i < n; i++)
+		{
+			auto w = robins[i].weight > 0.0 ? robins[i].weight : 0.0;
+			scaled[i] = w * n / total;
+			if (scaled[i] < 1.0) small.push_back(i); else large.push_back(i);
+		}
+
+		while (!small.empty() && !large.empty())
+		{
+			auto s = small.back(); small.pop_back();
+			auto l = large.back(); large.pop_back();
+
+			aliasProb[s] = scaled[s];
+			aliasIdx[s] = l;
+
+			scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+			if (scaled[l] < 1.0) small.push_back(l); else large.push_back(l);
+		}
+
+		// Whatever's left over is (within round off) a sure thing. Except
+		// for robins with no weight, which must never come up.
+
+		for (auto i : small) aliasProb[i] = scaled[i] > 0.0 ? 1.0 : 0.0;
+		for (auto i : large) aliasProb[i] = 1.0;
+	}
+
 	// Using simple round robin for now
 
 	Robin& RobinMgr::ChooseRobin()
 	{
-		++lastRobinChosen;
+		++lastRobinChosen; // NoneChosen wraps around to the first one
 
 		if (lastRobinChosen >= robins.size())
 		{
@@ -241,10 +332,117 @@ namespace dfx
 		return robins[lastRobinChosen];
 	}
 
+	size_t RobinMgr::PickRandomNoRepeat(XorShiftRng& rng)
+	{
+		// Pick among all but the last one chosen, then shift the pick
+		// past it. Never repeats, and always takes just one draw.
+
+		const auto n = static_cast<unsigned>(robins.size());
+
+		if (n < 2)
+		{
+			return 0;
+		}
+
+		if (lastRobinChosen >= n)
+		{
+			return rng.Below(n); // First pick, so anybody goes
+		}
+
+		size_t r = rng.Below(n - 1);
+
+		if (r >= lastRobinChosen)
+		{
+			++r;
+		}
+
+		return r;
+	}
+
+	size_t RobinMgr::PickWeighted(XorShiftRng& rng)
+	{
+		const auto n = static_cast<unsigned>(robins.size());
+
+		if (n < 2)
+		{
+			return 0;
+		}
+
+		if (aliasIdx.size() != n)
+		{
+			// No weights to go by, or the alias table never got built
+			// (waves not loaded through us?)
+			return PickRandomNoRepeat(rng);
+		}
+
+		// Don't repeat. Drawing again when we do keeps the odds true to
+		// the weights of the others. Zero weight robins never come up in
+		// a draw. The number of draws is capped, to keep the time bounded
+		// on the audio thread.
+
+		static constexpr int MaxDraws = 8;
+
+		for (int i = 0; i < MaxDraws; i++)
+		{
+			size_t r = rng.Below(n);
+
+			if (rng.Uniform() >= aliasProb[r])
+			{
+				r = aliasIdx[r];
+			}
+
+			if (r != lastRobinChosen && robins[r].weight > 0.0)
+			{
+				return r;
+			}
+		}
+
+		// Very unlikely, unless the last one has nearly all the weight.
+		// Take the next one that has some, or else repeat after all.
+
+		size_t last = lastRobinChosen < n ? lastRobinChosen : n - 1;
+
+		for (size_t i = 1; i <= n; i++)
+		{
+			auto r = (last + i) % n;
+
+			if (r != lastRobinChosen && robins[r].weight > 0.0)
+			{
+				return r;
+			}
+		}
+
+		return last;
+	}
+
+	Robin& RobinMgr::ChooseRobin(RobinStrategy strategy, XorShiftRng& rng)
+	{
+		switch (strategy)
+		{
+			case RobinStrategy::RandomNoRepeat:
+			case RobinStrategy::VelocityJittered:
+				lastRobinChosen = PickRandomNoRepeat(rng);
+			break;
+			case RobinStrategy::Weighted:
+				lastRobinChosen = PickWeighted(rng);
+			break;
+			default:
+				return ChooseRobin();
+		}
+
+		return robins[lastRobinChosen];
+	}
+
 	MemWave& RobinMgr::ChooseWave()
 	{
 		auto& robin = ChooseRobin();
 		return robin.wave;
 	}
 
+	MemWave& RobinMgr::ChooseWave(RobinStrategy strategy, XorShiftRng& rng)
+	{
+		auto& robin = ChooseRobin(strategy, rng);
+		return robin.wave;
+	}
+
 } // end of namespace
\ No newline at end of file
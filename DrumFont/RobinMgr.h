@@ -36,8 +36,10 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
 #include <filesystem>
 #include "MemWave.h"
+#include "XorShift.h"
 
 namespace dfx
 {
@@ -48,12 +50,14 @@ namespace dfx
 
 		std::filesystem::path fullPath;
 		std::filesystem::path fileName;
-		double peak; // In db, as given in the drum font
-		double rms;  // In db, as given in the drum font
+		double peak; // As given in the drum font (in dB or as a ratio), made linear
+		double rms;  // Ditto
 		unsigned start_frame; // in frames, as given in the drum font
 		unsigned end_frame;   // in frames
+		double weight;        // Relative odds of being chosen, for weighted selection
+		double gain;          // Leveling gain, from the peak or rms (see DrumKit::FinishLevels())
 
-		Robin(std::string fileName_, double peak_, double rms_, unsigned start_frame_, unsigned end_frame_);
+		Robin(std::string fileName_, double peak_, double rms_, unsigned start_frame_, unsigned end_frame_, double weight_ = 1.0);
 		Robin(const Robin& other);
 		Robin(Robin&& other) noexcept;
 
@@ -62,16 +66,38 @@ namespace dfx
 
 		void FinishPaths(std::filesystem::path& cumulativePath_);
 
-		bool LoadWave(std::ostream &serr);
+		bool LoadWave(std::ostream &serr, double tail_floor_db = DefaultTailFloor_dB);
 	};
 
 
+	// How a robin gets chosen from a velocity layer. Cycle is the plain old
+	// round robin. The others draw on a random number generator owned by the
+	// drum. VelocityJittered also nudges the velocity a bit before picking the
+	// layer (that's done up in the drum), then picks as RandomNoRepeat does.
+
+	enum class RobinStrategy
+	{
+		Cycle,
+		RandomNoRepeat,
+		Weighted,
+		VelocityJittered
+	};
+
 	class RobinMgr {
 	public:
 
+		static constexpr size_t NoneChosen = SIZE_MAX; // Before the first pick
+
 		std::vector<Robin> robins;
 		size_t lastRobinChosen;
 
+		// Alias tables (Vose's method) for O(1) weighted picks.
+		// Built at load time from the robin weights. Left empty
+		// if none of the robins have any weight.
+
+		std::vector<double> aliasProb;
+		std::vector<size_t> aliasIdx;
+
 	public:
 
 		RobinMgr();
@@ -84,11 +110,20 @@ namespace dfx
 
 		void FinishPaths(std::filesystem::path& cumulativePath_);
 
-		int LoadWaves(std::ostream &serr);
+		int LoadWaves(std::ostream &serr, double tail_floor_db = DefaultTailFloor_dB);
+
+		void BuildAliasTable();
 
 		Robin& ChooseRobin(); // Lower level
+		Robin& ChooseRobin(RobinStrategy strategy, XorShiftRng& rng);
 
 		MemWave& ChooseWave(); // What will be used most of the time.
+		MemWave& ChooseWave(RobinStrategy strategy, XorShiftRng& rng);
+
+	protected:
+
+		size_t PickRandomNoRepeat(XorShiftRng& rng);
+		size_t PickWeighted(XorShiftRng& rng);
 	};
 
 } // end of namespace
\ No newline at end of file
@@ -133,9 +133,9 @@ namespace dfx
 		robinMgr.FinishPaths(cumulativePath);
 	}
 
-	bool VelocityLayer::LoadWaves(std::ostream &serr)
+	bool VelocityLayer::LoadWaves(std::ostream &serr, double tail_floor_db)
 	{
-		return robinMgr.LoadWaves(serr);
+		return robinMgr.LoadWaves(serr, tail_floor_db);
 	}
 
 } // end of namespace
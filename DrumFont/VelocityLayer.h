@@ -83,7 +83,7 @@ namespace dfx
 
 		void FinishPaths(std::filesystem::path& cumulativePath_);
 
-		bool LoadWaves(std::ostream &serr);
+		bool LoadWaves(std::ostream &serr, double tail_floor_db = DefaultTailFloor_dB);
 
 	};
 
@@ -43,6 +43,7 @@ void test()
 {
 	//std::string_view filename = "../TestFiles/Test1.dfx";
 	std::string_view filename = "../TestFiles/Test2.dfx";
+	//std::string_view filename = "../TestFiles/VelocityCurves.dfx";
 	//std::string_view filename = "../TestFiles/TestKitWIncludes.dfx";
 	//std::string_view filename = "../TestFiles/Tabla.dfx";
 
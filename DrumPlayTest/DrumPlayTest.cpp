@@ -34,8 +34,11 @@
 
 #include "DrumFont.h"
 #include "PolyDrummer.h"
+#include "KitReloader.h"
 #include "DfxMidi.h"
 #include "DfxAudio.h"
+#include "SampleCache.h"
+#include "RealTime.h"
 #include <iostream>
 
 using namespace dfx;
@@ -67,7 +70,7 @@ int ProcessMidi(DfxMidi* midi_input, PolyDrummer* poly_drummer)
 		if (tag == NoteOnMessage::tag)
 		{
 			auto n_on = midi_input->ParseNoteOn(*m);
-			poly_drummer->noteOnDirect(n_on->note, n_on->velocity); // / 127.0);
+			poly_drummer->noteOn(n_on->channel, n_on->note, n_on->velocity); // / 127.0);
 			//std::cout << '+' << std::flush;
 			std::cout << int(n_on->velocity) << ' ' << std::flush;
 		}
@@ -76,7 +79,7 @@ int ProcessMidi(DfxMidi* midi_input, PolyDrummer* poly_drummer)
 	return 0;
 }
 
-int DrumsPlayBack(void* outBuff, void* inBuff, unsigned nFrames, double streamTime, StreamIOStatus ioStatus, void* userData)
+int DrumsPlayBack(PlaySink& sink, void* inBuff, unsigned nFrames, double streamTime, StreamIOStatus ioStatus, void* userData)
 {
 	// A callback function that plays back a buffer's worth of whatever sounds are active in our polyphonic drumkit
 
@@ -85,7 +88,14 @@ int DrumsPlayBack(void* outBuff, void* inBuff, unsigned nFrames, double streamTi
 	// We don't use streamTime here. Instead, the PolyDrummer object keeps track of each drum that
 	// is being played.
 
-	auto p = reinterpret_cast<system_t*>(outBuff);
+	// Anything in here that allocates, frees or locks gets caught. (In builds with DFX_RT_CHECK.)
+
+	RtAudioScope rt_scope;
+
+	// We render a chunk at a time into a small buffer on the stack, and write
+	// it through the sink straight into the device's channel buffers.
+
+	unsigned frame = 0;
 
 	auto playbackData = reinterpret_cast<PlaybackData*>(userData);
 	auto midi_input = playbackData->midi_input;
@@ -101,6 +111,14 @@ int DrumsPlayBack(void* outBuff, void* inBuff, unsigned nFrames, double streamTi
 
 	static constexpr unsigned outer_loop_chunk = 16;
 
+	// A block boundary is where we pick up any newly loaded kit
+
+	poly_drummer->BeginBlock();
+
+	// Each bus goes out on its own pair of device channels, bus 0 on the first pair
+
+	const unsigned nBuses = poly_drummer->nBuses;
+
 	if (poly_drummer->HasSoundsToPlay())
 	{
 		while (nFrames > 0)
@@ -111,19 +129,20 @@ int DrumsPlayBack(void* outBuff, void* inBuff, unsigned nFrames, double streamTi
 			auto num_to_do = outer_loop_chunk <= nFrames ? outer_loop_chunk : nFrames;
 			nFrames -= num_to_do;
 
-			// inner loop
+			// NOTE: We are rendering at the playback sampling rate, which may not
+			// be the sampling rate of the recorded file. So the drummer might
+			// have to calculate interpolated frames.
 
-			while (num_to_do > 0)
+			StereoFrame<engine_t> chunk[outer_loop_chunk * MAX_BUSES];
+			poly_drummer->StereoRender(chunk, num_to_do);
+
+			for (unsigned b = 0; b < nBuses; b++)
 			{
-				// NOTE: We are ticking at the playback sampling rate, which may not
-				// be the sampling rate of the recorded file. So the tick function
-				// below might have to calculate an interpolated frame.
-				auto sf = poly_drummer->StereoTick();
-				// @@ TODO: Apply volume gain from midi volume control or gui control or whatever.
-				*p++ = sf.left * 0.5;   // @@ TEMP KLUDGE: Apply -6dB of gain to alleviate clipping
-				*p++ = sf.right * 0.5;  // @@ TEMP KLUDGE: Apply -6DB of gain to alleviate clipping
-				--num_to_do;
+				sink.Write(2 * b, frame, &chunk[b * num_to_do].left, num_to_do, 2);
+				sink.Write(2 * b + 1, frame, &chunk[b * num_to_do].right, num_to_do, 2);
 			}
+
+			frame += num_to_do;
 		}
 	}
 	else
@@ -138,14 +157,10 @@ int DrumsPlayBack(void* outBuff, void* inBuff, unsigned nFrames, double streamTi
 			auto num_to_do = outer_loop_chunk <= nFrames ? outer_loop_chunk : nFrames;
 			nFrames -= num_to_do;
 
-			// Play silence in inner  loop
+			// Play silence
 
-			while (num_to_do > 0)
-			{
-				*p++ = 0;
-				*p++ = 0;
-				--num_to_do;
-			}
+			sink.Clear(frame, num_to_do);
+			frame += num_to_do;
 		}
 	}
 
@@ -186,7 +201,11 @@ int main()
 	}
 
 	//
-	// Load the drum font file (and verify it and build drum kit)
+	// Load the drum font file (and verify it and build drum kit), and
+	// load all the corresponding wave samples for the drum font into
+	// memory. The first time, this might take a while. After that, we
+	// load the compiled version of the font (.dfxc) instead, unless
+	// the font or any of its files have changed.
 	//
 
 	//std::string_view dfxile = "../TestFiles/TestKit.dfx";
@@ -199,39 +218,94 @@ int main()
 
 	// @@ TODO: Error handling still a jumbled mess.
 
-	auto result = df->LoadFile(std::cout, dfxFile);
+	std::cout << "Loading drum font and its wave files. This may take awhile ..." << std::endl;
+
+	auto result = df->LoadCompiled(std::cout, dfxFile);
 	if (result != DfxResult::NoError)
 	{
-		// Error message already printed to std::cout
+		// Error messages already printed to std::cout
+		std::cout << "Stopping due to drum font loading error(s)." << std::endl;
 		return -1;
 	}
 
+	SampleCache::Instance().DumpStats(std::cout);
+
 	//
-	// Load all the corresponding wave samples for the drum 
-	// font into memory. This might take a while.
+	// Setup up our polyphonic drum player
 	//
 
-	std::cout << "Loading all drum font wave files. This may take awhile ..." << std::endl;
+	auto polyDrummer = std::make_shared<PolyDrummer>();
+
+	// The drum font can store multiple kits. We give each one its own
+	// midi channel, in the order found, starting with channel 1. If
+	// there's just the one kit, it plays on any channel.
 
-	int errcnt = df->drumKits[0]->LoadWaves(std::cout);
+	int nkits = static_cast<int>(df->drumKits.size());
 
-	if (errcnt != 0)
+	if (nkits > MAX_KITS)
 	{
-		// Note: individual error messages already printed out
-		std::cout << "Stopping due to " << errcnt << " file loading error(s)." << std::endl;
-		return -1;
+		std::cout << "Only using the first " << MAX_KITS << " of " << nkits << " kits." << std::endl;
+		nkits = MAX_KITS;
 	}
 
-	//
-	// Setup up our polyphonic drum player
-	//
+	for (int i = 0; i < nkits; i++)
+	{
+		polyDrummer->UseKit(df->drumKits[i], systemSampleRate, i);
 
-	auto polyDrummer = std::make_shared<PolyDrummer>();
+		if (nkits > 1)
+		{
+			polyDrummer->AddRoute(i + 1, i);
+			std::cout << "Kit " << df->drumKits[i]->name << " is on midi channel " << i + 1 << std::endl;
+		}
+	}
 
-	// The drum font can store multiple kits, but for now we're
-	// only going to use the first one we find.
+	// While we play, edits to the font file or its include files get
+	// picked up and swapped in, without reloading the waves that didn't
+	// change.
 
-	polyDrummer->UseKit(df->drumKits[0], systemSampleRate);
+	// One stereo bus for each bus the drums play on
+
+	unsigned nBuses = 1;
+
+	for (int i = 0; i < nkits; i++)
+	{
+		for (auto& drum : df->drumKits[i]->drums)
+		{
+			if (drum->bus >= 0 && static_cast<unsigned>(drum->bus) >= nBuses)
+			{
+				nBuses = drum->bus + 1;
+			}
+		}
+	}
+
+	polyDrummer->SetBusCount(nBuses);
+
+	// -6 dB of headroom, to keep stacked hits from clipping. It's folded
+	// into each note's gain at note on, rather than scaling every frame.
+	// @@ TODO: Drive this from midi volume control or gui control or whatever.
+
+	polyDrummer->masterGain = 0.5;
+
+	// No page faults, and real time priority, for the audio thread (and the workers)
+
+	polyDrummer->EnableRealTime(std::cout);
+
+	// When lots of drums are playing at once, the other cpus help render them
+
+	unsigned nCpus = std::thread::hardware_concurrency();
+
+	if (nCpus > 1)
+	{
+		polyDrummer->StartWorkers(nCpus - 1);
+		std::cout << "Rendering with up to " << polyDrummer->workers.Size() + 1 << " threads" << std::endl;
+	}
+
+	if (nBuses > 1)
+	{
+		std::cout << "Playing on " << polyDrummer->nBuses << " stereo buses" << std::endl;
+	}
+
+	KitReloader reloader(polyDrummer, dfxFile, df->drumKits);
 
 	auto playbackData = std::make_unique<PlaybackData>(inMidi, polyDrummer);
 
@@ -250,13 +324,13 @@ int main()
 		return 0;
 	}
 
-	da->ConfigureUserCallback(DrumsPlayBack);
+	da->ConfigureSinkCallback(DrumsPlayBack);
 
 	// Start playback audio stream
-	// 0 ins, 2 outs (aka stereo)
+	// 0 ins, 2 outs per bus (aka stereo)
 	// 64 sample buffers (nominal)
 
-	b = da->Open(0, 2, 64, systemSampleRate, playbackData.get(), verbose);
+	b = da->Open(0, 2 * polyDrummer->nBuses, 64, systemSampleRate, playbackData.get(), verbose);
 
 	auto start = std::chrono::high_resolution_clock::now();
 
@@ -273,13 +347,21 @@ int main()
 		std::cout << "\nAudio session started successfully.\n" << std::endl;
 
 		// We let the ASIO driver run the show now, until we receive a signal
-		// to stop. All we have to do here is wait for the signal.
-		// @@TODO: Make this more efficient than polling. Perhaps arrange a
-		// wait for object here.
+		// to stop. All we have to do here is wait for the signal. We sleep
+		// while waiting, waking up now and then to do some housekeeping.
 
-		while (!da->Stopped())
+		while (!da->WaitForStop(std::chrono::milliseconds(100)))
 		{
 			//fprintf(stdout, "%lf stream time\n", am.getStreamTime());
+
+			// Let go of any swapped out kits that have finished sounding
+			polyDrummer->ReapRetiredKits();
+
+			// Swap in any kits whose files have been edited
+			reloader.Poll(std::cout);
+
+			// Let us know if the audio thread did anything it shouldn't
+			RtCheckReport(std::cout);
 		}
 
 		auto finish = std::chrono::high_resolution_clock::now();
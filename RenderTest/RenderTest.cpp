@@ -0,0 +1,223 @@
+/******************************************************************************\
+ * DFX - "Drum font exchange format" - source code
+ *
+ * Copyright (c) 2020 by Bryan Flamig
+ *
+ * This software helps facilitate the real-time playing of multi-layered drum
+ * samples, by implementing a language that specifies a master directory of the
+ * the sample wave files for a drum kit: where the samples are, what they are
+ * for, and a summary of their properties. The DFX format allows modifications
+ * of sample levels to achieve a unified, pleasing mix of sounds. Mechanisms
+ * such as velocity layers and round robins are supported for this purpose.
+ *
+ * This exchange format has a one to one mapping to the widely used Json syntax,
+ * simplified to be easier to read and write. It is easy to translate DFX files
+ * into Json files that can be parsed by any software supporting Json syntax.
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+// A regression test for the engine's sample type. We render the same voices
+// mixing in float and in double, and check the two agree to within a small
+// tolerance. The voices cover each channel layout (mono, stereo and multi-mic),
+// played at the data rate and at other rates (interpolated), several at once
+// into the same block, just like the drummer does it.
+//
+// Returns 0 if all the renders agree, 1 if not.
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "MemWave.h"
+#include "VoiceRender.h"
+
+using namespace dfx;
+
+// Largest difference allowed between the float and double mixes, full scale
+// being 1.0. That's about -100 dBFS, well under what a 24 bit device resolves
+// above its noise floor, but well over float round off for a handful of voices.
+
+static constexpr double tolerance = 1e-5;
+
+static constexpr unsigned block_size = 64;
+
+struct Voice
+{
+	MemWave wave;
+	MicMix mix;
+};
+
+void MakeSamples(MemWave& src, unsigned nFrames, unsigned nChannels, double dataRate, unsigned seed)
+{
+	// Something like a decaying drum hit: a couple of partials and some noise
+
+	src.buff.Resize(nFrames, nChannels);
+	src.buff.dataRate = dataRate;
+
+	unsigned noise = seed * 2654435761u + 1;
+
+	for (unsigned i = 0; i < nFrames; i++)
+	{
+		double env = std::exp(-4.0 * i / nFrames);
+
+		for (unsigned c = 0; c < nChannels; c++)
+		{
+			noise = noise * 1664525u + 1013904223u;
+			double n = (noise >> 8) / double(1 << 24) - 0.5;
+			double x = 0.6 * std::sin(i * (0.05 + 0.01 * c + 0.003 * seed)) + 0.3 * std::sin(i * 0.31) + 0.2 * n;
+			src.buff.samples[i * nChannels + c] = env * x;
+		}
+	}
+}
+
+MicMix MakeMix(unsigned nChannels, double pan)
+{
+	MicMix mix;
+
+	if (nChannels <= 2)
+	{
+		auto g = PanGains(pan, nChannels);
+		mix.nMics = nChannels;
+		mix.mic[0] = 0;
+		mix.mic[1] = 1;
+		mix.gain[0] = g;
+		mix.gain[1] = g;
+	}
+	else
+	{
+		// Spread the mics across the stereo field
+
+		mix.nMics = nChannels;
+
+		for (unsigned m = 0; m < nChannels; m++)
+		{
+			double p = -1.0 + 2.0 * m / (nChannels - 1);
+			mix.mic[m] = m;
+			mix.gain[m] = { 0.5 * (1.0 - p), 0.5 * (1.0 + p) };
+		}
+	}
+
+	return mix;
+}
+
+template<typename M>
+std::vector<StereoFrame<double>> RenderMix(std::vector<Voice>& voices)
+{
+	// Render all the voices together, a block at a time, mixing in M
+
+	std::vector<StereoFrame<double>> result;
+
+	for (auto& v : voices)
+	{
+		v.wave.Reset();
+	}
+
+	bool playing = true;
+
+	while (playing)
+	{
+		StereoFrame<M> block[block_size];
+		playing = false;
+
+		for (auto& v : voices)
+		{
+			if (!v.wave.IsFinished())
+			{
+				auto render = ChooseStereoRenderer<M>(v.wave);
+				render(v.wave, v.mix, block, block_size);
+				playing = true;
+			}
+		}
+
+		for (auto& f : block)
+		{
+			result.emplace_back(f.left, f.right);
+		}
+	}
+
+	return result;
+}
+
+bool Compare(const char* what, std::vector<Voice>& voices)
+{
+	auto d = RenderMix<double>(voices);
+	auto f = RenderMix<float>(voices);
+
+	double maxDiff = 0.0;
+	double peak = 0.0;
+
+	for (size_t i = 0; i < d.size() && i < f.size(); i++)
+	{
+		maxDiff = std::max({ maxDiff, std::abs(d[i].left - f[i].left), std::abs(d[i].right - f[i].right) });
+		peak = std::max({ peak, std::abs(d[i].left), std::abs(d[i].right) });
+	}
+
+	bool ok = d.size() == f.size() && maxDiff <= tolerance;
+
+	std::cout << (ok ? "ok   " : "FAIL ") << what << ": " << d.size() << " frames, peak " << peak
+		<< ", max diff " << maxDiff << " (" << 20.0 * std::log10(maxDiff > 0.0 ? maxDiff : 1e-20) << " dBFS)" << std::endl;
+
+	return ok;
+}
+
+int main()
+{
+	int nFailed = 0;
+
+	MemWave mono, stereo, multi;
+	MakeSamples(mono, 20000, 1, 48000, 1);
+	MakeSamples(stereo, 15000, 2, 44100, 2);
+	MakeSamples(multi, 12000, 5, 48000, 3);
+
+	for (double rate : { 48000.0, 44100.0, 96000.0 })
+	{
+		std::vector<Voice> voices(3);
+
+		voices[0].wave.SetRate(rate);
+		voices[0].wave.AliasSamples(mono);
+		voices[0].mix = MakeMix(1, -0.3);
+
+		voices[1].wave.SetRate(rate);
+		voices[1].wave.AliasSamples(stereo);
+		voices[1].mix = MakeMix(2, 0.5);
+
+		voices[2].wave.SetRate(rate);
+		voices[2].wave.AliasSamples(multi);
+		voices[2].mix = MakeMix(5, 0.0);
+
+		for (unsigned v = 0; v < voices.size(); v++)
+		{
+			std::vector<Voice> one(1);
+			one[0].wave.SetRate(rate);
+			one[0].wave.AliasSamples(v == 0 ? mono : v == 1 ? stereo : multi);
+			one[0].mix = voices[v].mix;
+
+			std::string what = std::string(v == 0 ? "mono" : v == 1 ? "stereo" : "multi-mic") + " at " + std::to_string(int(rate));
+			if (!Compare(what.c_str(), one)) ++nFailed;
+		}
+
+		std::string what = "all three mixed at " + std::to_string(int(rate));
+		if (!Compare(what.c_str(), voices)) ++nFailed;
+	}
+
+	std::cout << (nFailed ? "Float and double renders differ" : "Float and double renders agree") << std::endl;
+
+	return nFailed ? 1 : 0;
+}
@@ -314,7 +314,7 @@ void testbiggie()
 
 	if (np)
 	{
-		std::cout << np->engr_num << std::endl;
+		std::cout << np->Engr() << std::endl;
 	}
 	else
 	{
@@ -340,7 +340,7 @@ void testdb()
 
 	if (np)
 	{
-		std::cout << np->engr_num << std::endl;
+		std::cout << np->Engr() << std::endl;
 	}
 	else
 	{
@@ -360,7 +360,7 @@ void testpfx()
 
 	if (np)
 	{
-		std::cout << np->engr_num << std::endl;
+		std::cout << np->Engr() << std::endl;
 	}
 	else
 	{